@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <argparse/argparse.hpp>
+
+#include "snapshot.hpp"
+
+using namespace heapdiff;
+
+struct TypeStats {
+    size_t count = 0;
+    size_t shallow = 0;
+    size_t retained = 0;
+};
+
+template<typename T>
+static vector<std::pair<string, T>> top_entries(const std::map<string, T> &stats, size_t top,
+                                                const std::function<int64_t(const T &)> &key) {
+    vector<std::pair<string, T>> sorted(stats.begin(), stats.end());
+    std::sort(sorted.begin(), sorted.end(), [&](const auto &lhs, const auto &rhs) { return key(lhs.second) > key(rhs.second); });
+    if (sorted.size() > top)
+        sorted.resize(top);
+    return sorted;
+}
+
+static std::map<string, TypeStats> type_stats(const Snapshot &snapshot) {
+    std::map<string, TypeStats> stats;
+    const auto &objects = snapshot.get_objects();
+    for (size_t i = 0; i < objects.size(); i++) {
+        auto &stat = stats[objects[i].type];
+        stat.count++;
+        stat.shallow += objects[i].size;
+        // Do not count the objects retained by an object of the same type twice
+        if (const auto idom = snapshot.get_idom(i); idom == Snapshot::ROOT || objects[idom].type != objects[i].type)
+            stat.retained += snapshot.get_retained(i);
+    }
+    return stats;
+}
+
+static void summary(const Snapshot &snapshot, size_t top) {
+    const auto &objects = snapshot.get_objects();
+    size_t total = 0;
+    for (const auto &object: objects) total += object.size;
+    std::cout << std::format("{} objects, {} bytes, {} roots\n\n", objects.size(), total, snapshot.get_roots().size());
+
+    std::cout << std::format("{:>10} {:>14} {:>14}  {}\n", "count", "shallow", "retained", "type");
+    for (const auto &[type, stat]: top_entries<TypeStats>(type_stats(snapshot), top, [](const TypeStats &s) { return s.retained; }))
+        std::cout << std::format("{:>10} {:>14} {:>14}  {}\n", stat.count, stat.shallow, stat.retained, type);
+
+    vector<size_t> indices(objects.size());
+    for (size_t i = 0; i < indices.size(); i++) indices[i] = i;
+    std::sort(indices.begin(), indices.end(), [&](size_t lhs, size_t rhs) { return snapshot.get_retained(lhs) > snapshot.get_retained(rhs); });
+    if (indices.size() > top)
+        indices.resize(top);
+
+    std::cout << std::format("\n{:>14}  {:<20} {}\n", "retained", "id", "type");
+    for (const auto i: indices) std::cout << std::format("{:>14}  {:<20} {}\n", snapshot.get_retained(i), objects[i].id, objects[i].type);
+}
+
+static void retainers(const Snapshot &snapshot, const string &type, size_t top) {
+    struct RetainerStats {
+        size_t count = 0;
+        size_t retained = 0;
+        /// A sample path of dominators from the retainer to the roots
+        string path;
+    };
+
+    // Walk up the dominator tree until an object of another type is found,
+    // that object is the one which keeps the objects of the given type alive
+    std::map<string, RetainerStats> stats;
+    const auto &objects = snapshot.get_objects();
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i].type != type)
+            continue;
+        size_t retainer = snapshot.get_idom(i);
+        while (retainer != Snapshot::ROOT && objects[retainer].type == type) retainer = snapshot.get_idom(retainer);
+
+        auto &stat = stats[retainer == Snapshot::ROOT ? "<root>" : objects[retainer].type];
+        stat.count++;
+        stat.retained += snapshot.get_retained(i);
+        if (stat.path.empty()) {
+            stat.path = type;
+            for (auto j = retainer; j != Snapshot::ROOT; j = snapshot.get_idom(j)) stat.path += " <- " + objects[j].type;
+            stat.path += " <- <root>";
+        }
+    }
+
+    std::cout << std::format("{:>10} {:>14}  {}\n", "count", "retained", "retainer");
+    for (const auto &[retainer, stat]:
+         top_entries<RetainerStats>(stats, top, [](const RetainerStats &s) { return s.retained; })) {
+        std::cout << std::format("{:>10} {:>14}  {}\n", stat.count, stat.retained, retainer);
+        std::cout << std::format("{:>26}{}\n", "", stat.path);
+    }
+}
+
+static void diff(const Snapshot &before, const Snapshot &after, size_t top) {
+    struct DiffStats {
+        int64_t count = 0;
+        int64_t shallow = 0;
+        int64_t retained = 0;
+    };
+
+    std::map<string, DiffStats> stats;
+    for (const auto &[type, stat]: type_stats(before)) {
+        auto &diff = stats[type];
+        diff.count -= stat.count;
+        diff.shallow -= stat.shallow;
+        diff.retained -= stat.retained;
+    }
+    for (const auto &[type, stat]: type_stats(after)) {
+        auto &diff = stats[type];
+        diff.count += stat.count;
+        diff.shallow += stat.shallow;
+        diff.retained += stat.retained;
+    }
+
+    std::cout << std::format("{:>10} {:>14} {:>14}  {}\n", "count", "shallow", "retained", "type");
+    for (const auto &[type, stat]: top_entries<DiffStats>(stats, top, [](const DiffStats &s) { return std::abs(s.shallow); })) {
+        if (stat.count == 0 && stat.shallow == 0)
+            continue;
+        std::cout << std::format("{:>+10} {:>+14} {:>+14}  {}\n", stat.count, stat.shallow, stat.retained, type);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser program("heapdiff");
+    program.add_description("Analyzes heap snapshots written by swan.\n"
+                            "  summary <snapshot>           shows the types and objects retaining the most memory\n"
+                            "  retainers <snapshot> -t TYPE shows what retains the objects of TYPE\n"
+                            "  diff <before> <after>        shows the growth of each type between two snapshots");
+    program.add_argument("command").help("specifies the analysis: summary, retainers or diff");
+    program.add_argument("snapshots").required().nargs(1, 2);
+    program.add_argument("-t", "--type").help("specifies the type for retainers").metavar("TYPE").default_value("");
+    program.add_argument("-n", "--top").help("specifies the number of entries shown").metavar("N").default_value(20).scan<'i', int>();
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return 1;
+    }
+
+    const auto command = program.get("command");
+    const auto paths = program.get<vector<string>>("snapshots");
+    const auto top = static_cast<size_t>(std::max(program.get<int>("--top"), 0));
+    try {
+        if (command == "summary") {
+            summary(Snapshot::read(paths[0]), top);
+        } else if (command == "retainers") {
+            if (program.get("--type").empty()) {
+                std::cerr << "retainers requires a type" << std::endl;
+                return 1;
+            }
+            retainers(Snapshot::read(paths[0]), program.get("--type"), top);
+        } else if (command == "diff") {
+            if (paths.size() != 2) {
+                std::cerr << "diff requires two snapshots" << std::endl;
+                return 1;
+            }
+            diff(Snapshot::read(paths[0]), Snapshot::read(paths[1]), top);
+        } else {
+            std::cerr << std::format("unknown command: {}", command) << std::endl;
+            std::cerr << program;
+            return 1;
+        }
+    } catch (const SpadeError &err) {
+        std::cerr << std::format("error occurred:\n    {}: {}\n", cpp_demangle(typeid(err).name()), err.what());
+        return 1;
+    }
+    return 0;
+}
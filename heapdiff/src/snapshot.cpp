@@ -0,0 +1,147 @@
+#include "snapshot.hpp"
+#include <fstream>
+#include <sstream>
+
+namespace heapdiff
+{
+    static constexpr const char *MAGIC = "swan-heap-snapshot";
+    static constexpr const int VERSION = 2;
+
+    Snapshot Snapshot::read(const fs::path &path) {
+        std::ifstream in(path);
+        if (!in)
+            throw FileNotFoundError(path.string());
+
+        string magic;
+        int version;
+        if (!(in >> magic >> version) || magic != MAGIC || version != VERSION)
+            throw CorruptFileError(path.string());
+
+        Snapshot snapshot;
+        std::unordered_map<string, size_t> indices;
+        vector<vector<string>> ref_ids;
+        vector<string> root_ids;
+
+        string line;
+        while (std::getline(in, line)) {
+            std::istringstream ss(line);
+            string record;
+            if (!(ss >> record))
+                continue;
+            if (record == "obj") {
+                Object object;
+                size_t ref_count;
+                if (!(ss >> object.id >> object.kind >> object.size >> ref_count))
+                    throw CorruptFileError(path.string());
+                vector<string> refs(ref_count);
+                for (auto &ref: refs)
+                    if (!(ss >> ref))
+                        throw CorruptFileError(path.string());
+                // The type takes the rest of the line, since a signature can contain spaces
+                if (!std::getline(ss >> std::ws, object.type) || object.type.empty())
+                    throw CorruptFileError(path.string());
+                indices[object.id] = snapshot.objects.size();
+                snapshot.objects.push_back(std::move(object));
+                ref_ids.push_back(std::move(refs));
+            } else if (record == "root") {
+                string id;
+                if (!(ss >> id))
+                    throw CorruptFileError(path.string());
+                root_ids.push_back(id);
+            } else
+                throw CorruptFileError(path.string());
+        }
+
+        // Resolve the identifiers now that every object is known
+        for (size_t i = 0; i < snapshot.objects.size(); i++) {
+            auto &refs = snapshot.objects[i].refs;
+            refs.reserve(ref_ids[i].size());
+            for (const auto &id: ref_ids[i])
+                if (const auto it = indices.find(id); it != indices.end())
+                    refs.push_back(it->second);
+        }
+        for (const auto &id: root_ids)
+            if (const auto it = indices.find(id); it != indices.end())
+                snapshot.roots.push_back(it->second);
+
+        snapshot.compute_dominators();
+        return snapshot;
+    }
+
+    void Snapshot::compute_dominators() {
+        // Uses the iterative algorithm by Cooper, Harvey and Kennedy
+        // over the object graph with a virtual node (at index n) that references all the roots
+        const size_t n = objects.size();
+        constexpr size_t UNDEF = std::numeric_limits<size_t>::max();
+        const auto successors = [&](size_t v) -> const vector<size_t> & { return v == n ? roots : objects[v].refs; };
+
+        // Compute the postorder using an explicit stack, the graph can be very deep
+        vector<size_t> postorder;
+        vector<size_t> po_number(n + 1, UNDEF);
+        vector<bool> visited(n + 1, false);
+        vector<std::pair<size_t, size_t>> stack;
+        postorder.reserve(n + 1);
+        stack.emplace_back(n, 0);
+        visited[n] = true;
+        while (!stack.empty()) {
+            auto &[v, next] = stack.back();
+            const auto &succs = successors(v);
+            if (next < succs.size()) {
+                const auto w = succs[next++];
+                if (!visited[w]) {
+                    visited[w] = true;
+                    stack.emplace_back(w, 0);
+                }
+            } else {
+                po_number[v] = postorder.size();
+                postorder.push_back(v);
+                stack.pop_back();
+            }
+        }
+
+        vector<vector<size_t>> preds(n + 1);
+        for (const auto v: postorder)
+            for (const auto w: successors(v)) preds[w].push_back(v);
+
+        vector<size_t> idom(n + 1, UNDEF);
+        idom[n] = n;
+        const auto intersect = [&](size_t a, size_t b) {
+            while (a != b) {
+                while (po_number[a] < po_number[b]) a = idom[a];
+                while (po_number[b] < po_number[a]) b = idom[b];
+            }
+            return a;
+        };
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            // Visit in reverse postorder, skipping the virtual root which is the last one
+            for (size_t i = postorder.size() - 1; i-- > 0;) {
+                const auto v = postorder[i];
+                size_t new_idom = UNDEF;
+                for (const auto p: preds[v]) {
+                    if (idom[p] == UNDEF)
+                        continue;
+                    new_idom = new_idom == UNDEF ? p : intersect(p, new_idom);
+                }
+                if (idom[v] != new_idom) {
+                    idom[v] = new_idom;
+                    changed = true;
+                }
+            }
+        }
+
+        idoms.assign(n, ROOT);
+        retained.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            retained[i] = objects[i].size;
+            if (idom[i] != UNDEF && idom[i] != n)
+                idoms[i] = idom[i];
+        }
+        // A dominator always comes after the objects it dominates in postorder
+        for (const auto v: postorder)
+            if (v != n && idoms[v] != ROOT)
+                retained[idoms[v]] += retained[v];
+    }
+}    // namespace heapdiff
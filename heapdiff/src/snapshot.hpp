@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <sputils.hpp>
+#include <string>
+#include <unordered_map>
+
+namespace heapdiff
+{
+    using namespace spade;
+    using std::string;
+    namespace fs = std::filesystem;
+
+    /**
+     * Represents an object recorded in a heap snapshot
+     */
+    struct Object {
+        /// Identifier of the object in the snapshot
+        string id;
+        /// Name of the object tag
+        string kind;
+        /// Signature of the type of the object
+        string type;
+        /// Shallow size of the object in bytes
+        size_t size = 0;
+        /// Indices of the referenced objects
+        vector<size_t> refs;
+    };
+
+    /**
+     * Represents a heap snapshot written by swan along with its dominator tree
+     */
+    class Snapshot {
+      public:
+        /// The immediate dominator of the objects which are dominated only by the roots
+        static constexpr const size_t ROOT = std::numeric_limits<size_t>::max();
+
+      private:
+        vector<Object> objects;
+        vector<size_t> roots;
+        /// Immediate dominator of each object
+        vector<size_t> idoms;
+        /// Retained size of each object
+        vector<size_t> retained;
+
+      public:
+        /**
+         * Reads the snapshot from the file at @p path and computes its dominator tree
+         * @throws FileNotFoundError if the file cannot be opened
+         * @throws CorruptFileError if the file is not a valid snapshot
+         * @param path the path of the snapshot file
+         * @return the snapshot
+         */
+        static Snapshot read(const fs::path &path);
+
+        const vector<Object> &get_objects() const {
+            return objects;
+        }
+
+        const vector<size_t> &get_roots() const {
+            return roots;
+        }
+
+        /**
+         * @param i the index of the object
+         * @return the index of the immediate dominator of the object, ROOT if it is dominated only by the roots
+         */
+        size_t get_idom(size_t i) const {
+            return idoms[i];
+        }
+
+        /**
+         * @param i the index of the object
+         * @return the number of bytes which would be freed if the object was freed
+         */
+        size_t get_retained(size_t i) const {
+            return retained[i];
+        }
+
+      private:
+        void compute_dominators();
+    };
+}    // namespace heapdiff
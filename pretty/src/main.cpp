@@ -366,6 +366,7 @@ namespace pretty
                     case Opcode::JNE:
                     case Opcode::JGE:
                     case Opcode::JGT:
+                    case Opcode::RESUME:
                         param = std::to_string(static_cast<int16_t>(num));
                         break;
                     default:
@@ -277,6 +277,9 @@ namespace spadec
                 } else if (scope->is_init()) {
                     // do nothing because this is a ctor
                     // ctor implicitly returns `self`
+                } else if (scope->is_generator()) {
+                    // do nothing because this is a generator
+                    // generator finishes when control flow passes to the end
                 } else {
                     // Iterate over all incoming edges to the end of the function
                     // And check whether they all come from `return` or `throw`
@@ -556,6 +556,8 @@ namespace spadec::scope
         std::vector<ParamInfo> pos_kwd_params;
         std::vector<ParamInfo> kwd_only_params;
         TypeInfo ret_type;
+        /// Flag if the function contains a yield statement, the code of such a function starts with a generator instruction
+        bool generator = false;
 
         DirectedGraph<std::shared_ptr<CFNode>> cf_graph;
 
@@ -579,6 +581,14 @@ namespace spadec::scope
             return get_function_node()->get_name()->get_type() == TokenType::INIT;
         }
 
+        bool is_generator() const {
+            return generator;
+        }
+
+        void set_generator(bool generator = true) {
+            this->generator = generator;
+        }
+
         bool has_param(const string &name) const {
             auto it = std::find_if(pos_only_params.begin(), pos_only_params.end(), [&name](const ParamInfo &param) { return param.name == name; });
             if (it != pos_only_params.end())
@@ -339,19 +339,16 @@ namespace spadec
             else
                 for (const auto &last_cf_node: last_cf_nodes) cfg.insert_edge(last_cf_node, cf_node);
 
-            cfg.insert_edge(cf_node, end_cf_node);
-
+            // The generator continues after the yield statement when it is resumed
             last_cf_nodes = {cf_node};
         }
 
         if (get_current_function()->is_init())
             throw error("yield statement is not allowed in a ctor");
+        get_current_function()->set_generator();
 
         // TODO: Improve yield statement
         eval_expr(node.get_expression(), node);
-
-        // Control flow specific
-        last_cf_nodes.clear();
     }
 
     void Analyzer::visit(ast::stmt::Expr &node) {
@@ -85,7 +85,8 @@ namespace spadec
     void CodeEmitter::emit_inst(Opcode opcode, string param, uint32_t line) {
         assert(OpcodeInfo::params_count(opcode) == 2);
         cpidx index = module->get_constant(param);
-        if (index <= uint8_max) {
+        // Use the short form if the opcode has one
+        if (index <= uint8_max && OpcodeInfo::alternate(opcode) != opcode) {
             emit_opcode(OpcodeInfo::alternate(opcode), line);
             emit_byte(index & 0xFF, line);
         } else {
@@ -96,7 +97,7 @@ namespace spadec
 
     void CodeEmitter::emit_inst(Opcode opcode, uint16_t param, uint32_t line) {
         assert(OpcodeInfo::params_count(opcode) == 2);
-        if (param <= uint8_max) {
+        if (param <= uint8_max && OpcodeInfo::alternate(opcode) != opcode) {
             emit_opcode(OpcodeInfo::alternate(opcode), line);
             emit_byte(param & 0xFF, line);
         } else {
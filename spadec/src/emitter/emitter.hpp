@@ -346,6 +346,14 @@ namespace spadec
             emit_opcode(Opcode::ARRLEN, line);
         }
 
+        void emit_arrpush(uint32_t line) {
+            emit_opcode(Opcode::ARRPUSH, line);
+        }
+
+        void emit_arrpop(uint32_t line) {
+            emit_opcode(Opcode::ARRPOP, line);
+        }
+
         // Invoke ops
         void emit_invoke(uint8_t arg_count, uint32_t line) {
             emit_opcode(Opcode::INVOKE, line);
@@ -457,6 +465,11 @@ namespace spadec
             emit_opcode(Opcode::CONCAT, line);
         }
 
+        void emit_concatn(uint8_t count, uint32_t line) {
+            emit_opcode(Opcode::CONCATN, line);
+            emit_byte(count, line);
+        }
+
         void emit_pow(uint32_t line) {
             emit_opcode(Opcode::POW, line);
         }
@@ -587,6 +600,103 @@ namespace spadec
             emit_opcode(Opcode::EXITMONITOR, line);
         }
 
+        void emit_waitmonitor(uint32_t line) {
+            emit_opcode(Opcode::WAITMONITOR, line);
+        }
+
+        void emit_notifymonitor(uint32_t line) {
+            emit_opcode(Opcode::NOTIFYMONITOR, line);
+        }
+
+        void emit_notifyallmonitor(uint32_t line) {
+            emit_opcode(Opcode::NOTIFYALLMONITOR, line);
+        }
+
+        // Atomic ops
+        void emit_atmload(const string &name, uint32_t line) {
+            emit_inst(Opcode::ATMLOAD, name, line);
+        }
+
+        void emit_atmstore(const string &name, uint32_t line) {
+            emit_inst(Opcode::ATMSTORE, name, line);
+        }
+
+        void emit_atmcas(const string &name, uint32_t line) {
+            emit_inst(Opcode::ATMCAS, name, line);
+        }
+
+        void emit_atmadd(const string &name, uint32_t line) {
+            emit_inst(Opcode::ATMADD, name, line);
+        }
+
+        void emit_atmsub(const string &name, uint32_t line) {
+            emit_inst(Opcode::ATMSUB, name, line);
+        }
+
+        void emit_atiload(uint32_t line) {
+            emit_opcode(Opcode::ATILOAD, line);
+        }
+
+        void emit_atistore(uint32_t line) {
+            emit_opcode(Opcode::ATISTORE, line);
+        }
+
+        void emit_aticas(uint32_t line) {
+            emit_opcode(Opcode::ATICAS, line);
+        }
+
+        void emit_atiadd(uint32_t line) {
+            emit_opcode(Opcode::ATIADD, line);
+        }
+
+        void emit_atisub(uint32_t line) {
+            emit_opcode(Opcode::ATISUB, line);
+        }
+
+        void emit_atlload(uint16_t index, uint32_t line) {
+            emit_inst(Opcode::ATLLOAD, index, line);
+        }
+
+        void emit_atlstore(uint16_t index, uint32_t line) {
+            emit_inst(Opcode::ATLSTORE, index, line);
+        }
+
+        void emit_atlcas(uint16_t index, uint32_t line) {
+            emit_inst(Opcode::ATLCAS, index, line);
+        }
+
+        void emit_atladd(uint16_t index, uint32_t line) {
+            emit_inst(Opcode::ATLADD, index, line);
+        }
+
+        void emit_atlsub(uint16_t index, uint32_t line) {
+            emit_inst(Opcode::ATLSUB, index, line);
+        }
+
+        // Coroutine ops
+        void emit_generator(uint32_t line) {
+            emit_opcode(Opcode::GENERATOR, line);
+        }
+
+        void emit_yield(uint32_t line) {
+            emit_opcode(Opcode::YIELD, line);
+        }
+
+        void emit_resume(const std::shared_ptr<Label> &exit, uint32_t line) {
+            emit_opcode(Opcode::RESUME, line);
+            emit_label(exit, line);
+        }
+
+        // Task ops
+        void emit_spawn(uint8_t count, uint32_t line) {
+            emit_opcode(Opcode::SPAWN, line);
+            emit_byte(count, line);
+        }
+
+        void emit_join(uint32_t line) {
+            emit_opcode(Opcode::JOIN, line);
+        }
+
         // Misc. ops
         void emit_mtperf(uint16_t index, uint32_t line) {
             emit_inst(Opcode::MTPERF, index, line);
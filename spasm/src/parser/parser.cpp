@@ -699,6 +699,8 @@ outside:
             break;
         case Opcode::NPOP:
         case Opcode::NDUP:
+        case Opcode::CONCATN:
+        case Opcode::SPAWN:
             emit_value(static_cast<uint64_t>(str2int(expect(TokenType::INTEGER))));
             break;
         case Opcode::GLOAD:
@@ -718,7 +720,12 @@ outside:
         case Opcode::PLSTORE:
         case Opcode::PLFSTORE:
         case Opcode::LINVOKE:
-        case Opcode::LFINVOKE: {
+        case Opcode::LFINVOKE:
+        case Opcode::ATLLOAD:
+        case Opcode::ATLSTORE:
+        case Opcode::ATLCAS:
+        case Opcode::ATLADD:
+        case Opcode::ATLSUB: {
             if (match(TokenType::INTEGER)) {
                 const auto value = str2int(current());
                 if (value >= uint16_max)
@@ -757,6 +764,11 @@ outside:
         case Opcode::MFSTORE:
         case Opcode::PMSTORE:
         case Opcode::PMFSTORE:
+        case Opcode::ATMLOAD:
+        case Opcode::ATMSTORE:
+        case Opcode::ATMCAS:
+        case Opcode::ATMADD:
+        case Opcode::ATMSUB:
             emit_value(module->get_constant(parse_signature().to_string()));
             break;
         case Opcode::ARRBUILD:
@@ -780,7 +792,8 @@ outside:
         case Opcode::JEQ:
         case Opcode::JNE:
         case Opcode::JGE:
-        case Opcode::JGT: {
+        case Opcode::JGT:
+        case Opcode::RESUME: {
             const auto label = expect(TokenType::LABEL);
             const auto jmp_val = ctx->patch_jump_to(label);
             ctx->emit((jmp_val >> 8) & uint8_max);
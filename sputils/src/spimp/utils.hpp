@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <type_traits>
 
 namespace spade
 {
@@ -21,6 +22,15 @@ namespace spade
      */
     std::string cpp_demangle(std::string str);
 
+    /**
+     * A type which is not polymorphic can provide a static function `classof` which
+     * tells whether the object is an instance of that type. If present, it is used instead of dynamic_cast
+     */
+    template<class To, class From>
+    concept HasClassOf = requires(From *val) {
+        { std::remove_cv_t<To>::classof(val) } -> std::convertible_to<bool>;
+    };
+
     /**
      * Casts a value of nullable_type From to a value of nullable_type To.
      * @throws CastError if casting fails
@@ -33,6 +43,10 @@ namespace spade
     To *cast(From *val) {
         if constexpr (std::derived_from<From, To>) {
             return static_cast<To *>(val);
+        } else if constexpr (HasClassOf<To, From>) {
+            if (val == nullptr || !std::remove_cv_t<To>::classof(val))
+                throw CastError(cpp_demangle(typeid(From).name()), cpp_demangle(typeid(To).name()));
+            return static_cast<To *>(val);
         } else {
             auto cast_val = dynamic_cast<To *>(val);
             if (cast_val == nullptr)
@@ -72,6 +86,8 @@ namespace spade
     bool is(From *obj) {
         if constexpr (std::derived_from<From, To>)
             return true;
+        else if constexpr (HasClassOf<To, From>)
+            return obj != nullptr && std::remove_cv_t<To>::classof(obj);
         else
             return dynamic_cast<To *>(obj) != nullptr;
     }
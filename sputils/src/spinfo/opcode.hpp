@@ -268,7 +268,75 @@
     /* debug op */                                                                                                                                   \
     /* ----------------------------------------------------- */                                                                                      \
     /* print to console output */                                                                                                                    \
-    OPCODE(PRINTLN, 0, false, PRINTLN)
+    OPCODE(PRINTLN, 0, false, PRINTLN)                                                                                                               \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* extended op */                                                                                                                                \
+    /* new opcodes are appended here, so that the opcodes of the existing elp files keep their numbers */                                            \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* push array element */                                                                                                                         \
+    OPCODE(ARRPUSH, 0, false, ARRPUSH)                                                                                                               \
+    /* pop array element */                                                                                                                          \
+    OPCODE(ARRPOP, 0, false, ARRPOP)                                                                                                                 \
+    /* concat multiple */                                                                                                                            \
+    OPCODE(CONCATN, 1, false, CONCATN)                                                                                                               \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* coroutine op */                                                                                                                               \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* detach the frame into a generator */                                                                                                          \
+    OPCODE(GENERATOR, 0, false, GENERATOR)                                                                                                           \
+    /* yield from generator */                                                                                                                       \
+    OPCODE(YIELD, 0, false, YIELD)                                                                                                                   \
+    /* resume generator */                                                                                                                           \
+    OPCODE(RESUME, 2, false, RESUME)                                                                                                                 \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* task op */                                                                                                                                    \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* spawn task */                                                                                                                                 \
+    OPCODE(SPAWN, 1, false, SPAWN)                                                                                                                   \
+    /* join task */                                                                                                                                  \
+    OPCODE(JOIN, 0, false, JOIN)                                                                                                                     \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* atomic op */                                                                                                                                  \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* load member with acquire order */                                                                                                             \
+    OPCODE(ATMLOAD, 2, true, ATMLOAD)                                                                                                                \
+    /* store member with release order */                                                                                                            \
+    OPCODE(ATMSTORE, 2, true, ATMSTORE)                                                                                                              \
+    /* compare and swap member */                                                                                                                    \
+    OPCODE(ATMCAS, 2, true, ATMCAS)                                                                                                                  \
+    /* fetch and add member */                                                                                                                       \
+    OPCODE(ATMADD, 2, true, ATMADD)                                                                                                                  \
+    /* fetch and subtract member */                                                                                                                  \
+    OPCODE(ATMSUB, 2, true, ATMSUB)                                                                                                                  \
+    /* load element with acquire order */                                                                                                            \
+    OPCODE(ATILOAD, 0, false, ATILOAD)                                                                                                               \
+    /* store element with release order */                                                                                                           \
+    OPCODE(ATISTORE, 0, false, ATISTORE)                                                                                                             \
+    /* compare and swap element */                                                                                                                   \
+    OPCODE(ATICAS, 0, false, ATICAS)                                                                                                                 \
+    /* fetch and add element */                                                                                                                      \
+    OPCODE(ATIADD, 0, false, ATIADD)                                                                                                                 \
+    /* fetch and subtract element */                                                                                                                 \
+    OPCODE(ATISUB, 0, false, ATISUB)                                                                                                                 \
+    /* load local with acquire order */                                                                                                              \
+    OPCODE(ATLLOAD, 2, false, ATLLOAD)                                                                                                               \
+    /* store local with release order */                                                                                                             \
+    OPCODE(ATLSTORE, 2, false, ATLSTORE)                                                                                                             \
+    /* compare and swap local */                                                                                                                     \
+    OPCODE(ATLCAS, 2, false, ATLCAS)                                                                                                                 \
+    /* fetch and add local */                                                                                                                        \
+    OPCODE(ATLADD, 2, false, ATLADD)                                                                                                                 \
+    /* fetch and subtract local */                                                                                                                   \
+    OPCODE(ATLSUB, 2, false, ATLSUB)                                                                                                                 \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* monitor op */                                                                                                                                 \
+    /* ----------------------------------------------------- */                                                                                      \
+    /* wait on monitor */                                                                                                                            \
+    OPCODE(WAITMONITOR, 0, false, WAITMONITOR)                                                                                                       \
+    /* notify a waiter of monitor */                                                                                                                 \
+    OPCODE(NOTIFYMONITOR, 0, false, NOTIFYMONITOR)                                                                                                   \
+    /* notify all waiters of monitor */                                                                                                              \
+    OPCODE(NOTIFYALLMONITOR, 0, false, NOTIFYALLMONITOR)
 
 namespace spade
 {
@@ -1,14 +1,44 @@
 #include "callable.hpp"
+#include "foreign.hpp"
+#include "method.hpp"
 #include "utils/errors.hpp"
 
 namespace spade
 {
     void ObjCallable::validate_call_site() {
-        if (const auto mgr = MemoryManager::current(); !mgr || mgr != info.manager)
+        if (const auto mgr = MemoryManager::current(); !mgr || mgr != get_manager())
             throw IllegalAccessError(std::format("invalid call site, cannot call {}", to_string()));
     }
 
     size_t ObjCallable::get_args_count() const {
-        return sign.get_params().size();
+        if (get_tag() == OBJ_METHOD)
+            return static_cast<const ObjMethod *>(this)->get_args_count();
+        return sign->get_params().size();
+    }
+
+    void ObjCallable::call(Obj *self, vector<Value> args) {
+        switch (get_tag()) {
+        case OBJ_METHOD:
+            static_cast<ObjMethod *>(this)->call(self, std::move(args));
+            break;
+        case OBJ_FOREIGN:
+            static_cast<ObjForeign *>(this)->call(self, std::move(args));
+            break;
+        default:
+            throw Unreachable();
+        }
+    }
+
+    void ObjCallable::call(Obj *self, Value *args) {
+        switch (get_tag()) {
+        case OBJ_METHOD:
+            static_cast<ObjMethod *>(this)->call(self, args);
+            break;
+        case OBJ_FOREIGN:
+            static_cast<ObjForeign *>(this)->call(self, args);
+            break;
+        default:
+            throw Unreachable();
+        }
     }
 }    // namespace spade
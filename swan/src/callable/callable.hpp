@@ -10,30 +10,37 @@ namespace spade
 
       protected:
         Kind kind;
-        Sign sign;
+        /// The signature, which is shared by the closures made from a method
+        std::shared_ptr<const Sign> sign;
 
         void validate_call_site();
 
       public:
-        ObjCallable(ObjTag tag, Kind kind, const Sign &sign) : Obj(tag), kind(kind), sign(sign) {}
+        ObjCallable(ObjTag tag, Kind kind, const Sign &sign) : Obj(tag), kind(kind), sign(std::make_shared<const Sign>(sign)) {}
+
+        ObjCallable(ObjTag tag, Kind kind, std::shared_ptr<const Sign> sign) : Obj(tag), kind(kind), sign(std::move(sign)) {}
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_METHOD || obj->get_tag() == OBJ_FOREIGN;
+        }
 
         Kind get_kind() const {
             return kind;
         }
 
         const Sign &get_sign() const {
-            return sign;
+            return *sign;
         }
 
         void set_sign(const Sign &sign) {
-            this->sign = sign;
+            this->sign = std::make_shared<const Sign>(sign);
         }
 
-        bool truth() const override {
+        bool truth() const {
             return true;
         }
 
-        virtual size_t get_args_count() const;
+        size_t get_args_count() const;
 
         /**
          * Calls this method with @p args on the current thread
@@ -43,7 +50,7 @@ namespace spade
          * @param method the method to be called
          * @param args arguments of the method
          */
-        virtual void call(Obj *self, vector<Value> args) = 0;
+        void call(Obj *self, vector<Value> args);
 
         /**
          * Calls this method with @p args on the current thread
@@ -53,6 +60,6 @@ namespace spade
          * @param method the method to be called
          * @param args pointer to the args on the stack
          */
-        virtual void call(Obj *self, Value *args) = 0;
+        void call(Obj *self, Value *args);
     };
 }    // namespace spade
@@ -9,12 +9,12 @@ namespace spade
     void ObjForeign::call(Obj *self, vector<Value> args) {
         validate_call_site();
 
-        const uint8_t arg_count = sign.get_elements().back().get_params().size() & 0xFF;
+        const uint8_t arg_count = sign->get_elements().back().get_params().size() & 0xFF;
 
         if (arg_count < args.size())
-            throw ArgumentError(sign.to_string(), std::format("too less arguments, expected {} got {}", arg_count, args.size()));
+            throw ArgumentError(sign->to_string(), std::format("too less arguments, expected {} got {}", arg_count, args.size()));
         if (arg_count > args.size())
-            throw ArgumentError(sign.to_string(), std::format("too many arguments, expected {} got {}", arg_count, args.size()));
+            throw ArgumentError(sign->to_string(), std::format("too many arguments, expected {} got {}", arg_count, args.size()));
 
         foreign_call(self, args);
     }
@@ -22,7 +22,7 @@ namespace spade
     void ObjForeign::call(Obj *self, Value *args) {
         validate_call_site();
 
-        const uint8_t arg_count = sign.get_elements().back().get_params().size() & 0xFF;
+        const uint8_t arg_count = sign->get_elements().back().get_params().size() & 0xFF;
         foreign_call(self, vector(args, args + arg_count));
     }
 
@@ -43,11 +43,18 @@ namespace spade
         ///     spade::Value handle_with_self(spade::Thread *thread, Obj *self, Value *ret, Value arg0);
         ///     spade::Value handle(spade::Thread *thread, Value *ret, Value arg0);
 
-        // class Value is always 16 bytes
+#ifdef SWAN_NAN_BOXING
+        // class Value is a single 64-bit word
+        ffi_type *value_type_elements[2];
+        value_type_elements[0] = &ffi_type_uint64;
+        value_type_elements[1] = null;
+#else
+        // class Value is 16 bytes, the tag followed by the payload
         ffi_type *value_type_elements[3];
         value_type_elements[0] = &ffi_type_uint64;
         value_type_elements[1] = &ffi_type_uint64;
         value_type_elements[2] = null;
+#endif
 
         ffi_type ffi_type_value;
         ffi_type_value.size = ffi_type_value.alignment = 0;
@@ -86,11 +93,11 @@ namespace spade
             ffi_call(&cif, (void (*)()) handle, null, ffi_values.data());
             break;
         case FFI_BAD_TYPEDEF:
-            throw ForeignCallError(sign.to_string(), "FFI_BAD_TYPEDEF");
+            throw ForeignCallError(sign->to_string(), "FFI_BAD_TYPEDEF");
         case FFI_BAD_ABI:
-            throw ForeignCallError(sign.to_string(), "FFI_BAD_ABI");
+            throw ForeignCallError(sign->to_string(), "FFI_BAD_ABI");
         case FFI_BAD_ARGTYPE:
-            throw ForeignCallError(sign.to_string(), "FFI_BAD_ARGTYPE");
+            throw ForeignCallError(sign->to_string(), "FFI_BAD_ARGTYPE");
         default:
             throw Unreachable();
         }
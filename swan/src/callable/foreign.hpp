@@ -13,8 +13,12 @@ namespace spade
         ObjForeign(const Sign &sign, void *handle, bool has_self)
             : ObjCallable(OBJ_FOREIGN, Kind::FOREIGN, sign), handle(handle), has_self(has_self) {}
 
-        void call(Obj *self, vector<Value> args) override;
-        void call(Obj *self, Value *args) override;
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_FOREIGN;
+        }
+
+        void call(Obj *self, vector<Value> args);
+        void call(Obj *self, Value *args);
 
       private:
         void foreign_call(Obj *self, vector<Value> args);
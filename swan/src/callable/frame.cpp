@@ -1,13 +1,15 @@
 #include "frame.hpp"
 #include "ee/obj.hpp"
 #include "memory/memory.hpp"
+#include "generator.hpp"
 #include "method.hpp"
 #include "ee/vm.hpp"
 #include "spimp/utils.hpp"
 
 namespace spade
 {
-    Frame::Frame() : stack_max(0), code_count(0), code(null), pc(0), stack(null), sc(0), args_count(0), locals_count(0), method(null), module(null) {}
+    Frame::Frame()
+        : stack_max(0), code_count(0), code(null), pc(0), stack(null), sc(0), args_count(0), locals_count(0), method(null), module(null), generator(null) {}
 
     Frame::Frame(Frame &&frame)
         : stack_max(frame.stack_max),
@@ -19,7 +21,8 @@ namespace spade
           args_count(frame.args_count),
           locals_count(frame.locals_count),
           method(frame.method),
-          module(frame.module) {
+          module(frame.module),
+          generator(frame.generator) {
         frame.code_count = frame.stack_max = 0;
         frame.code = null;
         frame.pc = 0;
@@ -27,6 +30,7 @@ namespace spade
         frame.sc = 0;
         frame.method = null;
         frame.module = null;
+        frame.generator = null;
     }
 
     Frame &Frame::operator=(Frame &&frame) {
@@ -40,6 +44,7 @@ namespace spade
         locals_count = frame.locals_count;
         method = frame.method;
         module = frame.module;
+        generator = frame.generator;
 
         frame.code_count = frame.stack_max = 0;
         frame.code = null;
@@ -48,6 +53,7 @@ namespace spade
         frame.sc = 0;
         frame.method = null;
         frame.module = null;
+        frame.generator = null;
 
         return *this;
     }
@@ -63,6 +69,7 @@ namespace spade
         sc = 0;
         method = null;
         module = null;
+        generator = null;
     }
 
     Value Frame::get_arg(uint8_t i) const {
@@ -151,6 +158,19 @@ namespace spade
         return pointer;
     }
 
+    void Frame::for_each_reference(const std::function<void(Obj *)> &func) const {
+        if (method)
+            func(method);
+        if (module)
+            func(module);
+        if (generator)
+            func(generator);
+        // Args and locals are laid out before the operand stack and are counted by it
+        for (uint32_t i = 0; i < sc; i++)
+            if (const auto value = stack[i]; value.is_obj())
+                func(value.as_obj());
+    }
+
     void Frame::set_method(ObjMethod *met) {
         method = met;
         module = cast<ObjModule>(SpadeVM::current()->get_symbol(method->get_sign().get_parent_module().to_string()).as_obj());
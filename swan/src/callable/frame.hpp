@@ -6,6 +6,7 @@
 namespace spade
 {
     class ObjMethod;
+    class ObjGenerator;
 
     class SWAN_EXPORT Frame {
         friend class ObjMethod;
@@ -25,6 +26,8 @@ namespace spade
         uint16_t locals_count;
         ObjMethod *method;
         ObjModule *module;
+        /// The generator which runs this frame, null if the frame is not run by a generator
+        ObjGenerator *generator;
 
       public:
         Frame();
@@ -68,6 +71,13 @@ namespace spade
             return module->get_constant_pool();
         }
 
+        /**
+         * @return The interned member names of the constant pool
+         */
+        const vector<const ObjString *> &get_member_names() const {
+            return module->get_member_names();
+        }
+
         uint8_t get_args_count() const {
             return args_count;
         }
@@ -98,6 +108,27 @@ namespace spade
             return module;
         }
 
+        /**
+         * @return The generator which runs this frame, null if the frame is not run by a generator
+         */
+        ObjGenerator *get_generator() const {
+            return generator;
+        }
+
+        /**
+         * Sets the generator which runs this frame
+         * @param gen the generator
+         */
+        void set_generator(ObjGenerator *gen) {
+            generator = gen;
+        }
+
+        /**
+         * Calls @p func for every object referred to by this frame
+         * @param func the function to be called
+         */
+        void for_each_reference(const std::function<void(Obj *)> &func) const;
+
         /**
          * Sets the method associated with this frame
          * @param met the method value
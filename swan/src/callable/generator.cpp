@@ -0,0 +1,42 @@
+#include "generator.hpp"
+#include "method.hpp"
+#include "ee/thread.hpp"
+#include "utils/errors.hpp"
+
+namespace spade
+{
+    ObjGenerator::ObjGenerator() : Obj(OBJ_GENERATOR) {}
+
+    void ObjGenerator::suspend(ThreadState &thread_state) {
+        frame = std::move(*thread_state.get_frame());
+        frame.set_generator(null);
+        thread_state.pop_frame();
+        state.store(State::SUSPENDED, std::memory_order_release);
+    }
+
+    void ObjGenerator::resume(ThreadState &thread_state, uint32_t exit_pc) {
+        auto expected = State::SUSPENDED;
+        if (!state.compare_exchange_strong(expected, State::RUNNING, std::memory_order_acq_rel))
+            throw IllegalGeneratorStateError(expected == State::RUNNING ? "generator is already running" : "generator has finished");
+        this->exit_pc = exit_pc;
+        frame.set_generator(this);
+        try {
+            thread_state.push_frame(std::move(frame));
+        } catch (...) {
+            // The frame is left in place if it could not be pushed
+            frame.set_generator(null);
+            state.store(State::SUSPENDED, std::memory_order_release);
+            throw;
+        }
+    }
+
+    uint32_t ObjGenerator::finish() {
+        state.store(State::FINISHED, std::memory_order_release);
+        return exit_pc;
+    }
+
+    string ObjGenerator::to_string() const {
+        static constexpr const char *state_names[] = {"suspended", "running", "finished"};
+        return std::format("<generator {}>", state_names[static_cast<int>(get_state())]);
+    }
+}    // namespace spade
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ee/obj.hpp"
+#include "frame.hpp"
+#include <atomic>
+
+namespace spade
+{
+    class ThreadState;
+
+    /**
+     * Represents a generator, which is a frame detached from the call stack so that it can be suspended and resumed.
+     * A suspended generator holds its frame on the heap, and a running generator has its frame on the call stack
+     * of the thread that resumed it. Since the frame is moved instead of being copied, suspending and resuming
+     * a generator costs the same as a call.
+     */
+    class SWAN_EXPORT ObjGenerator final : public Obj {
+      public:
+        enum class State {
+            /// The generator holds its frame and can be resumed
+            SUSPENDED,
+            /// The frame of the generator is on a call stack
+            RUNNING,
+            /// The generator has returned or thrown, it cannot be resumed anymore
+            FINISHED,
+        };
+
+      private:
+        /// The frame of the generator, which is empty unless the generator is suspended
+        Frame frame;
+        std::atomic<State> state = State::SUSPENDED;
+        /// The pc in the frame of the resumer where the execution continues when the generator finishes
+        uint32_t exit_pc = 0;
+
+      public:
+        ObjGenerator();
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_GENERATOR;
+        }
+
+        State get_state() const {
+            return state.load(std::memory_order_acquire);
+        }
+
+        bool is_finished() const {
+            return get_state() == State::FINISHED;
+        }
+
+        /**
+         * @return the frame of the generator, which is empty unless the generator is suspended
+         */
+        const Frame &get_frame() const {
+            return frame;
+        }
+
+        /**
+         * Moves the active frame of @p thread_state into this generator and pops it from the call stack
+         * @param thread_state the state of the thread running the generator
+         */
+        void suspend(ThreadState &thread_state);
+
+        /**
+         * Pushes the frame of this generator on the call stack of @p thread_state, so it continues from where it was suspended
+         * @throws IllegalGeneratorStateError if the generator is not suspended
+         * @param thread_state the state of the resuming thread
+         * @param exit_pc the pc in the active frame where the execution continues if the generator finishes
+         */
+        void resume(ThreadState &thread_state, uint32_t exit_pc);
+
+        /**
+         * Marks this generator as finished. Its frame must already be popped from the call stack
+         * @return the pc in the frame of the resumer where the execution continues
+         */
+        uint32_t finish();
+
+        Obj *copy() const {
+            return (Obj *) this;
+        }
+
+        bool truth() const {
+            return !is_finished();
+        }
+
+        string to_string() const;
+    };
+}    // namespace spade
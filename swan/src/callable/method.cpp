@@ -17,23 +17,26 @@ namespace spade
     ObjMethod::ObjMethod(Kind kind, const Sign &sign, const vector<uint8_t> &code, uint32_t stack_max, uint8_t args_count, uint16_t locals_count,
                          const ExceptionTable &exceptions, const LineNumberTable &lines, const vector<MatchTable> &matches)
         : ObjCallable(OBJ_METHOD, kind, sign),
-          code_count(code.size()),
-          code(std::make_unique<uint8_t[]>(code_count)),
-          stack_max(stack_max),
-          args_count(args_count),
-          locals_count(locals_count),
-          exceptions(exceptions),
-          lines(lines),
-          matches(matches) {
-        std::copy(code.begin(), code.end(), &this->code[0]);
+          body(std::make_shared<MethodCode>(static_cast<uint32_t>(code.size()), null, stack_max, args_count, locals_count, exceptions,
+                                            std::make_shared<const LineNumberTable>(lines), std::make_shared<const vector<MatchTable>>(matches))) {
+        const auto bytes = std::make_shared<uint8_t[]>(code.size());
+        std::copy(code.begin(), code.end(), bytes.get());
+        body->code = bytes;
     }
 
+    ObjMethod::ObjMethod(Kind kind, std::shared_ptr<const Sign> sign, std::shared_ptr<MethodCode> body)
+        : ObjCallable(OBJ_METHOD, kind, std::move(sign)), body(std::move(body)) {}
+
+    ObjMethod::ObjMethod(Kind kind, const Sign &sign, std::shared_ptr<MethodCode> body)
+        : ObjCallable(OBJ_METHOD, kind, sign), body(std::move(body)) {}
+
     void ObjMethod::call(Obj *self, vector<Value> args) {
         validate_call_site();
+        const auto args_count = body->args_count;
         if (args_count < args.size())
-            throw ArgumentError(sign.to_string(), std::format("too less arguments, expected {} got {}", args_count, args.size()));
+            throw ArgumentError(sign->to_string(), std::format("too less arguments, expected {} got {}", args_count, args.size()));
         if (args_count > args.size())
-            throw ArgumentError(sign.to_string(), std::format("too many arguments, expected {} got {}", args_count, args.size()));
+            throw ArgumentError(sign->to_string(), std::format("too many arguments, expected {} got {}", args_count, args.size()));
         // Call the function
         call_impl(self, args.data());
     }
@@ -44,14 +47,13 @@ namespace spade
     }
 
     void ObjMethod::set_capture(uint16_t local_idx, ObjCapture *capture) {
-        if (local_idx >= locals_count)
+        if (local_idx >= body->locals_count)
             throw IndexError("local", local_idx);
         captures.emplace_back(local_idx, capture);
     }
 
     ObjMethod *ObjMethod::force_copy() const {
-        const auto method = halloc_mgr<ObjMethod>(info.manager, kind, sign, vector(&code[0], &code[code_count]), stack_max, args_count, locals_count,
-                                                  exceptions, lines, matches);
+        const auto method = halloc_mgr<ObjMethod>(get_manager(), kind, sign, body);
         for (const auto &[name, slot]: member_slots) {
             method->set_member(name, slot.get_value().copy());
             method->set_flags(name, slot.get_flags());
@@ -64,16 +66,17 @@ namespace spade
 
     string ObjMethod::to_string() const {
         const static string kind_names[] = {"function", "method", "constructor"};
-        return std::format("<{} '{}'>", kind_names[static_cast<int>(kind)], sign.to_string());
+        return std::format("<{} '{}'>", kind_names[static_cast<int>(kind)], sign->to_string());
     }
 
     void ObjMethod::call_impl(Obj *self, Value *args) {
+        const auto &[code_count, code, stack_max, args_count, locals_count, exceptions, lines, matches] = *body;
         Frame frame;
 
         frame.code_count = code_count;
         frame.stack_max = stack_max;
 
-        frame.code = &code[0];
+        frame.code = code.get();
         frame.pc = 0;
         frame.stack = new Value[args_count + locals_count + stack_max]();
         frame.sc = args_count + locals_count;
@@ -81,7 +84,7 @@ namespace spade
         frame.args_count = args_count;
         frame.locals_count = locals_count;
         frame.method = this;
-        frame.module = cast<ObjModule>(info.manager->get_vm()->get_symbol(sign.get_parent_module().to_string()).as_obj());
+        frame.module = cast<ObjModule>(get_manager()->get_vm()->get_symbol(sign->get_parent_module().to_string()).as_obj());
 
         // Set the arguments
         for (size_t i = 0; i < args_count; i++) frame.set_arg(i, args[i]);
@@ -8,82 +8,119 @@
 
 namespace spade
 {
+    /**
+     * The code of a method and the tables describing it.
+     * It is shared by a method and all the closures made from it, and is not changed once the method is loaded.
+     * The bytecode, the line table and the match tables can be further shared by the methods loaded
+     * from the same file by different vms (see CodeCache)
+     */
+    struct SWAN_EXPORT MethodCode {
+        uint32_t code_count;
+        std::shared_ptr<const uint8_t[]> code;
+        uint32_t stack_max;
+        uint8_t args_count;
+        uint16_t locals_count;
+        ExceptionTable exceptions;
+        std::shared_ptr<const LineNumberTable> lines;
+        std::shared_ptr<const vector<MatchTable>> matches;
+    };
+
+    /**
+     * Represents a method or a closure.
+     * A closure is a method which shares the code of the method it is made from and holds its own captures
+     */
     class SWAN_EXPORT ObjMethod final : public ObjCallable {
+      public:
         struct CaptureInfo {
             uint16_t local_index;
             ObjCapture *capture;
         };
 
       private:
-        uint32_t code_count;
-        std::unique_ptr<uint8_t[]> code;
-        uint32_t stack_max;
-        uint8_t args_count;
-        uint16_t locals_count;
+        std::shared_ptr<MethodCode> body;
         vector<CaptureInfo> captures;
-        ExceptionTable exceptions;
-        LineNumberTable lines;
-        vector<MatchTable> matches;
 
       public:
         ObjMethod(Kind kind, const Sign &sign, const vector<uint8_t> &code, uint32_t stack_max, uint8_t args_count, uint16_t locals_count,
                   const ExceptionTable &exceptions, const LineNumberTable &lines, const vector<MatchTable> &matches);
 
-        void call(Obj *self, vector<Value> args) override;
-        void call(Obj *self, Value *args) override;
+        /**
+         * Creates a method which shares @p sign and @p body with another method
+         * @param kind the kind of the method
+         * @param sign the signature
+         * @param body the code of the method
+         */
+        ObjMethod(Kind kind, std::shared_ptr<const Sign> sign, std::shared_ptr<MethodCode> body);
+
+        /**
+         * Creates a method with @p body
+         * @param kind the kind of the method
+         * @param sign the signature
+         * @param body the code of the method
+         */
+        ObjMethod(Kind kind, const Sign &sign, std::shared_ptr<MethodCode> body);
+
+        void call(Obj *self, vector<Value> args);
+        void call(Obj *self, Value *args);
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_METHOD;
+        }
 
         void set_capture(uint16_t local_idx, ObjCapture *capture);
+
+        /**
+         * Makes a closure of this method, which shares the code of this method instead of copying it.
+         * The member slots and the captures are copied
+         * @return the closure
+         */
         ObjMethod *force_copy() const;
 
+        const vector<CaptureInfo> &get_captures() const {
+            return captures;
+        }
+
         uint32_t get_code_count() const {
-            return code_count;
+            return body->code_count;
         }
 
-        uint8_t *get_code() const {
-            return &code[0];
+        const uint8_t *get_code() const {
+            return body->code.get();
         }
 
         uint32_t get_stack_max() const {
-            return stack_max;
+            return body->stack_max;
         }
 
-        size_t get_args_count() const override {
-            return args_count;
+        size_t get_args_count() const {
+            return body->args_count;
         }
 
         size_t get_locals_count() const {
-            return locals_count;
+            return body->locals_count;
         }
 
         const ExceptionTable &get_exceptions() const {
-            return exceptions;
+            return body->exceptions;
         }
 
         const LineNumberTable &get_lines() const {
-            return lines;
+            return *body->lines;
         }
 
         const vector<MatchTable> &get_matches() const {
-            return matches;
+            return *body->matches;
         }
 
         ExceptionTable &get_exceptions() {
-            return exceptions;
-        }
-
-        LineNumberTable &get_lines() {
-            return lines;
-        }
-
-        vector<MatchTable> &get_matches() {
-            return matches;
+            return body->exceptions;
         }
 
-        Obj *copy() const override {
+        Obj *copy() const {
             return (Obj *) this;
         }
 
-        string to_string() const override;
+        string to_string() const;
 
       private:
         void call_impl(Obj *self, Value *args);
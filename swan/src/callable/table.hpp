@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ee/hashtable.hpp"
 #include "ee/obj.hpp"
 
 namespace spade
@@ -203,15 +204,6 @@ namespace spade
         friend class BasicCollector;
 
       private:
-        struct SWAN_EXPORT ValueEqual {
-            bool operator()(Value lhs, Value rhs) const;
-        };
-
-        struct SWAN_EXPORT ValueHash {
-            void hash(size_t &seed, Value value) const;
-            size_t operator()(Value value) const;
-        };
-
         std::unordered_map<Value, uint32_t, ValueHash, ValueEqual> table;
         uint32_t default_location;
 
@@ -231,7 +223,7 @@ namespace spade
             return default_location;
         }
 
-        std::unordered_map<Value, uint32_t, ValueHash, ValueEqual> get_table() const {
+        const std::unordered_map<Value, uint32_t, ValueHash, ValueEqual> &get_table() const {
             return table;
         }
 
@@ -0,0 +1,123 @@
+#include "atomic.hpp"
+#include "monitor.hpp"
+#include "thread.hpp"
+#include "callable/frame.hpp"
+#include "utils/errors.hpp"
+#include "spimp/error.hpp"
+#include "spimp/utils.hpp"
+#include <mutex>
+
+namespace spade::atomics
+{
+    /**
+     * @return true if @p a and @p b are the same object, or equal values if either is not an object
+     */
+    static bool same(Value a, Value b) {
+        if (a.is_obj() && b.is_obj())
+            return a.as_obj() == b.as_obj();
+        return (a == b).truth();
+    }
+
+    /**
+     * Performs @p op on a location, which is read by @p get, written by @p set
+     * and updated atomically by @p update with a function computing the new value
+     */
+    template<typename Get, typename Set, typename Update>
+    static void perform(ThreadState &state, AtomicOp op, Get get, Set set, Update update) {
+        switch (op) {
+        case AtomicOp::LOAD:
+            state.push(get());
+            break;
+        case AtomicOp::STORE:
+            set(state.peek());
+            break;
+        case AtomicOp::CAS: {
+            const auto desired = state.pop();
+            const auto expected = state.pop();
+            bool swapped = false;
+            update([&](Value current) -> std::optional<Value> {
+                if (!same(current, expected))
+                    return std::nullopt;
+                swapped = true;
+                return desired;
+            });
+            state.push(Value(swapped));
+            break;
+        }
+        case AtomicOp::ADD:
+        case AtomicOp::SUB: {
+            const auto delta = state.pop();
+            Value old;
+            update([&](Value current) -> std::optional<Value> {
+                old = current;
+                return op == AtomicOp::ADD ? current + delta : current - delta;
+            });
+            state.push(old);
+            break;
+        }
+        }
+    }
+
+    /**
+     * Performs @p op on the location read by @p get and written by @p set while holding @p lock
+     */
+    template<typename Get, typename Set>
+    static void perform(ThreadState &state, AtomicOp op, SpinLock &lock, Get get, Set set) {
+        const auto locked_get = [&] {
+            std::lock_guard lk(lock);
+            return get();
+        };
+        const auto locked_set = [&](Value value) {
+            std::lock_guard lk(lock);
+            set(value);
+        };
+        perform(state, op, locked_get, locked_set, [&](const auto &func) {
+            std::lock_guard lk(lock);
+            if (const auto value = func(get()))
+                set(*value);
+        });
+    }
+
+    void on_member(ThreadState &state, AtomicOp op, Obj *object, const ObjString *name) {
+        if (op == AtomicOp::CAS)
+            // The desired value is stored with the member slots locked, so it is published beforehand
+            object->publish_stored(state.peek());
+        perform(
+                state, op, [&] { return object->get_member(name); }, [&](Value value) { object->set_member(name, value); },
+                [&](const auto &func) { object->update_member(name, func); });
+    }
+
+    void on_element(ThreadState &state, AtomicOp op, ObjArray *array, Value index) {
+        size_t i;
+        if (index.is_uint())
+            i = index.as_uint();
+        else if (index.is_int()) {
+            const auto signed_index = index.as_int();
+            if (signed_index < 0 && static_cast<size_t>(-signed_index) > array->count())
+                throw IndexError("array", signed_index);
+            i = signed_index < 0 ? array->count() + signed_index : signed_index;
+        } else
+            throw Unreachable();
+        if (i >= array->count())
+            throw IndexError("array", i);
+        if (op == AtomicOp::CAS)
+            // Publishing walks the objects reachable from the value, which is better done with the elements unlocked
+            array->publish_stored(state.peek());
+        perform(
+                state, op, [&] { return array->get(i); }, [&](Value value) { array->set(i, value); },
+                [&](const auto &func) { array->update(i, func); });
+    }
+
+    void on_local(ThreadState &state, AtomicOp op, const Frame &frame, uint16_t i) {
+        if (i >= frame.get_locals_count())
+            throw IndexError("local", i);
+        auto &local = frame.stack[frame.get_args_count() + i];
+        if (local.is_obj() && local.as_obj()->get_tag() == OBJ_CAPTURE) {
+            const auto capture = cast<ObjCapture>(local.as_obj());
+            perform(
+                    state, op, AtomicLockTable::get().get(capture, 0), [&] { return capture->get(); },
+                    [&](Value value) { capture->set(value); });
+        } else
+            perform(state, op, AtomicLockTable::get().get(&local, 0), [&] { return local; }, [&](Value value) { local = value; });
+    }
+}    // namespace spade::atomics
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "obj.hpp"
+
+namespace spade
+{
+    class ThreadState;
+    class Frame;
+
+    enum class AtomicOp {
+        /// Pushes the value of the location, loaded with acquire order
+        LOAD,
+        /// Stores the value on top of the stack into the location with release order, the value stays on the stack
+        STORE,
+        /// Pops the desired value and the expected value, stores the desired value if the location holds the expected value
+        /// and pushes whether it was stored. Objects are compared by identity, the other values by equality
+        CAS,
+        /// Pops the delta, adds it to the value of the location and pushes the previous value
+        ADD,
+        /// Pops the delta, subtracts it from the value of the location and pushes the previous value
+        SUB,
+    };
+}    // namespace spade
+
+namespace spade::atomics
+{
+    /*
+     * The atomic instructions on members, array elements and locals.
+     * A member or an element is updated with the member slots or the elements of its object locked,
+     * which are the locks taken by every access of it, so the atomic instructions on them are atomic
+     * with respect to the plain loads and stores as well. This also keeps an element in place while
+     * its array grows or boxes its elements. A local is guarded by a lock of the AtomicLockTable,
+     * so the atomic instructions on it are atomic with respect to each other only.
+     */
+
+    /**
+     * Performs @p op on the member @p name of @p object, the operands of @p op are on the stack of @p state
+     * @throws IllegalAccessError if @p object has no such member
+     * @param state the state of the current thread
+     * @param op the operation
+     * @param object the object
+     * @param name the interned name of the member
+     */
+    SWAN_EXPORT void on_member(ThreadState &state, AtomicOp op, Obj *object, const ObjString *name);
+
+    /**
+     * Performs @p op on the element at @p index of @p array, the operands of @p op are on the stack of @p state.
+     * A view shares the locations of the array it views
+     * @throws IndexError if @p index is out of bounds
+     * @param state the state of the current thread
+     * @param op the operation
+     * @param array the array
+     * @param index the index, which can be negative to count from the end
+     */
+    SWAN_EXPORT void on_element(ThreadState &state, AtomicOp op, ObjArray *array, Value index);
+
+    /**
+     * Performs @p op on the local @p i of @p frame, the operands of @p op are on the stack of @p state.
+     * A captured local is shared with the closures capturing it, so the operation is performed on its capture
+     * @throws IndexError if @p i is out of bounds
+     * @param state the state of the current thread
+     * @param op the operation
+     * @param frame the frame
+     * @param i the index of the local
+     */
+    SWAN_EXPORT void on_local(ThreadState &state, AtomicOp op, const Frame &frame, uint16_t i);
+}    // namespace spade::atomics
@@ -0,0 +1,241 @@
+#include "channel.hpp"
+#include "vm.hpp"
+#include "memory/memory.hpp"
+#include <thread>
+
+namespace spade
+{
+    ObjChannel::ObjChannel(SpadeVM *vm, size_t capacity)
+        : Obj(OBJ_CHANNEL), vm(vm), capacity(capacity), slots(std::make_unique<Slot[]>(capacity)) {
+        for (size_t i = 0; i < capacity; i++) slots[i].seq.store(2 * i, std::memory_order_relaxed);
+    }
+
+    size_t ObjChannel::count() const {
+        const auto received = receive_pos.load(std::memory_order_acquire);
+        const auto sent = send_pos.load(std::memory_order_acquire);
+        return sent > received ? sent - received : 0;
+    }
+
+    ObjChannel::Result ObjChannel::try_send(Value value) {
+        // The value is received by another thread, this also covers the value of a parked sender
+        publish(value);
+        const auto result = offer(value);
+        if (result == Result::OK)
+            wake();
+        return result;
+    }
+
+    ObjChannel::Result ObjChannel::try_receive(Value &value) {
+        const auto result = poll(value);
+        if (result == Result::OK)
+            wake();
+        return result;
+    }
+
+    void ObjChannel::send(ObjTask *task, Value value) {
+        if (try_send(value) == Result::OK) {
+            finish(task, Value());
+            return;
+        }
+        std::lock_guard lk(mtx);
+        // Announce the sender before trying again, so a receiver either sees it or leaves room for the value
+        waiting.fetch_add(1, std::memory_order_seq_cst);
+        senders.push_back({task, value});
+        dispatch();
+    }
+
+    void ObjChannel::receive(ObjTask *task) {
+        Value value;
+        switch (try_receive(value)) {
+        case Result::OK:
+            finish(task, value);
+            return;
+        case Result::CLOSED:
+            finish(task, Value());
+            return;
+        case Result::WOULD_BLOCK:
+            break;
+        }
+        std::lock_guard lk(mtx);
+        waiting.fetch_add(1, std::memory_order_seq_cst);
+        receivers.push_back(task);
+        dispatch();
+    }
+
+    bool ObjChannel::select(ObjTask *task, const std::shared_ptr<std::atomic<SelectState>> &state, size_t index) {
+        std::lock_guard lk(mtx);
+        // Drop the selectors fired by other channels, which would pile up on a channel that stays empty
+        const auto stale = std::erase_if(selectors, [](const Selector &selector) { return *selector.state == SelectState::FIRED; });
+        waiting.fetch_sub(stale, std::memory_order_relaxed);
+        waiting.fetch_add(1, std::memory_order_seq_cst);
+        selectors.push_back({task, state, index});
+        dispatch();
+        return *state == SelectState::FIRED;
+    }
+
+    void ObjChannel::close() {
+        std::lock_guard lk(mtx);
+        closed.store(true, std::memory_order_release);
+        dispatch();
+    }
+
+    void ObjChannel::for_each_channel_reference(const std::function<void(Obj *)> &func) const {
+        for (size_t i = 0; i < capacity; i++)
+            if (slots[i].value.is_obj())
+                func(slots[i].value.as_obj());
+        std::lock_guard lk(mtx);
+        for (const auto task: receivers) func(task);
+        for (const auto &[task, value]: senders) {
+            func(task);
+            if (value.is_obj())
+                func(value.as_obj());
+        }
+        for (const auto &selector: selectors) func(selector.task);
+    }
+
+    string ObjChannel::to_string() const {
+        if (is_closed())
+            return std::format("<channel {}/{} closed>", count(), capacity);
+        return std::format("<channel {}/{}>", count(), capacity);
+    }
+
+    ObjChannel::Result ObjChannel::offer(Value value) {
+        if (is_closed())
+            return Result::CLOSED;
+        return enqueue(value) ? Result::OK : Result::WOULD_BLOCK;
+    }
+
+    ObjChannel::Result ObjChannel::poll(Value &value) {
+        if (dequeue(value))
+            return Result::OK;
+        if (!is_closed())
+            return Result::WOULD_BLOCK;
+        // A value sent just before the channel was closed must not be lost
+        return dequeue(value) ? Result::OK : Result::CLOSED;
+    }
+
+    bool ObjChannel::enqueue(Value value) {
+        auto pos = send_pos.load(std::memory_order_relaxed);
+        while (true) {
+            auto &slot = slots[pos % capacity];
+            const auto seq = slot.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(2 * pos);
+            if (diff == 0) {
+                if (send_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.seq.store(2 * pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0)
+                return false;    // The slot still holds the value sent a lap before, so the channel is full
+            else
+                pos = send_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool ObjChannel::dequeue(Value &value) {
+        auto pos = receive_pos.load(std::memory_order_relaxed);
+        while (true) {
+            auto &slot = slots[pos % capacity];
+            const auto seq = slot.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(2 * pos + 1);
+            if (diff == 0) {
+                if (receive_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = slot.value;
+                    // Clear the slot so that the received value is not kept alive by the channel
+                    slot.value = Value();
+                    slot.seq.store(2 * (pos + capacity), std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0)
+                return false;    // The slot is not filled yet, so the channel is empty
+            else
+                pos = receive_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    void ObjChannel::wake() {
+        // Pairs with the announcement of the parked operations, so either side sees the other
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) == 0)
+            return;
+        std::lock_guard lk(mtx);
+        dispatch();
+    }
+
+    void ObjChannel::dispatch() {
+        // Every received value may make room for a parked sender and every sent value may serve a parked receiver
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            Value value;
+            while (!receivers.empty() && dequeue(value)) {
+                finish(receivers.front(), value);
+                receivers.pop_front();
+                waiting.fetch_sub(1, std::memory_order_relaxed);
+                progress = true;
+            }
+            while (!selectors.empty() && count() > 0) {
+                const auto selector = selectors.front();
+                if (claim(selector)) {
+                    if (!dequeue(value)) {
+                        // A receiver on the fast path took the value first
+                        *selector.state = SelectState::WAITING;
+                        break;
+                    }
+                    fire(selector, value);
+                    progress = true;
+                }
+                selectors.erase(selectors.begin());
+                waiting.fetch_sub(1, std::memory_order_relaxed);
+            }
+            while (!senders.empty() && !is_closed() && enqueue(senders.front().value)) {
+                finish(senders.front().task, Value());
+                senders.pop_front();
+                waiting.fetch_sub(1, std::memory_order_relaxed);
+                progress = true;
+            }
+        }
+        if (is_closed()) {
+            for (const auto task: receivers) finish(task, Value());
+            for (const auto &[task, _]: senders)
+                finish(task, halloc_mgr<ObjString>(vm->get_memory_manager(), string("channel is closed")), true);
+            // A value sent just before the channel was closed must not be lost, the selectors get null once it is empty
+            for (const auto &selector: selectors) {
+                if (claim(selector)) {
+                    Value value;
+                    dequeue(value);
+                    fire(selector, value);
+                }
+            }
+            waiting.fetch_sub(receivers.size() + senders.size() + selectors.size(), std::memory_order_relaxed);
+            receivers.clear();
+            senders.clear();
+            selectors.clear();
+        }
+    }
+
+    bool ObjChannel::claim(const Selector &selector) {
+        auto expected = SelectState::WAITING;
+        // Another channel claims a select only while it tries to receive a value, so it is released shortly
+        while (!selector.state->compare_exchange_weak(expected, SelectState::CLAIMED)) {
+            if (expected == SelectState::FIRED)
+                return false;
+            expected = SelectState::WAITING;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void ObjChannel::fire(const Selector &selector, Value value) {
+        *selector.state = SelectState::FIRED;
+        const auto result = halloc_mgr<ObjArray>(vm->get_memory_manager(), size_t{2}, ObjArray::ElementKind::VALUE);
+        result->set(size_t{0}, Value(static_cast<int64_t>(selector.index)));
+        result->set(size_t{1}, value);
+        finish(selector.task, result);
+    }
+
+    void ObjChannel::finish(ObjTask *task, Value value, bool thrown) {
+        vm->get_scheduler()->complete(task, value, thrown);
+    }
+}    // namespace spade
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "obj.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace spade
+{
+    class SpadeVM;
+    class ObjTask;
+
+    /**
+     * Represents a bounded multi producer multi consumer queue used to pass values between threads and tasks.
+     * The values are kept in a ring buffer whose slots carry sequence numbers, so sending to a channel which is not full
+     * and receiving from a channel which is not empty does not take any lock.
+     * The blocking operations finish pending tasks of the Scheduler once they complete, so a task joining them
+     * is suspended without blocking its worker thread and a vm thread joining them blocks until they complete.
+     * Null cannot be sent, a closed channel which is empty yields null to its receivers.
+     */
+    class SWAN_EXPORT ObjChannel final : public Obj {
+      public:
+        enum class Result {
+            /// The value was sent or received
+            OK,
+            /// The channel is full for a sender or empty for a receiver
+            WOULD_BLOCK,
+            /// The channel is closed, and also empty for a receiver
+            CLOSED,
+        };
+
+        /// State of a select, which is shared by its channels
+        enum class SelectState : uint8_t {
+            /// No channel has finished the select yet
+            WAITING,
+            /// A channel is receiving a value for the select, it either finishes the select or puts it back to waiting
+            CLAIMED,
+            /// A channel has finished the select
+            FIRED,
+        };
+
+      private:
+        struct Slot {
+            /// Twice the position of the next value of the slot if it is empty, twice the position of its value plus one if it is full.
+            /// The positions are doubled so that the states of a channel of capacity one are distinct
+            std::atomic<size_t> seq;
+            Value value;
+        };
+
+        struct Sender {
+            ObjTask *task;
+            Value value;
+        };
+
+        struct Selector {
+            ObjTask *task;
+            /// Shared by the channels of a select, fired by the first channel which receives a value for it
+            std::shared_ptr<std::atomic<SelectState>> state;
+            /// The index of this channel in the select
+            size_t index;
+        };
+
+        SpadeVM *vm;
+        size_t capacity;
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<size_t> send_pos = 0;
+        alignas(64) std::atomic<size_t> receive_pos = 0;
+        std::atomic<bool> closed = false;
+        /// Number of the parked senders, receivers and selectors, the lock is only taken by the fast path if it is not zero
+        std::atomic<size_t> waiting = 0;
+        mutable std::mutex mtx;
+        std::deque<ObjTask *> receivers;
+        std::deque<Sender> senders;
+        vector<Selector> selectors;
+
+      public:
+        /**
+         * Creates an open channel
+         * @param vm the vm whose scheduler finishes the parked operations
+         * @param capacity the number of values the channel can hold, which must be positive
+         */
+        ObjChannel(SpadeVM *vm, size_t capacity);
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_CHANNEL;
+        }
+
+        size_t get_capacity() const {
+            return capacity;
+        }
+
+        /**
+         * @return the number of values in the channel, which may be outdated once it is returned
+         */
+        size_t count() const;
+
+        bool is_closed() const {
+            return closed.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Sends @p value if the channel is neither full nor closed
+         * @param value the value, which must not be null
+         * @return the result of the operation
+         */
+        Result try_send(Value value);
+
+        /**
+         * Receives a value if the channel is not empty
+         * @param value set to the received value
+         * @return the result of the operation
+         */
+        Result try_receive(Value &value);
+
+        /**
+         * Sends @p value and finishes @p task with null once it is sent.
+         * If the channel is closed before the value is sent, @p task is finished with a thrown message
+         * @param task the pending task
+         * @param value the value, which must not be null
+         */
+        void send(ObjTask *task, Value value);
+
+        /**
+         * Receives a value and finishes @p task with it, or with null if the channel is closed and empty
+         * @param task the pending task
+         */
+        void receive(ObjTask *task);
+
+        /**
+         * Receives a value and finishes @p task with an array of @p index and the value, unless another channel
+         * of the select fires @p state first. If the channel is closed and empty the value is null
+         * @param task the pending task
+         * @param state the state shared by the channels of the select
+         * @param index the index of this channel in the select
+         * @return true if the select has fired, in which case it need not wait for the other channels
+         */
+        bool select(ObjTask *task, const std::shared_ptr<std::atomic<SelectState>> &state, size_t index);
+
+        /**
+         * Closes the channel. The values already sent can still be received, the parked senders fail
+         */
+        void close();
+
+        /**
+         * Calls @p func for the values in the channel and the parked operations
+         * @param func the function to be called
+         */
+        void for_each_channel_reference(const std::function<void(Obj *)> &func) const;
+
+        Obj *copy() const {
+            return (Obj *) this;
+        }
+
+        bool truth() const {
+            return true;
+        }
+
+        string to_string() const;
+
+      private:
+        /// Sends @p value without waking the parked operations
+        Result offer(Value value);
+
+        /// Receives a value without waking the parked operations
+        Result poll(Value &value);
+
+        bool enqueue(Value value);
+
+        bool dequeue(Value &value);
+
+        /// Completes the parked operations after a value is sent or received by the fast path
+        void wake();
+
+        /// Completes the parked operations which can proceed, must be called with mtx held
+        void dispatch();
+
+        /**
+         * Claims @p selector for this channel, waiting for another channel claiming it meanwhile
+         * @return false if the select has fired already
+         */
+        static bool claim(const Selector &selector);
+
+        /// Finishes the select of @p selector with @p value received from this channel
+        void fire(const Selector &selector, Value value);
+
+        void finish(ObjTask *task, Value value, bool thrown = false);
+    };
+}    // namespace spade
@@ -0,0 +1,102 @@
+#include "hashtable.hpp"
+#include "obj.hpp"
+#include "spimp/error.hpp"
+#include "spimp/utils.hpp"
+#include <boost/container_hash/hash_fwd.hpp>
+
+namespace spade
+{
+    bool ValueEqual::operator()(Value lhs, Value rhs) const {
+        if (lhs.get_tag() != rhs.get_tag())
+            return false;
+        switch (lhs.get_tag()) {
+        case VALUE_NULL:
+            return true;
+        case VALUE_BOOL:
+            return lhs.as_bool() == rhs.as_bool();
+        case VALUE_CHAR:
+            return lhs.as_char() == rhs.as_char();
+        case VALUE_INT:
+            return lhs.as_int() == rhs.as_int();
+        case VALUE_UINT:
+            return lhs.as_uint() == rhs.as_uint();
+        case VALUE_FLOAT:
+            return lhs.as_float() == rhs.as_float();
+        case VALUE_OBJ: {
+            const auto lhs_obj = lhs.as_obj();
+            const auto rhs_obj = rhs.as_obj();
+
+            if (lhs_obj->get_tag() != rhs_obj->get_tag())
+                return false;
+            switch (lhs_obj->get_tag()) {
+            case OBJ_STRING: {
+                const auto lhs_str = cast<ObjString>(lhs_obj);
+                const auto rhs_str = cast<ObjString>(rhs_obj);
+                // Interned strings are only equal to themselves
+                if (lhs_str == rhs_str)
+                    return true;
+                if (lhs_str->is_interned() && rhs_str->is_interned())
+                    return false;
+                return lhs_str->size() == rhs_str->size() && lhs_str->view() == rhs_str->view();
+            }
+            case OBJ_ARRAY: {
+                const auto lhs_arr = cast<ObjArray>(lhs_obj);
+                const auto rhs_arr = cast<ObjArray>(rhs_obj);
+                if (lhs_arr->count() != rhs_arr->count())
+                    return false;
+                for (size_t i = 0; i < lhs_arr->count(); i++) {
+                    if (!ValueEqual()(lhs_arr->get(i), rhs_arr->get(i)))
+                        return false;
+                }
+                return true;
+            }
+            case OBJ_OBJECT:
+            case OBJ_MODULE:
+            case OBJ_FOREIGN:
+            case OBJ_METHOD:
+            case OBJ_TYPE:
+            case OBJ_CAPTURE:
+            case OBJ_MAP:
+            case OBJ_SET:
+            case OBJ_GENERATOR:
+            case OBJ_TASK:
+            case OBJ_CHANNEL:
+                return lhs_obj == rhs_obj;
+            }
+        }
+        }
+        throw Unreachable();
+    }
+
+    void ValueHash::hash(size_t &seed, Value value) const {
+        boost::hash_combine(seed, value.get_tag());
+        switch (value.get_tag()) {
+        case VALUE_NULL:
+            break;
+        case VALUE_BOOL:
+            boost::hash_combine(seed, value.as_bool());
+            break;
+        case VALUE_CHAR:
+            boost::hash_combine(seed, value.as_char());
+            break;
+        case VALUE_INT:
+            boost::hash_combine(seed, value.as_int());
+            break;
+        case VALUE_UINT:
+            boost::hash_combine(seed, value.as_uint());
+            break;
+        case VALUE_FLOAT:
+            boost::hash_combine(seed, value.as_float());
+            break;
+        case VALUE_OBJ:
+            boost::hash_combine(seed, value.as_obj()->hash());
+            break;
+        }
+    }
+
+    size_t ValueHash::operator()(Value value) const {
+        size_t seed = 0;
+        hash(seed, value);
+        return seed;
+    }
+}    // namespace spade
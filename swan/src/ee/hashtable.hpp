@@ -0,0 +1,258 @@
+#pragma once
+
+#include "ee/value.hpp"
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#    include <emmintrin.h>
+#    define SWAN_HASHTABLE_SSE2
+#endif
+
+namespace spade
+{
+    /**
+     * Equality of values used by the hash tables of the vm.
+     * Primitives are equal if their tags and contents are equal, strings and arrays
+     * are compared by their contents and the other objects by their identity
+     */
+    struct SWAN_EXPORT ValueEqual {
+        bool operator()(Value lhs, Value rhs) const;
+    };
+
+    /**
+     * Hash of values which is consistent with ValueEqual
+     */
+    struct SWAN_EXPORT ValueHash {
+        void hash(size_t &seed, Value value) const;
+        size_t operator()(Value value) const;
+    };
+
+    /**
+     * An open addressing hash table of values laid out like a swiss table.
+     * The slots are divided into groups of 16 and each slot has a control byte which is either empty, deleted
+     * or holds 7 bits of the hash of the key in the slot. A lookup matches the control bytes of a whole group
+     * against the hash at once and only compares the keys of the matching slots. The groups are probed
+     * quadratically until a group with an empty slot is found. The table grows when it is 7/8 full.
+     * The table is not synchronized, its owner locks around it.
+     * @tparam Slot Value if the table is a set, std::pair of the key and the value if the table is a map
+     */
+    template<typename Slot>
+    class ValueTable {
+        static constexpr const size_t GROUP_WIDTH = 16;
+        static constexpr const int8_t CTRL_EMPTY = -128;
+        static constexpr const int8_t CTRL_DELETED = -2;
+
+        std::unique_ptr<int8_t[]> ctrl;
+        std::unique_ptr<Slot[]> slots;
+        /// Number of slots, either zero or a power of two multiple of GROUP_WIDTH
+        size_t capacity = 0;
+        /// Number of keys in the table
+        size_t size = 0;
+        /// Number of keys which can be inserted into empty slots before the table grows
+        size_t growth_left = 0;
+
+      public:
+        ValueTable() = default;
+
+        ValueTable(const ValueTable &) = delete;
+        ValueTable(ValueTable &&) = default;
+        ValueTable &operator=(const ValueTable &) = delete;
+        ValueTable &operator=(ValueTable &&) = default;
+        ~ValueTable() = default;
+
+        size_t count() const {
+            return size;
+        }
+
+        /**
+         * @return the number of bytes used by the slots and the control bytes
+         */
+        size_t get_storage_size() const {
+            return capacity * (sizeof(Slot) + sizeof(int8_t));
+        }
+
+        /**
+         * @param key the key
+         * @return the slot holding @p key, null if the table does not contain @p key
+         */
+        Slot *find(Value key) const {
+            if (size == 0)
+                return null;
+            const auto hash = hash_of(key);
+            const auto group_mask = capacity / GROUP_WIDTH - 1;
+            auto group = hash >> 7 & group_mask;
+            for (size_t step = 1;; step++) {
+                const auto base = group * GROUP_WIDTH;
+                for (auto mask = match(ctrl.get() + base, h2_of(hash)); mask != 0; mask &= mask - 1) {
+                    const auto i = base + std::countr_zero(mask);
+                    if (ValueEqual()(key_of(slots[i]), key))
+                        return &slots[i];
+                }
+                if (match(ctrl.get() + base, CTRL_EMPTY) != 0)
+                    return null;
+                group = (group + step) & group_mask;
+            }
+        }
+
+        /**
+         * Finds the slot of @p key, inserting @p key if the table does not contain it
+         * @param key the key
+         * @return the slot of @p key and true if @p key was inserted
+         */
+        std::pair<Slot *, bool> insert(Value key) {
+            if (const auto slot = find(key))
+                return {slot, false};
+            if (growth_left == 0) {
+                // Rehash in place if the table is mostly full of deleted slots
+                rehash(capacity == 0 ? GROUP_WIDTH : size >= max_load(capacity) / 2 ? capacity * 2 : capacity);
+            }
+            const auto hash = hash_of(key);
+            const auto i = find_free(hash);
+            if (ctrl[i] == CTRL_EMPTY)
+                growth_left--;
+            ctrl[i] = h2_of(hash);
+            slots[i] = Slot();
+            key_of(slots[i]) = key;
+            size++;
+            return {&slots[i], true};
+        }
+
+        /**
+         * Removes @p key from the table
+         * @param key the key
+         * @return true if the table contained @p key
+         */
+        bool erase(Value key) {
+            const auto slot = find(key);
+            if (!slot)
+                return false;
+            const size_t i = slot - slots.get();
+            // A probe stops at a group with an empty slot,
+            // so the slot can be emptied only if its group already stops the probes
+            if (match(ctrl.get() + i / GROUP_WIDTH * GROUP_WIDTH, CTRL_EMPTY) != 0) {
+                ctrl[i] = CTRL_EMPTY;
+                growth_left++;
+            } else
+                ctrl[i] = CTRL_DELETED;
+            slots[i] = Slot();
+            size--;
+            return true;
+        }
+
+        void clear() {
+            std::fill_n(ctrl.get(), capacity, CTRL_EMPTY);
+            std::fill_n(slots.get(), capacity, Slot());
+            size = 0;
+            growth_left = max_load(capacity);
+        }
+
+        /**
+         * Ensures that @p count keys can be held without growing the table
+         * @param count the number of keys
+         */
+        void reserve(size_t count) {
+            if (count <= size + growth_left)
+                return;
+            size_t new_capacity = std::max(capacity, GROUP_WIDTH);
+            while (max_load(new_capacity) < count) new_capacity *= 2;
+            rehash(new_capacity);
+        }
+
+        template<typename F>
+        void for_each(F &&func) const {
+            for (size_t i = 0; i < capacity; i++)
+                if (ctrl[i] >= 0)
+                    func(slots[i]);
+        }
+
+      private:
+        static size_t max_load(size_t capacity) {
+            return capacity - capacity / 8;
+        }
+
+        static Value &key_of(Value &slot) {
+            return slot;
+        }
+
+        static Value &key_of(std::pair<Value, Value> &slot) {
+            return slot.first;
+        }
+
+        static uint64_t hash_of(Value key) {
+            // The hashes of small integers differ only in their lower bits, so mix them
+            uint64_t hash = ValueHash()(key);
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        static int8_t h2_of(uint64_t hash) {
+            return static_cast<int8_t>(hash & 0x7F);
+        }
+
+        /// @return the mask of the control bytes in @p group which are equal to @p byte
+        static uint32_t match(const int8_t *group, int8_t byte) {
+#ifdef SWAN_HASHTABLE_SSE2
+            const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte))));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++)
+                if (group[i] == byte)
+                    mask |= 1u << i;
+            return mask;
+#endif
+        }
+
+        /// @return the mask of the empty or deleted control bytes in @p group
+        static uint32_t match_free(const int8_t *group) {
+#ifdef SWAN_HASHTABLE_SSE2
+            // Only the empty and deleted control bytes have their sign bit set
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++)
+                if (group[i] < 0)
+                    mask |= 1u << i;
+            return mask;
+#endif
+        }
+
+        /// @return the index of the first free slot in the probe sequence of @p hash
+        size_t find_free(uint64_t hash) const {
+            const auto group_mask = capacity / GROUP_WIDTH - 1;
+            auto group = hash >> 7 & group_mask;
+            for (size_t step = 1;; step++) {
+                const auto base = group * GROUP_WIDTH;
+                if (const auto mask = match_free(ctrl.get() + base))
+                    return base + std::countr_zero(mask);
+                group = (group + step) & group_mask;
+            }
+        }
+
+        void rehash(size_t new_capacity) {
+            auto old_ctrl = std::move(ctrl);
+            auto old_slots = std::move(slots);
+            const auto old_capacity = capacity;
+
+            ctrl = std::make_unique<int8_t[]>(new_capacity);
+            std::fill_n(ctrl.get(), new_capacity, CTRL_EMPTY);
+            slots = std::make_unique<Slot[]>(new_capacity);
+            capacity = new_capacity;
+            growth_left = max_load(new_capacity) - size;
+
+            for (size_t i = 0; i < old_capacity; i++) {
+                if (old_ctrl[i] < 0)
+                    continue;
+                const auto hash = hash_of(key_of(old_slots[i]));
+                const auto j = find_free(hash);
+                ctrl[j] = h2_of(hash);
+                slots[j] = std::move(old_slots[i]);
+            }
+        }
+    };
+}    // namespace spade
@@ -0,0 +1,50 @@
+#include "intern.hpp"
+#include "memory/memory.hpp"
+#include <mutex>
+#include <shared_mutex>
+
+namespace spade
+{
+    ObjString *InternTable::intern(MemoryManager *manager, std::string_view str) {
+        if (const auto interned = find(str))
+            return interned;
+
+        // Allocate outside the lock, since the allocation can collect and the collector visits the table
+        const auto candidate = halloc_mgr<ObjString>(manager, string(str));
+        candidate->hash();
+        // Interned strings are shared by every thread
+        candidate->publish();
+
+        std::unique_lock lk(lock);
+        if (const auto it = strings.find(str); it != strings.end())
+            return it->second;
+        atoms.push_back(candidate);
+        candidate->atom = atoms.size();
+        strings.emplace(candidate->value(), candidate);
+        return candidate;
+    }
+
+    ObjString *InternTable::find(std::string_view str) const {
+        std::shared_lock lk(lock);
+        if (const auto it = strings.find(str); it != strings.end())
+            return it->second;
+        return null;
+    }
+
+    ObjString *InternTable::get(uint32_t atom) const {
+        std::shared_lock lk(lock);
+        if (atom == 0 || atom > atoms.size())
+            return null;
+        return atoms[atom - 1];
+    }
+
+    size_t InternTable::count() const {
+        std::shared_lock lk(lock);
+        return atoms.size();
+    }
+
+    void InternTable::for_each(const std::function<void(Obj *)> &func) const {
+        std::shared_lock lk(lock);
+        for (const auto str: atoms) func(str);
+    }
+}    // namespace spade
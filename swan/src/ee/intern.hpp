@@ -0,0 +1,60 @@
+#pragma once
+
+#include "obj.hpp"
+#include <string_view>
+
+namespace spade
+{
+    /**
+     * The table of the canonical strings of the vm.
+     * Interning gives a single ObjString for each distinct content, which gets an atom id and a precomputed hash.
+     * Two interned strings are therefore equal only if they are the same object. The interned strings are roots
+     * of the vm, so they live as long as the vm does.
+     */
+    class SWAN_EXPORT InternTable {
+        /// The interned strings by their contents, the keys view the contents of the strings themselves
+        std::unordered_map<std::string_view, ObjString *> strings;
+        /// The interned strings by their atom id minus one
+        vector<ObjString *> atoms;
+        mutable SpinRwLock lock;
+
+      public:
+        InternTable() = default;
+
+        InternTable(const InternTable &other) = delete;
+        InternTable(InternTable &&other) noexcept = delete;
+        InternTable &operator=(const InternTable &other) = delete;
+        InternTable &operator=(InternTable &&other) noexcept = delete;
+        ~InternTable() = default;
+
+        /**
+         * @param manager the memory manager used to allocate the string if it is not interned yet
+         * @param str the contents of the string
+         * @return the canonical string of @p str
+         */
+        ObjString *intern(MemoryManager *manager, std::string_view str);
+
+        /**
+         * @param str the contents of the string
+         * @return the canonical string of @p str, null if @p str is not interned
+         */
+        ObjString *find(std::string_view str) const;
+
+        /**
+         * @param atom the atom id
+         * @return the interned string with the atom id @p atom, null if there is none
+         */
+        ObjString *get(uint32_t atom) const;
+
+        /**
+         * @return the number of interned strings
+         */
+        size_t count() const;
+
+        /**
+         * Calls @p func for every interned string
+         * @param func the function to be called
+         */
+        void for_each(const std::function<void(Obj *)> &func) const;
+    };
+}    // namespace spade
@@ -0,0 +1,397 @@
+#include "io.hpp"
+#include "vm.hpp"
+#include "memory/memory.hpp"
+#include "utils/errors.hpp"
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#ifdef OS_LINUX
+#    include <arpa/inet.h>
+#    include <fcntl.h>
+#    include <netinet/in.h>
+#    include <sys/epoll.h>
+#    include <sys/eventfd.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+
+namespace spade
+{
+#ifdef OS_LINUX
+    /// Number of events handled by one wake up of the loop thread
+    static constexpr const int MAX_EVENTS = 64;
+
+    static bool would_block(int error) {
+        return error == EAGAIN || error == EWOULDBLOCK;
+    }
+
+    static void check_fd(int fd) {
+        if (fcntl(fd, F_GETFL) < 0)
+            throw IllegalAccessError(std::format("cannot use file descriptor {}: {}", fd, std::strerror(errno)));
+    }
+
+    /**
+     * Makes the calls in its scope non blocking on a file descriptor.
+     * The sockets and the pipes of the loop are non blocking from their creation, so nothing is changed for them.
+     * The other file descriptors (like the standard streams) can be shared with other processes, so they are
+     * switched only for the duration of the scope and their original flags are restored afterwards
+     */
+    class NonBlockingScope {
+        int fd;
+        int flags;
+
+      public:
+        explicit NonBlockingScope(int fd) : fd(fd), flags(fcntl(fd, F_GETFL)) {
+            if (flags >= 0 && !(flags & O_NONBLOCK))
+                fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        }
+
+        NonBlockingScope(const NonBlockingScope &) = delete;
+        NonBlockingScope(NonBlockingScope &&) = delete;
+        NonBlockingScope &operator=(const NonBlockingScope &) = delete;
+        NonBlockingScope &operator=(NonBlockingScope &&) = delete;
+
+        ~NonBlockingScope() {
+            if (flags >= 0 && !(flags & O_NONBLOCK)) {
+                // Keep the errno of the call made in the scope
+                const auto error = errno;
+                fcntl(fd, F_SETFL, flags);
+                errno = error;
+            }
+        }
+    };
+
+    static sockaddr_in to_address(const string &host, uint16_t port) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+            throw IllegalAccessError(std::format("invalid address: {}", host));
+        return address;
+    }
+
+    IoLoop::IoLoop(SpadeVM *vm) : vm(vm) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wake_fd;
+        if (epoll_fd < 0 || wake_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) < 0) {
+            const auto error = errno;
+            if (epoll_fd >= 0)
+                ::close(epoll_fd);
+            if (wake_fd >= 0)
+                ::close(wake_fd);
+            throw IllegalAccessError(std::format("cannot create the io loop: {}", std::strerror(error)));
+        }
+        thread = std::thread([this] { loop_main(); });
+    }
+
+    IoLoop::~IoLoop() {
+        stopping = true;
+        const uint64_t one = 1;
+        (void) ::write(wake_fd, &one, sizeof(one));
+        thread.join();
+        ::close(wake_fd);
+        ::close(epoll_fd);
+    }
+
+    ObjTask *IoLoop::read(int fd, size_t count) {
+        check_fd(fd);
+        auto op = std::make_unique<Op>();
+        op->kind = OpKind::READ;
+        op->fd = fd;
+        op->count = count;
+        return submit(std::move(op));
+    }
+
+    ObjTask *IoLoop::write(int fd, string data) {
+        check_fd(fd);
+        auto op = std::make_unique<Op>();
+        op->kind = OpKind::WRITE;
+        op->fd = fd;
+        op->data = std::move(data);
+        return submit(std::move(op));
+    }
+
+    ObjTask *IoLoop::accept(int fd) {
+        check_fd(fd);
+        auto op = std::make_unique<Op>();
+        op->kind = OpKind::ACCEPT;
+        op->fd = fd;
+        return submit(std::move(op));
+    }
+
+    ObjTask *IoLoop::connect(const string &host, uint16_t port) {
+        const auto address = to_address(host, port);
+        const auto fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw IllegalAccessError(std::format("cannot create socket: {}", std::strerror(errno)));
+        auto op = std::make_unique<Op>();
+        op->kind = OpKind::CONNECT;
+        op->fd = fd;
+        if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0)
+            return submit(std::move(op));
+        if (errno == EINPROGRESS)
+            return submit(std::move(op), false);
+        // Report the failure through the task like the failures found later by the loop
+        fail(*op, "connect");
+        ::close(fd);
+        op->task = vm->get_scheduler()->make_pending();
+        complete(*op);
+        return op->task;
+    }
+
+    std::pair<int, int> IoLoop::pipe() {
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0)
+            throw IllegalAccessError(std::format("cannot create pipe: {}", std::strerror(errno)));
+        return {fds[0], fds[1]};
+    }
+
+    int IoLoop::open(const string &path, const string &mode) {
+        static const std::unordered_map<string, int> modes = {
+                {"r",  O_RDONLY                      },
+                {"w",  O_WRONLY | O_CREAT | O_TRUNC  },
+                {"a",  O_WRONLY | O_CREAT | O_APPEND },
+                {"r+", O_RDWR                        },
+                {"w+", O_RDWR | O_CREAT | O_TRUNC    },
+                {"a+", O_RDWR | O_CREAT | O_APPEND   },
+        };
+        const auto it = modes.find(mode);
+        if (it == modes.end())
+            throw IllegalAccessError(std::format("invalid file mode: {}", mode));
+        const auto fd = ::open(path.c_str(), it->second | O_CLOEXEC, 0666);
+        if (fd < 0)
+            throw IllegalAccessError(std::format("cannot open file {}: {}", path, std::strerror(errno)));
+        return fd;
+    }
+
+    int IoLoop::listen(const string &host, uint16_t port) {
+        const auto address = to_address(host, port);
+        const auto fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw IllegalAccessError(std::format("cannot create socket: {}", std::strerror(errno)));
+        const int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+            const auto error = errno;
+            ::close(fd);
+            throw IllegalAccessError(std::format("cannot listen on {}:{}: {}", host, port, std::strerror(error)));
+        }
+        return fd;
+    }
+
+    uint16_t IoLoop::local_port(int fd) {
+        sockaddr_in address{};
+        socklen_t length = sizeof(address);
+        if (getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) < 0 || address.sin_family != AF_INET)
+            throw IllegalAccessError(std::format("file descriptor {} is not a bound socket", fd));
+        return ntohs(address.sin_port);
+    }
+
+    void IoLoop::close(int fd) {
+        if (::close(fd) < 0)
+            throw IllegalAccessError(std::format("cannot close file descriptor {}: {}", fd, std::strerror(errno)));
+    }
+
+    ObjTask *IoLoop::submit(std::unique_ptr<Op> op, bool ready) {
+        const auto task = op->task = vm->get_scheduler()->make_pending();
+        {
+            std::lock_guard lk(mtx);
+            auto &interest = interests[op->fd];
+            auto &slot = op->kind == OpKind::READ || op->kind == OpKind::ACCEPT ? interest.reader : interest.writer;
+            if (slot) {
+                op->result = halloc_mgr<ObjString>(vm->get_memory_manager(),
+                                                   std::format("an operation is already pending on file descriptor {}", op->fd));
+                op->failed = true;
+            } else if (!ready || !perform(*op)) {
+                const auto fd = op->fd;
+                slot = std::move(op);
+                if (rearm(fd))
+                    return task;
+                // Regular files cannot be registered but they are always ready, so this is a real failure
+                op = std::move(slot);
+                fail(*op, "epoll");
+                rearm(fd);
+            } else if (!interest.reader && !interest.writer)
+                interests.erase(op->fd);
+        }
+        complete(*op);
+        return task;
+    }
+
+    bool IoLoop::perform(Op &op) {
+        while (true) {
+            // All the operations are performed with mtx held, so the scopes of a file descriptor never overlap
+            const NonBlockingScope non_blocking(op.fd);
+            switch (op.kind) {
+                case OpKind::READ: {
+                    string buffer(op.count, '\0');
+                    const auto n = ::read(op.fd, buffer.data(), buffer.size());
+                    if (n < 0)
+                        break;
+                    const auto array = halloc_mgr<ObjArray>(vm->get_memory_manager(), static_cast<size_t>(n), ObjArray::ElementKind::BYTE);
+                    if (n > 0)
+                        std::memcpy(array->get_packed<uint8_t>(), buffer.data(), n);
+                    op.result = array;
+                    return true;
+                }
+                case OpKind::WRITE: {
+                    const auto n = ::write(op.fd, op.data.data() + op.done, op.data.size() - op.done);
+                    if (n < 0)
+                        break;
+                    op.done += n;
+                    if (op.done < op.data.size())
+                        continue;
+                    op.result = Value(static_cast<int64_t>(op.done));
+                    return true;
+                }
+                case OpKind::ACCEPT: {
+                    const auto fd = accept4(op.fd, null, null, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (fd < 0)
+                        break;
+                    op.result = Value(static_cast<int64_t>(fd));
+                    return true;
+                }
+                case OpKind::CONNECT: {
+                    int error = 0;
+                    socklen_t length = sizeof(error);
+                    if (getsockopt(op.fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0)
+                        error = errno;
+                    if (error != 0) {
+                        errno = error;
+                        fail(op, "connect");
+                        ::close(op.fd);
+                        return true;
+                    }
+                    op.result = Value(static_cast<int64_t>(op.fd));
+                    return true;
+                }
+            }
+            if (errno == EINTR)
+                continue;
+            if (would_block(errno))
+                return false;
+            static constexpr const char *names[] = {"read", "write", "accept", "connect"};
+            fail(op, names[static_cast<int>(op.kind)]);
+            return true;
+        }
+    }
+
+    void IoLoop::fail(Op &op, const char *what) {
+        op.result = halloc_mgr<ObjString>(vm->get_memory_manager(), std::format("{}: {}", what, std::strerror(errno)));
+        op.failed = true;
+    }
+
+    bool IoLoop::rearm(int fd) {
+        const auto it = interests.find(fd);
+        if (it == interests.end())
+            return true;
+        const auto &[reader, writer] = it->second;
+        if (!reader && !writer) {
+            interests.erase(it);
+            // The file descriptor may have been closed already, which removes it from epoll
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, null);
+            return true;
+        }
+        epoll_event event{};
+        event.events = EPOLLONESHOT;
+        if (reader)
+            event.events |= EPOLLIN;
+        if (writer)
+            event.events |= EPOLLOUT;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0)
+            return true;
+        return errno == ENOENT && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+
+    void IoLoop::complete(const Op &op) {
+        vm->get_scheduler()->complete(op.task, op.result, op.failed);
+    }
+
+    void IoLoop::loop_main() {
+        epoll_event events[MAX_EVENTS];
+        while (!stopping) {
+            const auto n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                spdlog::error("IoLoop: Stopped after a failure: {}", std::strerror(errno));
+                break;
+            }
+            vector<std::unique_ptr<Op>> completed;
+            {
+                std::lock_guard lk(mtx);
+                for (int i = 0; i < n; i++) {
+                    const auto fd = events[i].data.fd;
+                    const auto it = interests.find(fd);
+                    if (fd == wake_fd || it == interests.end())
+                        continue;
+                    auto &[reader, writer] = it->second;
+                    // Errors and hang ups are reported by retrying the operations
+                    const auto flags = events[i].events;
+                    const auto failed = (flags & (EPOLLERR | EPOLLHUP)) != 0;
+                    if (reader && (failed || flags & EPOLLIN) && perform(*reader))
+                        completed.push_back(std::move(reader));
+                    if (writer && (failed || flags & EPOLLOUT) && perform(*writer))
+                        completed.push_back(std::move(writer));
+                    if (!rearm(fd)) {
+                        for (auto op: {&reader, &writer}) {
+                            if (!*op)
+                                continue;
+                            fail(**op, "epoll");
+                            completed.push_back(std::move(*op));
+                        }
+                        interests.erase(fd);
+                    }
+                }
+            }
+            for (const auto &op: completed) complete(*op);
+        }
+    }
+#else
+    IoLoop::IoLoop(SpadeVM *vm) : vm(vm) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    IoLoop::~IoLoop() = default;
+
+    ObjTask *IoLoop::read(int, size_t) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    ObjTask *IoLoop::write(int, string) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    ObjTask *IoLoop::accept(int) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    ObjTask *IoLoop::connect(const string &, uint16_t) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    std::pair<int, int> IoLoop::pipe() {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    int IoLoop::open(const string &, const string &) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    int IoLoop::listen(const string &, uint16_t) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    uint16_t IoLoop::local_port(int) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+
+    void IoLoop::close(int) {
+        throw IllegalAccessError("async io is not supported on this platform");
+    }
+#endif
+}    // namespace spade
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "task.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace spade
+{
+    class SpadeVM;
+
+    /**
+     * The event loop which performs the asynchronous I/O of a vm.
+     * Every operation is tried at once without blocking on the file descriptor. If the descriptor is not ready,
+     * the operation is registered with epoll and retried by the loop thread when the descriptor becomes ready.
+     * The sockets and the pipes created by the loop are non blocking, the flags of the other descriptors
+     * are changed only while an operation is tried and restored right after.
+     * The result of an operation is delivered through a pending task of the Scheduler, so a task joining it
+     * is suspended without blocking its worker thread. Regular files are always ready, so their operations
+     * complete at once.
+     *
+     * At most one reading operation (read or accept) and one writing operation (write or connect)
+     * can be pending on a file descriptor at a time.
+     */
+    class SWAN_EXPORT IoLoop {
+      public:
+        enum class OpKind { READ, WRITE, ACCEPT, CONNECT };
+
+      private:
+        struct Op {
+            OpKind kind;
+            ObjTask *task;
+            int fd;
+            /// The maximum number of bytes to read
+            size_t count = 0;
+                /// The bytes to write
+            string data;
+            /// The number of bytes written so far
+            size_t done = 0;
+            /// The result of the completed operation, or the error message if the operation has failed
+            Value result;
+            bool failed = false;
+        };
+
+        /// The pending operations of a file descriptor
+        struct Interest {
+            std::unique_ptr<Op> reader;
+            std::unique_ptr<Op> writer;
+        };
+
+        SpadeVM *vm;
+        int epoll_fd = -1;
+        /// The eventfd which wakes up the loop thread when the loop is stopped
+        int wake_fd = -1;
+        std::unordered_map<int, Interest> interests;
+        mutable std::mutex mtx;
+        std::atomic<bool> stopping = false;
+        std::thread thread;
+
+      public:
+        /**
+         * Creates the event loop and starts its thread
+         * @throws IllegalAccessError if the event loop cannot be created on this platform
+         * @param vm the vm
+         */
+        explicit IoLoop(SpadeVM *vm);
+
+        IoLoop(const IoLoop &) = delete;
+        IoLoop(IoLoop &&) = delete;
+        IoLoop &operator=(const IoLoop &) = delete;
+        IoLoop &operator=(IoLoop &&) = delete;
+
+        /**
+         * Stops the loop thread. The pending operations are abandoned
+         */
+        ~IoLoop();
+
+        /**
+         * Reads at most @p count bytes from @p fd
+         * @param fd the file descriptor
+         * @param count the maximum number of bytes
+         * @return the task finishing with the byte array read, which is empty at the end of the file
+         */
+        ObjTask *read(int fd, size_t count);
+
+        /**
+         * Writes all of @p data to @p fd
+         * @param fd the file descriptor
+         * @param data the bytes
+         * @return the task finishing with the number of bytes written
+         */
+        ObjTask *write(int fd, string data);
+
+        /**
+         * Accepts a connection on the listening socket @p fd
+         * @param fd the file descriptor of the listening socket
+         * @return the task finishing with the file descriptor of the connection
+         */
+        ObjTask *accept(int fd);
+
+        /**
+         * Connects to @p host on @p port over tcp
+         * @param host the numeric ipv4 address
+         * @param port the port
+         * @return the task finishing with the file descriptor of the connection
+         */
+        ObjTask *connect(const string &host, uint16_t port);
+
+        /**
+         * Creates a pipe
+         * @throws IllegalAccessError if the pipe cannot be created
+         * @return the file descriptors of the reading end and the writing end
+         */
+        static std::pair<int, int> pipe();
+
+        /**
+         * Opens the file at @p path
+         * @throws IllegalAccessError if the file cannot be opened
+         * @param path the path of the file
+         * @param mode the mode of fopen, which is one of "r", "w", "a", "r+", "w+" and "a+"
+         * @return the file descriptor
+         */
+        static int open(const string &path, const string &mode);
+
+        /**
+         * Creates a tcp socket listening on @p host at @p port
+         * @throws IllegalAccessError if the socket cannot be created
+         * @param host the numeric ipv4 address
+         * @param port the port, any free port if it is zero
+         * @return the file descriptor of the socket
+         */
+        static int listen(const string &host, uint16_t port);
+
+        /**
+         * @throws IllegalAccessError if @p fd is not a bound socket
+         * @param fd the file descriptor of the socket
+         * @return the local port of the socket
+         */
+        static uint16_t local_port(int fd);
+
+        /**
+         * Closes @p fd
+         * @throws IllegalAccessError if @p fd cannot be closed
+         * @param fd the file descriptor
+         */
+        static void close(int fd);
+
+      private:
+        /**
+         * Starts @p op, completing it at once if the file descriptor is ready and registering it otherwise
+         * @throws IllegalAccessError if an operation of the same direction is already pending on the file descriptor
+         * @param op the operation
+         * @param ready false if the file descriptor is known not to be ready, so @p op is registered without being tried
+         * @return the task of @p op
+         */
+        ObjTask *submit(std::unique_ptr<Op> op, bool ready = true);
+
+        /**
+         * Performs @p op as far as the file descriptor allows
+         * @return false if the file descriptor is not ready, true if the operation is completed or has failed
+         */
+        bool perform(Op &op);
+
+        /**
+         * Records the failure of @p op with the message of errno
+         */
+        void fail(Op &op, const char *what);
+
+        /**
+         * Updates the epoll registration of @p fd to its pending operations, must be called with mtx held
+         * @return false if the registration has failed, in which case errno is set
+         */
+        bool rearm(int fd);
+
+        /**
+         * Finishes the task of the completed @p op
+         */
+        void complete(const Op &op);
+
+        void loop_main();
+    };
+}    // namespace spade
@@ -0,0 +1,519 @@
+#include "kernels.hpp"
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    define SWAN_KERNELS_SSE2
+#    include <immintrin.h>
+#    if defined COMPILER_GCC || defined COMPILER_CLANG
+#        define SWAN_KERNELS_AVX2
+#        define AVX2_TARGET __attribute__((target("avx2")))
+#    endif
+#endif
+
+namespace spade::kernels
+{
+    namespace scalar
+    {
+        template<typename T>
+        static void fill(T *dst, size_t n, T value) {
+            std::fill_n(dst, n, value);
+        }
+
+        /// The integers are accumulated in uint64_t, so that overflows wrap around instead of being undefined
+        template<typename T>
+        using Accumulator = std::conditional_t<std::is_floating_point_v<T>, double, uint64_t>;
+
+        template<typename T>
+        static Accumulator<T> sum(const T *data, size_t n) {
+            Accumulator<T> result = 0;
+            for (size_t i = 0; i < n; i++) result += static_cast<Accumulator<T>>(data[i]);
+            return result;
+        }
+
+        template<typename T>
+        static T min(const T *data, size_t n) {
+            return *std::min_element(data, data + n);
+        }
+
+        template<typename T>
+        static T max(const T *data, size_t n) {
+            return *std::max_element(data, data + n);
+        }
+
+        template<typename T>
+        static Accumulator<T> dot(const T *lhs, const T *rhs, size_t n) {
+            Accumulator<T> result = 0;
+            for (size_t i = 0; i < n; i++) result += static_cast<Accumulator<T>>(lhs[i]) * static_cast<Accumulator<T>>(rhs[i]);
+            return result;
+        }
+
+        template<typename T>
+        static size_t mismatch(const T *lhs, const T *rhs, size_t n) {
+            for (size_t i = 0; i < n; i++)
+                if (lhs[i] != rhs[i])
+                    return i;
+            return n;
+        }
+
+#ifndef SWAN_KERNELS_SSE2
+        static size_t mismatch_bytes(const uint8_t *lhs, const uint8_t *rhs, size_t n) {
+            return mismatch(lhs, rhs, n);
+        }
+#endif
+    }    // namespace scalar
+
+#ifdef SWAN_KERNELS_SSE2
+    namespace sse2
+    {
+        static int64_t reduce_add(__m128i v) {
+            alignas(16) int64_t lanes[2];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), v);
+            return static_cast<int64_t>(static_cast<uint64_t>(lanes[0]) + static_cast<uint64_t>(lanes[1]));
+        }
+
+        static double reduce_add(__m128d v) {
+            alignas(16) double lanes[2];
+            _mm_store_pd(lanes, v);
+            return lanes[0] + lanes[1];
+        }
+
+        static void fill(int64_t *dst, size_t n, int64_t value) {
+            const auto v = _mm_set1_epi64x(value);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+            scalar::fill(dst + i, n - i, value);
+        }
+
+        static void fill(double *dst, size_t n, double value) {
+            const auto v = _mm_set1_pd(value);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) _mm_storeu_pd(dst + i, v);
+            scalar::fill(dst + i, n - i, value);
+        }
+
+        static int64_t sum(const int64_t *data, size_t n) {
+            auto acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                acc0 = _mm_add_epi64(acc0, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+                acc1 = _mm_add_epi64(acc1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 2)));
+            }
+            return static_cast<int64_t>(static_cast<uint64_t>(reduce_add(_mm_add_epi64(acc0, acc1))) +
+                                        scalar::sum(data + i, n - i));
+        }
+
+        static double sum(const double *data, size_t n) {
+            auto acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + i));
+                acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i + 2));
+            }
+            return reduce_add(_mm_add_pd(acc0, acc1)) + scalar::sum(data + i, n - i);
+        }
+
+        static uint64_t sum(const uint8_t *data, size_t n) {
+            // psadbw against zero sums each group of 8 bytes into a 64-bit lane
+            const auto zero = _mm_setzero_si128();
+            auto acc = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), zero));
+            return static_cast<uint64_t>(reduce_add(acc)) + scalar::sum(data + i, n - i);
+        }
+
+        static double min(const double *data, size_t n) {
+            if (n < 2)
+                return scalar::min(data, n);
+            auto acc = _mm_loadu_pd(data);
+            size_t i = 2;
+            for (; i + 2 <= n; i += 2) acc = _mm_min_pd(acc, _mm_loadu_pd(data + i));
+            alignas(16) double lanes[2];
+            _mm_store_pd(lanes, acc);
+            const auto result = std::min(lanes[0], lanes[1]);
+            return i < n ? std::min(result, scalar::min(data + i, n - i)) : result;
+        }
+
+        static double max(const double *data, size_t n) {
+            if (n < 2)
+                return scalar::max(data, n);
+            auto acc = _mm_loadu_pd(data);
+            size_t i = 2;
+            for (; i + 2 <= n; i += 2) acc = _mm_max_pd(acc, _mm_loadu_pd(data + i));
+            alignas(16) double lanes[2];
+            _mm_store_pd(lanes, acc);
+            const auto result = std::max(lanes[0], lanes[1]);
+            return i < n ? std::max(result, scalar::max(data + i, n - i)) : result;
+        }
+
+        static uint8_t min(const uint8_t *data, size_t n) {
+            if (n < 16)
+                return scalar::min(data, n);
+            auto acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+            size_t i = 16;
+            for (; i + 16 <= n; i += 16) acc = _mm_min_epu8(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+            alignas(16) uint8_t lanes[16];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+            const auto result = scalar::min(lanes, 16);
+            return i < n ? std::min(result, scalar::min(data + i, n - i)) : result;
+        }
+
+        static uint8_t max(const uint8_t *data, size_t n) {
+            if (n < 16)
+                return scalar::max(data, n);
+            auto acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+            size_t i = 16;
+            for (; i + 16 <= n; i += 16) acc = _mm_max_epu8(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+            alignas(16) uint8_t lanes[16];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+            const auto result = scalar::max(lanes, 16);
+            return i < n ? std::max(result, scalar::max(data + i, n - i)) : result;
+        }
+
+        static double dot(const double *lhs, const double *rhs, size_t n) {
+            auto acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+                acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(lhs + i + 2), _mm_loadu_pd(rhs + i + 2)));
+            }
+            return reduce_add(_mm_add_pd(acc0, acc1)) + scalar::dot(lhs + i, rhs + i, n - i);
+        }
+
+        static uint64_t dot(const uint8_t *lhs, const uint8_t *rhs, size_t n) {
+            // Widen the bytes to 16 bits, pmaddwd then yields 32-bit sums of two products
+            // which are widened again to 64 bits before they can overflow
+            const auto zero = _mm_setzero_si128();
+            auto acc = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i));
+                const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i));
+                const auto products = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                                                    _mm_madd_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+                acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(products, zero));
+                acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(products, zero));
+            }
+            return static_cast<uint64_t>(reduce_add(acc)) + scalar::dot(lhs + i, rhs + i, n - i);
+        }
+
+        /// @return the index of the first byte which differs, @p n if all the bytes are equal
+        static size_t mismatch_bytes(const uint8_t *lhs, const uint8_t *rhs, size_t n) {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                const auto eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i)));
+                if (const auto mask = ~static_cast<uint32_t>(_mm_movemask_epi8(eq)) & 0xFFFF)
+                    return i + std::countr_zero(mask);
+            }
+            return i + scalar::mismatch(lhs + i, rhs + i, n - i);
+        }
+
+        static size_t mismatch(const double *lhs, const double *rhs, size_t n) {
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                const auto eq = _mm_cmpeq_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i));
+                if (const auto mask = ~static_cast<uint32_t>(_mm_movemask_pd(eq)) & 0x3)
+                    return i + std::countr_zero(mask);
+            }
+            return i + scalar::mismatch(lhs + i, rhs + i, n - i);
+        }
+    }    // namespace sse2
+#endif
+
+#ifdef SWAN_KERNELS_AVX2
+    namespace avx2
+    {
+        static bool supported() {
+            static const bool result = __builtin_cpu_supports("avx2");
+            return result;
+        }
+
+        AVX2_TARGET static int64_t reduce_add(__m256i v) {
+            alignas(32) int64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), v);
+            return static_cast<int64_t>(scalar::sum(lanes, 4));
+        }
+
+        AVX2_TARGET static double reduce_add(__m256d v) {
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, v);
+            return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        }
+
+        AVX2_TARGET static void fill(int64_t *dst, size_t n, int64_t value) {
+            const auto v = _mm256_set1_epi64x(value);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+            scalar::fill(dst + i, n - i, value);
+        }
+
+        AVX2_TARGET static void fill(double *dst, size_t n, double value) {
+            const auto v = _mm256_set1_pd(value);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) _mm256_storeu_pd(dst + i, v);
+            scalar::fill(dst + i, n - i, value);
+        }
+
+        AVX2_TARGET static int64_t sum(const int64_t *data, size_t n) {
+            auto acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+                acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 4)));
+            }
+            return static_cast<int64_t>(static_cast<uint64_t>(reduce_add(_mm256_add_epi64(acc0, acc1))) +
+                                        scalar::sum(data + i, n - i));
+        }
+
+        AVX2_TARGET static double sum(const double *data, size_t n) {
+            auto acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+                acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+            }
+            return reduce_add(_mm256_add_pd(acc0, acc1)) + scalar::sum(data + i, n - i);
+        }
+
+        AVX2_TARGET static uint64_t sum(const uint8_t *data, size_t n) {
+            const auto zero = _mm256_setzero_si256();
+            auto acc = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), zero));
+            return static_cast<uint64_t>(reduce_add(acc)) + scalar::sum(data + i, n - i);
+        }
+
+        AVX2_TARGET static int64_t min(const int64_t *data, size_t n) {
+            if (n < 4)
+                return scalar::min(data, n);
+            auto acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            size_t i = 4;
+            for (; i + 4 <= n; i += 4) {
+                const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(acc, v));
+            }
+            alignas(32) int64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+            const auto result = scalar::min(lanes, 4);
+            return i < n ? std::min(result, scalar::min(data + i, n - i)) : result;
+        }
+
+        AVX2_TARGET static int64_t max(const int64_t *data, size_t n) {
+            if (n < 4)
+                return scalar::max(data, n);
+            auto acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            size_t i = 4;
+            for (; i + 4 <= n; i += 4) {
+                const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(v, acc));
+            }
+            alignas(32) int64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+            const auto result = scalar::max(lanes, 4);
+            return i < n ? std::max(result, scalar::max(data + i, n - i)) : result;
+        }
+
+        AVX2_TARGET static double min(const double *data, size_t n) {
+            if (n < 4)
+                return scalar::min(data, n);
+            auto acc = _mm256_loadu_pd(data);
+            size_t i = 4;
+            for (; i + 4 <= n; i += 4) acc = _mm256_min_pd(acc, _mm256_loadu_pd(data + i));
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, acc);
+            const auto result = scalar::min(lanes, 4);
+            return i < n ? std::min(result, scalar::min(data + i, n - i)) : result;
+        }
+
+        AVX2_TARGET static double max(const double *data, size_t n) {
+            if (n < 4)
+                return scalar::max(data, n);
+            auto acc = _mm256_loadu_pd(data);
+            size_t i = 4;
+            for (; i + 4 <= n; i += 4) acc = _mm256_max_pd(acc, _mm256_loadu_pd(data + i));
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, acc);
+            const auto result = scalar::max(lanes, 4);
+            return i < n ? std::max(result, scalar::max(data + i, n - i)) : result;
+        }
+
+        AVX2_TARGET static uint8_t min(const uint8_t *data, size_t n) {
+            if (n < 32)
+                return scalar::min(data, n);
+            auto acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            size_t i = 32;
+            for (; i + 32 <= n; i += 32) acc = _mm256_min_epu8(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+            alignas(32) uint8_t lanes[32];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+            const auto result = scalar::min(lanes, 32);
+            return i < n ? std::min(result, scalar::min(data + i, n - i)) : result;
+        }
+
+        AVX2_TARGET static uint8_t max(const uint8_t *data, size_t n) {
+            if (n < 32)
+                return scalar::max(data, n);
+            auto acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            size_t i = 32;
+            for (; i + 32 <= n; i += 32) acc = _mm256_max_epu8(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+            alignas(32) uint8_t lanes[32];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+            const auto result = scalar::max(lanes, 32);
+            return i < n ? std::max(result, scalar::max(data + i, n - i)) : result;
+        }
+
+        AVX2_TARGET static double dot(const double *lhs, const double *rhs, size_t n) {
+            auto acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+                acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(lhs + i + 4), _mm256_loadu_pd(rhs + i + 4)));
+            }
+            return reduce_add(_mm256_add_pd(acc0, acc1)) + scalar::dot(lhs + i, rhs + i, n - i);
+        }
+
+        AVX2_TARGET static uint64_t dot(const uint8_t *lhs, const uint8_t *rhs, size_t n) {
+            const auto zero = _mm256_setzero_si256();
+            auto acc = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i));
+                const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i));
+                const auto products = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)),
+                                                       _mm256_madd_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)));
+                acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(products, zero));
+                acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(products, zero));
+            }
+            return static_cast<uint64_t>(reduce_add(acc)) + scalar::dot(lhs + i, rhs + i, n - i);
+        }
+
+        AVX2_TARGET static size_t mismatch_bytes(const uint8_t *lhs, const uint8_t *rhs, size_t n) {
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                const auto eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i)),
+                                                  _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i)));
+                if (const auto mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(eq)))
+                    return i + std::countr_zero(mask);
+            }
+            return i + sse2::mismatch_bytes(lhs + i, rhs + i, n - i);
+        }
+
+        AVX2_TARGET static size_t mismatch(const double *lhs, const double *rhs, size_t n) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const auto eq = _mm256_cmp_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i), _CMP_EQ_OQ);
+                if (const auto mask = ~static_cast<uint32_t>(_mm256_movemask_pd(eq)) & 0xF)
+                    return i + std::countr_zero(mask);
+            }
+            return i + scalar::mismatch(lhs + i, rhs + i, n - i);
+        }
+    }    // namespace avx2
+
+#    define DISPATCH_AVX2(...) \
+        if (avx2::supported()) \
+        return avx2::__VA_ARGS__
+#else
+#    define DISPATCH_AVX2(...)
+#endif
+
+#ifdef SWAN_KERNELS_SSE2
+#    define DISPATCH_SSE2(...) return sse2::__VA_ARGS__
+#else
+#    define DISPATCH_SSE2(...) return scalar::__VA_ARGS__
+#endif
+
+    void fill(int64_t *dst, size_t n, int64_t value) {
+        DISPATCH_AVX2(fill(dst, n, value));
+        DISPATCH_SSE2(fill(dst, n, value));
+    }
+
+    void fill(double *dst, size_t n, double value) {
+        DISPATCH_AVX2(fill(dst, n, value));
+        DISPATCH_SSE2(fill(dst, n, value));
+    }
+
+    void fill(uint8_t *dst, size_t n, uint8_t value) {
+        // memset is already vectorized by the C library
+        std::memset(dst, value, n);
+    }
+
+    int64_t sum(const int64_t *data, size_t n) {
+        DISPATCH_AVX2(sum(data, n));
+        DISPATCH_SSE2(sum(data, n));
+    }
+
+    double sum(const double *data, size_t n) {
+        DISPATCH_AVX2(sum(data, n));
+        DISPATCH_SSE2(sum(data, n));
+    }
+
+    uint64_t sum(const uint8_t *data, size_t n) {
+        DISPATCH_AVX2(sum(data, n));
+        DISPATCH_SSE2(sum(data, n));
+    }
+
+    int64_t min(const int64_t *data, size_t n) {
+        // SSE2 has no 64-bit integer comparison
+        DISPATCH_AVX2(min(data, n));
+        return scalar::min(data, n);
+    }
+
+    double min(const double *data, size_t n) {
+        DISPATCH_AVX2(min(data, n));
+        DISPATCH_SSE2(min(data, n));
+    }
+
+    uint8_t min(const uint8_t *data, size_t n) {
+        DISPATCH_AVX2(min(data, n));
+        DISPATCH_SSE2(min(data, n));
+    }
+
+    int64_t max(const int64_t *data, size_t n) {
+        DISPATCH_AVX2(max(data, n));
+        return scalar::max(data, n);
+    }
+
+    double max(const double *data, size_t n) {
+        DISPATCH_AVX2(max(data, n));
+        DISPATCH_SSE2(max(data, n));
+    }
+
+    uint8_t max(const uint8_t *data, size_t n) {
+        DISPATCH_AVX2(max(data, n));
+        DISPATCH_SSE2(max(data, n));
+    }
+
+    int64_t dot(const int64_t *lhs, const int64_t *rhs, size_t n) {
+        // Neither SSE2 nor AVX2 can multiply 64-bit integers, the compiler does the best it can
+        return static_cast<int64_t>(scalar::dot(lhs, rhs, n));
+    }
+
+    double dot(const double *lhs, const double *rhs, size_t n) {
+        DISPATCH_AVX2(dot(lhs, rhs, n));
+        DISPATCH_SSE2(dot(lhs, rhs, n));
+    }
+
+    uint64_t dot(const uint8_t *lhs, const uint8_t *rhs, size_t n) {
+        DISPATCH_AVX2(dot(lhs, rhs, n));
+        DISPATCH_SSE2(dot(lhs, rhs, n));
+    }
+
+    size_t mismatch(const int64_t *lhs, const int64_t *rhs, size_t n) {
+        const auto lhs_bytes = reinterpret_cast<const uint8_t *>(lhs);
+        const auto rhs_bytes = reinterpret_cast<const uint8_t *>(rhs);
+        DISPATCH_AVX2(mismatch_bytes(lhs_bytes, rhs_bytes, n * sizeof(int64_t)) / sizeof(int64_t));
+        DISPATCH_SSE2(mismatch_bytes(lhs_bytes, rhs_bytes, n * sizeof(int64_t)) / sizeof(int64_t));
+    }
+
+    size_t mismatch(const double *lhs, const double *rhs, size_t n) {
+        DISPATCH_AVX2(mismatch(lhs, rhs, n));
+        DISPATCH_SSE2(mismatch(lhs, rhs, n));
+    }
+
+    size_t mismatch(const uint8_t *lhs, const uint8_t *rhs, size_t n) {
+        DISPATCH_AVX2(mismatch_bytes(lhs, rhs, n));
+        DISPATCH_SSE2(mismatch_bytes(lhs, rhs, n));
+    }
+}    // namespace spade::kernels
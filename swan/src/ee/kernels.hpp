@@ -0,0 +1,52 @@
+#pragma once
+
+#include "utils/common.hpp"
+#include <cstring>
+
+namespace spade::kernels
+{
+    /*
+     * Bulk kernels over the packed elements of arrays.
+     * Each kernel uses AVX2 when the processor supports it, SSE2 on the other x86-64 processors
+     * and a scalar loop elsewhere. The reductions may sum the elements in a different order
+     * than a sequential loop, so the floating point results can differ in the last bits.
+     * The min and max kernels require at least one element.
+     */
+
+    void fill(int64_t *dst, size_t n, int64_t value);
+    void fill(double *dst, size_t n, double value);
+    void fill(uint8_t *dst, size_t n, uint8_t value);
+
+    /**
+     * Copies @p n elements from @p src to @p dst, the ranges may overlap
+     */
+    template<typename T>
+    void copy(T *dst, const T *src, size_t n) {
+        // memmove is already vectorized by the C library
+        std::memmove(dst, src, n * sizeof(T));
+    }
+
+    int64_t sum(const int64_t *data, size_t n);
+    double sum(const double *data, size_t n);
+    uint64_t sum(const uint8_t *data, size_t n);
+
+    int64_t min(const int64_t *data, size_t n);
+    double min(const double *data, size_t n);
+    uint8_t min(const uint8_t *data, size_t n);
+
+    int64_t max(const int64_t *data, size_t n);
+    double max(const double *data, size_t n);
+    uint8_t max(const uint8_t *data, size_t n);
+
+    int64_t dot(const int64_t *lhs, const int64_t *rhs, size_t n);
+    double dot(const double *lhs, const double *rhs, size_t n);
+    uint64_t dot(const uint8_t *lhs, const uint8_t *rhs, size_t n);
+
+    /**
+     * Compares @p lhs and @p rhs element by element
+     * @return the index of the first element which differs, @p n if all the elements are equal
+     */
+    size_t mismatch(const int64_t *lhs, const int64_t *rhs, size_t n);
+    size_t mismatch(const double *lhs, const double *rhs, size_t n);
+    size_t mismatch(const uint8_t *lhs, const uint8_t *rhs, size_t n);
+}    // namespace spade::kernels
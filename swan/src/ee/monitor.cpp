@@ -0,0 +1,358 @@
+#include "monitor.hpp"
+#include "utils/errors.hpp"
+#include <algorithm>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    include <immintrin.h>
+#endif
+
+namespace spade
+{
+    /// Number of busy spins before the waiting thread starts yielding
+    static constexpr const size_t MAX_SPINS = 64;
+
+    static void spin_wait(size_t &spins) {
+        if (++spins > MAX_SPINS)
+            std::this_thread::yield();
+    }
+
+    /// Average hold time above which the contenders of a monitor park without spinning, in nanoseconds
+    static constexpr const int64_t MAX_SPIN_HOLD = 50'000;
+    /// Shortest time a contender of a monitor spins for, in nanoseconds
+    static constexpr const int64_t MIN_SPIN_TIME = 1'000;
+    /// Time after which a parked contender gets the monitor handed over instead of competing for it, in nanoseconds
+    static constexpr const int64_t FAIR_HANDOFF_TIME = 1'000'000;
+
+    static void cpu_relax() {
+#if defined(__x86_64__) || defined(_M_X64)
+        _mm_pause();
+#endif
+    }
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Monitor::enter(uint64_t id, uint64_t times) {
+        // Only the owner can see its own id here
+        if (owner.load(std::memory_order_relaxed) == id) {
+            count += times;
+            return;
+        }
+        if (spin(id, times))
+            return;
+        std::unique_lock lk(mtx);
+        acquire(lk, id, times);
+    }
+
+    void Monitor::exit(uint64_t id) {
+        if (owner.load(std::memory_order_relaxed) != id)
+            throw IllegalMonitorStateError();
+        if (--count > 0)
+            return;
+        std::lock_guard lk(mtx);
+        release();
+    }
+
+    bool Monitor::wait(uint64_t id, std::optional<std::chrono::nanoseconds> timeout) {
+        if (owner.load(std::memory_order_relaxed) != id)
+            throw IllegalMonitorStateError();
+        const auto times = count;
+        std::unique_lock lk(mtx);
+        Parked self{id, now_ns()};
+        // Join the wait set before giving up the monitor, so that a notification sent right after is not lost
+        waiters.push_back(&self);
+        release();
+        const auto notified = [&self] { return self.woken; };
+        if (timeout)
+            self.cv.wait_for(lk, *timeout, notified);
+        else
+            self.cv.wait(lk, notified);
+        if (!self.woken)
+            std::erase(waiters, &self);
+        acquire(lk, id, times);
+        return self.woken;
+    }
+
+    void Monitor::notify(uint64_t id) {
+        if (owner.load(std::memory_order_relaxed) != id)
+            throw IllegalMonitorStateError();
+        std::lock_guard lk(mtx);
+        if (waiters.empty())
+            return;
+        const auto waiter = waiters.front();
+        waiters.pop_front();
+        // The waiter cannot leave before the lock is released, so it is still alive while it is notified
+        waiter->woken = true;
+        waiter->cv.notify_one();
+    }
+
+    void Monitor::notify_all(uint64_t id) {
+        if (owner.load(std::memory_order_relaxed) != id)
+            throw IllegalMonitorStateError();
+        std::lock_guard lk(mtx);
+        for (const auto waiter: waiters) {
+            waiter->woken = true;
+            waiter->cv.notify_one();
+        }
+        waiters.clear();
+    }
+
+    bool Monitor::spin(uint64_t id, uint64_t times) {
+        const auto hold = average_hold.load(std::memory_order_relaxed);
+        if (hold > MAX_SPIN_HOLD)
+            return false;
+        // Spinning for about two hold times gives the owner the time to finish its critical section
+        const auto deadline = now_ns() + std::max(2 * hold, MIN_SPIN_TIME);
+        for (size_t spins = 1;; spins++) {
+            if (owner.load(std::memory_order_relaxed) == 0) {
+                uint64_t expected = 0;
+                if (owner.compare_exchange_weak(expected, id, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    acquired(times);
+                    return true;
+                }
+            }
+            cpu_relax();
+            // Read the clock only every few spins, since it is much slower than a spin
+            if (spins % 16 == 0 && now_ns() >= deadline)
+                return false;
+        }
+    }
+
+    void Monitor::assign(uint64_t id, uint64_t times) {
+        owner.store(id, std::memory_order_relaxed);
+        acquired(times);
+    }
+
+    void Monitor::acquired(uint64_t times) {
+        count = times;
+        acquired_at = now_ns();
+    }
+
+    void Monitor::acquire(std::unique_lock<std::mutex> &lk, uint64_t id, uint64_t times) {
+        uint64_t expected = 0;
+        // Take the free monitor only if nobody is queued, otherwise the queue would be overtaken
+        if (entrants.empty() && owner.compare_exchange_strong(expected, id, std::memory_order_acquire, std::memory_order_relaxed)) {
+            acquired(times);
+            return;
+        }
+        Parked self{id, now_ns()};
+        entrants.push_back(&self);
+        while (true) {
+            self.cv.wait(lk, [&self] { return self.woken; });
+            if (owner.load(std::memory_order_relaxed) == id)
+                break;    // Handed over, release has already dequeued this thread
+            self.woken = false;
+            expected = 0;
+            if (owner.compare_exchange_strong(expected, id, std::memory_order_acquire, std::memory_order_relaxed)) {
+                std::erase(entrants, &self);
+                break;
+            }
+        }
+        acquired(times);
+    }
+
+    void Monitor::release() {
+        const auto hold = now_ns() - acquired_at;
+        const auto average = average_hold.load(std::memory_order_relaxed);
+        average_hold.store(average + (hold - average) / 8, std::memory_order_relaxed);
+        if (entrants.empty()) {
+            owner.store(0, std::memory_order_release);
+            return;
+        }
+        const auto next = entrants.front();
+        if (now_ns() - next->since >= FAIR_HANDOFF_TIME) {
+            // The first contender has been overtaken for too long, so it gets the monitor without competing
+            entrants.pop_front();
+            owner.store(next->id, std::memory_order_release);
+        } else
+            owner.store(0, std::memory_order_release);
+        // The contender stays queued while it competes, so it is woken up again if it loses
+        next->woken = true;
+        next->cv.notify_one();
+    }
+
+    Monitor *MonitorTable::acquire() {
+        std::lock_guard lk(mtx);
+        if (!free_list.empty()) {
+            const auto monitor = free_list.back();
+            free_list.pop_back();
+            return monitor;
+        }
+        return monitors.emplace_back(std::make_unique<Monitor>()).get();
+    }
+
+    void MonitorTable::release(Monitor *monitor) {
+        std::lock_guard lk(mtx);
+        free_list.push_back(monitor);
+    }
+
+    size_t MonitorTable::size() {
+        std::lock_guard lk(mtx);
+        return monitors.size();
+    }
+
+    MonitorTable &MonitorTable::get() {
+        static MonitorTable table;
+        return table;
+    }
+
+    ThinLock::~ThinLock() {
+        if (const auto w = word.load(std::memory_order_acquire); w & INFLATED_BIT)
+            MonitorTable::get().release(get_monitor(w));
+    }
+
+    void ThinLock::lock() const {
+        const auto id = current_id();
+        size_t spins = 0;
+        while (true) {
+            const auto w = word.load(std::memory_order_acquire);
+            if (w == 0) {
+                auto expected = w;
+                if (word.compare_exchange_weak(expected, id << OWNER_SHIFT | COUNT_ONE, std::memory_order_acquire, std::memory_order_relaxed))
+                    return;
+                continue;
+            }
+            if (w & INFLATED_BIT) {
+                get_monitor(w)->enter(id);
+                return;
+            }
+            const auto count = (w & COUNT_MASK) >> COUNT_SHIFT;
+            if (w >> OWNER_SHIFT == id) {
+                auto expected = w;
+                // The word changes under the owner only if a contender inflates it, then the loop enters the monitor
+                if (count != COUNT_MASK >> COUNT_SHIFT) {
+                    if (word.compare_exchange_strong(expected, w + COUNT_ONE, std::memory_order_relaxed))
+                        return;
+                } else if (inflate(id, count + 1, w))
+                    return;
+                continue;
+            }
+            // The lock is held by another thread, inflate it for the owner after a short spin so that this thread parks on the monitor
+            if (spins >= MAX_SPINS) {
+                inflate(w >> OWNER_SHIFT, count, w);
+                continue;
+            }
+            spin_wait(spins);
+        }
+    }
+
+    void ThinLock::unlock() const {
+        const auto id = current_id();
+        while (true) {
+            const auto w = word.load(std::memory_order_acquire);
+            if (w & INFLATED_BIT) {
+                get_monitor(w)->exit(id);
+                return;
+            }
+            if (w == 0 || w >> OWNER_SHIFT != id)
+                throw IllegalMonitorStateError();
+            auto expected = w;
+            if (word.compare_exchange_strong(expected, (w & COUNT_MASK) > COUNT_ONE ? w - COUNT_ONE : 0, std::memory_order_release,
+                                             std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    bool ThinLock::wait(std::optional<std::chrono::nanoseconds> timeout) const {
+        const auto id = current_id();
+        while (true) {
+            const auto w = word.load(std::memory_order_acquire);
+            if (w & INFLATED_BIT)
+                return get_monitor(w)->wait(id, timeout);
+            if (w == 0 || w >> OWNER_SHIFT != id)
+                throw IllegalMonitorStateError();
+            inflate(id, (w & COUNT_MASK) >> COUNT_SHIFT, w);
+        }
+    }
+
+    void ThinLock::notify() const {
+        const auto id = current_id();
+        const auto w = word.load(std::memory_order_acquire);
+        if (w & INFLATED_BIT) {
+            get_monitor(w)->notify(id);
+            return;
+        }
+        // Waiting inflates the lock, so nobody waits on a thin lock
+        if (w == 0 || w >> OWNER_SHIFT != id)
+            throw IllegalMonitorStateError();
+    }
+
+    void ThinLock::notify_all() const {
+        const auto id = current_id();
+        const auto w = word.load(std::memory_order_acquire);
+        if (w & INFLATED_BIT) {
+            get_monitor(w)->notify_all(id);
+            return;
+        }
+        if (w == 0 || w >> OWNER_SHIFT != id)
+            throw IllegalMonitorStateError();
+    }
+
+    uint64_t ThinLock::current_id() {
+        static std::atomic<uint64_t> next_id = 1;
+        thread_local const uint64_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    bool ThinLock::inflate(uint64_t owner, uint64_t times, uint64_t expected) const {
+        const auto monitor = MonitorTable::get().acquire();
+        monitor->assign(owner, times);
+        if (word.compare_exchange_strong(expected, reinterpret_cast<uint64_t>(monitor) | INFLATED_BIT, std::memory_order_release,
+                                         std::memory_order_relaxed))
+            return true;
+        monitor->assign(0, 0);
+        MonitorTable::get().release(monitor);
+        return false;
+    }
+
+    void SpinRwLock::lock() {
+        size_t spins = 0;
+        uint32_t expected = 0;
+        while (!state.compare_exchange_weak(expected, WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+            expected = 0;
+            spin_wait(spins);
+        }
+    }
+
+    void SpinRwLock::unlock() {
+        state.store(0, std::memory_order_release);
+    }
+
+    void SpinLock::lock() {
+        size_t spins = 0;
+        // Spin on a plain load so that the waiting threads do not bounce the cache line
+        while (locked.exchange(true, std::memory_order_acquire))
+            while (locked.load(std::memory_order_relaxed)) spin_wait(spins);
+    }
+
+    void SpinLock::unlock() {
+        locked.store(false, std::memory_order_release);
+    }
+
+    SpinLock &AtomicLockTable::get(const void *owner, size_t key) {
+        // Objects are at least 8 byte aligned, so the low bits of the address carry no information
+        const auto hash = (reinterpret_cast<uintptr_t>(owner) >> 3) * 0x9E3779B97F4A7C15ull ^ key * 0xC2B2AE3D27D4EB4Full;
+        return stripes[(hash >> 32) % STRIPES].lock;
+    }
+
+    AtomicLockTable &AtomicLockTable::get() {
+        static AtomicLockTable table;
+        return table;
+    }
+
+    void SpinRwLock::lock_shared() {
+        size_t spins = 0;
+        while (true) {
+            auto s = state.load(std::memory_order_relaxed);
+            if (!(s & WRITER) && state.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return;
+            spin_wait(spins);
+        }
+    }
+
+    void SpinRwLock::unlock_shared() {
+        state.fetch_sub(1, std::memory_order_release);
+    }
+}    // namespace spade
@@ -0,0 +1,307 @@
+#pragma once
+
+#include "utils/common.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace spade
+{
+    /**
+     * A full monitor which is used by a thin lock after it is inflated.
+     * It is a recursive lock which remembers its owner and has a wait set.
+     *
+     * A contender spins for a while before it parks, as long as the monitor is usually held briefly.
+     * The spinning time follows the average of the recent hold times, so a monitor guarding long
+     * critical sections parks its contenders at once. The parked contenders are queued. On exit the owner
+     * frees the monitor and wakes up the first of them to compete for it, unless that contender has waited
+     * too long, in which case the monitor is handed over to it directly. So the monitor is not passed between
+     * sleeping threads on every exit under contention, and still no contender waits indefinitely.
+     */
+    class SWAN_EXPORT Monitor {
+        /// A thread parked on the monitor, which lives on the stack of that thread
+        struct Parked {
+            uint64_t id;
+            /// Time when the thread was parked in nanoseconds
+            int64_t since;
+            std::condition_variable cv;
+            /// Set when the thread is woken up, either notified in the wait set or woken up to enter the monitor
+            bool woken = false;
+        };
+
+        std::mutex mtx;
+        /// Lock id of the owner thread, 0 if the monitor is free
+        std::atomic<uint64_t> owner = 0;
+        /// Number of times the owner has entered the monitor, only accessed by the owner
+        uint64_t count = 0;
+        /// Time when the owner got the monitor in nanoseconds, only accessed by the owner
+        int64_t acquired_at = 0;
+        /// Moving average of the recent hold times in nanoseconds
+        std::atomic<int64_t> average_hold = 0;
+        /// The contenders waiting for the monitor in arrival order
+        std::deque<Parked *> entrants;
+        /// The threads waiting to be notified in arrival order
+        std::deque<Parked *> waiters;
+
+      public:
+        Monitor() = default;
+
+        Monitor(const Monitor &) = delete;
+        Monitor(Monitor &&) = delete;
+        Monitor &operator=(const Monitor &) = delete;
+        Monitor &operator=(Monitor &&) = delete;
+        ~Monitor() = default;
+
+        /**
+         * Enters the monitor, blocks until the monitor is free
+         * @param id the lock id of the current thread
+         * @param times number of times the monitor is entered at once
+         */
+        void enter(uint64_t id, uint64_t times = 1);
+
+        /**
+         * Exits the monitor
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
+         * @param id the lock id of the current thread
+         */
+        void exit(uint64_t id);
+
+        /**
+         * Exits the monitor completely and waits until the current thread is notified or @p timeout elapses,
+         * then enters the monitor again as many times as it was entered before
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
+         * @param id the lock id of the current thread
+         * @param timeout the maximum time to wait, the wait does not time out if it is empty
+         * @return true if the current thread was notified, false if the wait timed out
+         */
+        bool wait(uint64_t id, std::optional<std::chrono::nanoseconds> timeout);
+
+        /**
+         * Wakes up the thread which has waited the longest on the monitor
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
+         * @param id the lock id of the current thread
+         */
+        void notify(uint64_t id);
+
+        /**
+         * Wakes up all the threads waiting on the monitor
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
+         * @param id the lock id of the current thread
+         */
+        void notify_all(uint64_t id);
+
+        /**
+         * Makes @p id the owner of the free monitor as if it had entered the monitor @p times times.
+         * This lets a contender inflate a thin lock held by another thread, so it must be called before the monitor is published
+         * @param id the lock id of the new owner, 0 to make the monitor free again
+         * @param times number of times the monitor is entered
+         */
+        void assign(uint64_t id, uint64_t times);
+
+      private:
+        /// Tries to get the free monitor by spinning, returns false if the monitor should be parked on instead
+        bool spin(uint64_t id, uint64_t times);
+
+        /// Takes the monitor after it was got by @p id, must be called by the new owner
+        void acquired(uint64_t times);
+
+        /// Gets the monitor or parks until it is handed over, must be called with mtx held
+        void acquire(std::unique_lock<std::mutex> &lk, uint64_t id, uint64_t times);
+
+        /// Gives up the monitor and wakes up the first parked contender if there is one, must be called with mtx held
+        void release();
+    };
+
+    /**
+     * Owns the inflated monitors. Monitors are allocated on inflation
+     * and returned when the object owning the thin lock is destroyed
+     */
+    class SWAN_EXPORT MonitorTable {
+        std::vector<std::unique_ptr<Monitor>> monitors;
+        std::vector<Monitor *> free_list;
+        std::mutex mtx;
+
+        MonitorTable() = default;
+
+      public:
+        /**
+         * @return a free monitor
+         */
+        Monitor *acquire();
+
+        /**
+         * Returns @p monitor to the table for further use
+         * @param monitor the monitor
+         */
+        void release(Monitor *monitor);
+
+        /**
+         * @return the number of monitors allocated so far
+         */
+        size_t size();
+
+        /**
+         * @return the process wide monitor table
+         */
+        static MonitorTable &get();
+    };
+
+    /**
+     * A lock which lives in a single word of the object header.
+     * Uncontended locking is a single compare-and-swap on the lock word, recursive locking by the owner
+     * only increments the count in the lock word. When another thread contends for the lock and it is not
+     * released after a short spin, the contender inflates it into a full Monitor taken from the MonitorTable
+     * on behalf of the owner and parks on the monitor, so the contenders of a long held lock sleep.
+     * Every change of the lock word is a compare-and-swap, since a contender can inflate the lock at any time.
+     * Once inflated, the lock stays inflated for the rest of its lifetime.
+     *
+     * The layout of the lock word is:
+     *
+     *     thin:     [owner id: 48][count: 15][0]
+     *     inflated: [monitor pointer        ][1]
+     *
+     * where a word of zero means the lock is free
+     */
+    class SWAN_EXPORT ThinLock {
+        static constexpr const uint64_t INFLATED_BIT = 1;
+        static constexpr const uint64_t COUNT_SHIFT = 1;
+        static constexpr const uint64_t COUNT_ONE = uint64_t{1} << COUNT_SHIFT;
+        static constexpr const uint64_t COUNT_MASK = 0x7FFF << COUNT_SHIFT;
+        static constexpr const uint64_t OWNER_SHIFT = 16;
+
+        mutable std::atomic<uint64_t> word = 0;
+
+      public:
+        ThinLock() = default;
+
+        ThinLock(const ThinLock &) = delete;
+        ThinLock(ThinLock &&) = delete;
+        ThinLock &operator=(const ThinLock &) = delete;
+        ThinLock &operator=(ThinLock &&) = delete;
+        ~ThinLock();
+
+        /**
+         * Acquires the lock, blocks until the lock is free
+         */
+        void lock() const;
+
+        /**
+         * Releases the lock
+         * @throws IllegalMonitorStateError if the current thread does not own the lock
+         */
+        void unlock() const;
+
+        /**
+         * Releases the lock completely and waits until the current thread is notified or @p timeout elapses,
+         * then acquires the lock again. The lock is inflated first, since only a full monitor has a wait set
+         * @throws IllegalMonitorStateError if the current thread does not own the lock
+         * @param timeout the maximum time to wait, the wait does not time out if it is empty
+         * @return true if the current thread was notified, false if the wait timed out
+         */
+        bool wait(std::optional<std::chrono::nanoseconds> timeout) const;
+
+        /**
+         * Wakes up the thread which has waited the longest on the lock
+         * @throws IllegalMonitorStateError if the current thread does not own the lock
+         */
+        void notify() const;
+
+        /**
+         * Wakes up all the threads waiting on the lock
+         * @throws IllegalMonitorStateError if the current thread does not own the lock
+         */
+        void notify_all() const;
+
+        /**
+         * @return true if the lock is inflated
+         */
+        bool is_inflated() const {
+            return word.load(std::memory_order_relaxed) & INFLATED_BIT;
+        }
+
+        /**
+         * @return the lock id of the current thread, which is never zero
+         */
+        static uint64_t current_id();
+
+      private:
+        Monitor *get_monitor(uint64_t w) const {
+            return reinterpret_cast<Monitor *>(w & ~INFLATED_BIT);
+        }
+
+        /**
+         * Replaces the thin lock word @p expected with a monitor owned by @p owner
+         * @param owner the lock id of the owner of the thin lock
+         * @param times number of times the owner has entered the lock
+         * @param expected the thin lock word
+         * @return false if the word changed meanwhile, in which case nothing is done
+         */
+        bool inflate(uint64_t owner, uint64_t times, uint64_t expected) const;
+    };
+
+    /**
+     * A reader-writer spin lock which occupies a single word.
+     * It satisfies the SharedLockable requirements, so it can be used with
+     * std::shared_lock and std::unique_lock
+     */
+    class SWAN_EXPORT SpinRwLock {
+        static constexpr const uint32_t WRITER = 1u << 31;
+
+        /// Number of readers in the lower bits and the writer bit at the top
+        std::atomic<uint32_t> state = 0;
+
+      public:
+        void lock();
+        void unlock();
+        void lock_shared();
+        void unlock_shared();
+    };
+
+    /**
+     * A spin lock which occupies a single byte.
+     * It satisfies the BasicLockable requirements, so it can be used with std::lock_guard
+     */
+    class SWAN_EXPORT SpinLock {
+        std::atomic<bool> locked = false;
+
+      public:
+        void lock();
+        void unlock();
+    };
+
+    /**
+     * A fixed table of spin locks guarding the locals updated by the atomic instructions.
+     * A location is identified by the object or the stack slot holding it and a key within it.
+     * The atomic instructions on the same location are atomic with respect to each other,
+     * the plain loads and stores are not synchronized with them
+     */
+    class SWAN_EXPORT AtomicLockTable {
+        static constexpr const size_t STRIPES = 256;
+
+        struct alignas(64) Stripe {
+            SpinLock lock;
+        };
+
+        Stripe stripes[STRIPES];
+
+        AtomicLockTable() = default;
+
+      public:
+        /**
+         * @param owner the object holding the location
+         * @param key the key of the location within @p owner
+         * @return the lock guarding the location
+         */
+        SpinLock &get(const void *owner, size_t key);
+
+        /**
+         * @return the process wide lock table
+         */
+        static AtomicLockTable &get();
+    };
+}    // namespace spade
@@ -0,0 +1,596 @@
+#include "natives.hpp"
+#include "channel.hpp"
+#include "kernels.hpp"
+#include "scheduler.hpp"
+#include "obj.hpp"
+#include "thread.hpp"
+#include "vm.hpp"
+#include "callable/method.hpp"
+#include "memory/memory.hpp"
+#include "spimp/utils.hpp"
+#include "utils/errors.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace spade
+{
+    static ObjArray *to_array(const char *function, Value value) {
+        if (value.is_obj() && is<ObjArray>(value.as_obj()))
+            return cast<ObjArray>(value.as_obj());
+        throw ArgumentError(function, "expected an array");
+    }
+
+    static ObjMap *to_map(const char *function, Value value) {
+        if (value.is_obj() && is<ObjMap>(value.as_obj()))
+            return cast<ObjMap>(value.as_obj());
+        throw ArgumentError(function, "expected a map");
+    }
+
+    static ObjSet *to_set(const char *function, Value value) {
+        if (value.is_obj() && is<ObjSet>(value.as_obj()))
+            return cast<ObjSet>(value.as_obj());
+        throw ArgumentError(function, "expected a set");
+    }
+
+    static ObjChannel *to_channel(const char *function, Value value) {
+        if (value.is_obj() && is<ObjChannel>(value.as_obj()))
+            return cast<ObjChannel>(value.as_obj());
+        throw ArgumentError(function, "expected a channel");
+    }
+
+    static size_t to_size(const char *function, Value value) {
+        if (value.is_uint())
+            return value.as_uint();
+        if (value.is_int() && value.as_int() >= 0)
+            return value.as_int();
+        throw ArgumentError(function, "expected a non negative integer");
+    }
+
+    static int to_fd(const char *function, Value value) {
+        const auto fd = to_size(function, value);
+        if (fd > static_cast<size_t>(std::numeric_limits<int>::max()))
+            throw ArgumentError(function, "expected a file descriptor");
+        return static_cast<int>(fd);
+    }
+
+    static uint16_t to_port(const char *function, Value value) {
+        const auto port = to_size(function, value);
+        if (port > std::numeric_limits<uint16_t>::max())
+            throw ArgumentError(function, "expected a port");
+        return static_cast<uint16_t>(port);
+    }
+
+    static string to_str(const char *function, Value value) {
+        if (value.is_obj() && is<ObjString>(value.as_obj()))
+            return cast<ObjString>(value.as_obj())->to_string();
+        throw ArgumentError(function, "expected a string");
+    }
+
+    /// @return the bytes of @p value, which is a string or an array of uints less than 256
+    static string to_bytes(const char *function, Value value) {
+        if (value.is_obj() && is<ObjString>(value.as_obj()))
+            return cast<ObjString>(value.as_obj())->to_string();
+        const auto array = to_array(function, value);
+        {
+            const ObjArray::ElementsLock lk(array);
+            if (const auto data = array->get_packed<uint8_t>())
+                return string(reinterpret_cast<const char *>(data), array->count());
+        }
+        const auto n = array->count();
+        string bytes(n, '\0');
+        for (size_t i = 0; i < n; i++) {
+            const auto byte = to_size(function, array->get(i));
+            if (byte > 255)
+                throw ArgumentError(function, "expected an array of bytes");
+            bytes[i] = static_cast<char>(byte);
+        }
+        return bytes;
+    }
+
+    /// @return @p value as a bound of a slice of @p length elements, counting from the end if it is negative
+    static size_t to_bound(const char *function, Value value, size_t length) {
+        if (value.is_int() && value.as_int() < 0)
+            return static_cast<size_t>(std::max(value.as_int() + static_cast<int64_t>(length), int64_t{0}));
+        return to_size(function, value);
+    }
+
+    template<typename T, typename F>
+    static bool try_packed(const ObjArray *array, F &func) {
+        const ObjArray::ElementsLock lk(array);
+        const auto data = array->get_packed<T>();
+        if (!data)
+            return false;
+        func(data);
+        return true;
+    }
+
+    template<typename T, typename F>
+    static bool try_packed(const ObjArray *lhs, const ObjArray *rhs, F &func) {
+        const ObjArray::ElementsLock lhs_lk(lhs), rhs_lk(rhs);
+        const auto lhs_data = lhs->get_packed<T>();
+        const auto rhs_data = rhs->get_packed<T>();
+        if (!lhs_data || !rhs_data)
+            return false;
+        func(lhs_data, rhs_data);
+        return true;
+    }
+
+    /**
+     * Calls @p func with the packed elements of @p array
+     * @return false if the elements of @p array are not all packed
+     */
+    template<typename F>
+    static bool visit_packed(const ObjArray *array, F &&func) {
+        return try_packed<int64_t>(array, func) || try_packed<double>(array, func) || try_packed<uint8_t>(array, func);
+    }
+
+    /**
+     * Calls @p func with the packed elements of @p lhs and @p rhs
+     * @return false if the elements of the arrays are not all packed with the same kind
+     */
+    template<typename F>
+    static bool visit_packed(const ObjArray *lhs, const ObjArray *rhs, F &&func) {
+        return try_packed<int64_t>(lhs, rhs, func) || try_packed<double>(lhs, rhs, func) || try_packed<uint8_t>(lhs, rhs, func);
+    }
+
+    /// @return the value of a sum or a dot product computed by a kernel, the ints are checked against the range of the ints
+    static Value kernel_result(int64_t result) {
+        return Value::checked_int(result);
+    }
+
+    static Value kernel_result(uint64_t result) {
+        return Value::checked_uint(result);
+    }
+
+    static Value kernel_result(double result) {
+        return Value(result);
+    }
+
+    static ObjArray *new_array(Thread *thread, const char *function, Value length, ObjArray::ElementKind kind) {
+        return halloc_mgr<ObjArray>(thread->get_vm()->get_memory_manager(), to_size(function, length), kind);
+    }
+
+    /// @return the least element of @p array if @p least is true, the greatest element otherwise
+    static Value extreme(const char *function, Value array_value, bool least) {
+        const auto array = to_array(function, array_value);
+        const auto n = array->count();
+        if (n == 0)
+            throw ArgumentError(function, "array is empty");
+
+        Value result;
+        if (visit_packed(array, [&](auto data) { result = Value(least ? kernels::min(data, n) : kernels::max(data, n)); }))
+            return result;
+
+        result = array->get(size_t{0});
+        for (size_t i = 1; i < n; i++) {
+            const auto value = array->get(i);
+            if ((least ? value < result : value > result).truth())
+                result = value;
+        }
+        return result;
+    }
+
+    /// Number of chunks per worker thread of a parallel operation, more chunks than workers balance uneven work
+    static constexpr const size_t PARALLEL_CHUNKS_PER_WORKER = 4;
+    /// Minimum number of elements in a chunk of a parallel operation
+    static constexpr const size_t PARALLEL_MIN_CHUNK = 16;
+
+    using ChunkFunc = std::function<void(Thread *thread, size_t chunk, size_t begin, size_t end)>;
+
+    static ObjMethod *to_method(const char *function, Value value, size_t args_count) {
+        if (!value.is_obj() || !is<ObjMethod>(value.as_obj()))
+            throw ArgumentError(function, "expected a method");
+        const auto method = cast<ObjMethod>(value.as_obj());
+        if (method->get_args_count() != args_count)
+            throw ArgumentError(function, std::format("expected a method of {} arguments", args_count));
+        return method;
+    }
+
+    /// Calls @p method with @p args and runs it to completion on @p thread
+    static Value invoke(Thread *thread, ObjMethod *method, vector<Value> args) {
+        method->call(null, std::move(args));
+        return thread->get_vm()->run(thread);
+    }
+
+    /**
+     * @return the number of elements in each chunk when @p count elements are processed in parallel by @p scheduler
+     */
+    static size_t chunk_size(const Scheduler *scheduler, size_t count) {
+        const auto chunks = scheduler->get_worker_count() * PARALLEL_CHUNKS_PER_WORKER;
+        return std::max((count + chunks - 1) / chunks, PARALLEL_MIN_CHUNK);
+    }
+
+    /**
+     * Splits the @p count elements into chunks of @p size and calls @p func for each chunk in a separate task.
+     * When every chunk has finished, the returned task is finished with the value of @p combine,
+     * or with the value thrown by the first chunk in order which has thrown
+     * @param roots the objects used by @p func and @p combine, which are kept alive by the tasks of the chunks
+     * @return the task finishing with the result of the operation
+     */
+    static ObjTask *fork_join(Thread *thread, size_t count, size_t size, ChunkFunc func, std::function<Value(Thread *)> combine,
+                              vector<Value> roots) {
+        const auto vm = thread->get_vm();
+        const auto scheduler = vm->get_scheduler();
+        const auto result = scheduler->make_pending();
+        const auto chunks = (count + size - 1) / size;
+        if (chunks == 0) {
+            scheduler->complete(result, combine(thread));
+            return result;
+        }
+
+        struct Join {
+            std::atomic<size_t> remaining;
+            /// Whether each chunk has thrown, the thrown values are kept in errors
+            std::unique_ptr<std::atomic<bool>[]> failed;
+            ObjArray *errors;
+        };
+        const auto join = std::make_shared<Join>(chunks, std::make_unique<std::atomic<bool>[]>(chunks),
+                                                 halloc_mgr<ObjArray>(vm->get_memory_manager(), chunks, ObjArray::ElementKind::VALUE));
+        roots.push_back(join->errors);
+        roots.push_back(result);
+
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            const auto begin = chunk * size;
+            const auto end = std::min(begin + size, count);
+            scheduler->spawn(
+                    [=](Thread *worker, const vector<Value> &) {
+                        try {
+                            func(worker, chunk, begin, end);
+                        } catch (const ThrowSignal &signal) {
+                            join->errors->set(chunk, signal.get_value());
+                            join->failed[chunk].store(true, std::memory_order_relaxed);
+                        }
+                        // The last chunk to finish combines the results of the chunks
+                        if (join->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                            return Value();
+                        for (size_t i = 0; i < chunks; i++) {
+                            if (join->failed[i].load(std::memory_order_relaxed)) {
+                                scheduler->complete(result, join->errors->get(i), true);
+                                return Value();
+                            }
+                        }
+                        try {
+                            scheduler->complete(result, combine(worker));
+                        } catch (const ThrowSignal &signal) {
+                            scheduler->complete(result, signal.get_value(), true);
+                        }
+                        return Value();
+                    },
+                    roots);
+        }
+        return result;
+    }
+
+    /// @return the index of the first element where @p lhs and @p rhs differ within @p n elements, @p n if there is none
+    static size_t mismatch(const ObjArray *lhs, const ObjArray *rhs, size_t n) {
+        size_t index = n;
+        if (visit_packed(lhs, rhs, [&](auto lhs_data, auto rhs_data) { index = kernels::mismatch(lhs_data, rhs_data, n); }))
+            return index;
+        for (size_t i = 0; i < n; i++)
+            if (!(lhs->get(i) == rhs->get(i)).truth())
+                return i;
+        return n;
+    }
+}    // namespace spade
+
+using namespace spade;
+
+void swan_array_new_int(Thread *thread, Value *ret, Value length) {
+    *ret = new_array(thread, "swan_array_new_int", length, ObjArray::ElementKind::INT);
+}
+
+void swan_array_new_float(Thread *thread, Value *ret, Value length) {
+    *ret = new_array(thread, "swan_array_new_float", length, ObjArray::ElementKind::FLOAT);
+}
+
+void swan_array_new_byte(Thread *thread, Value *ret, Value length) {
+    *ret = new_array(thread, "swan_array_new_byte", length, ObjArray::ElementKind::BYTE);
+}
+
+void swan_array_insert(Thread *, Value *, Value array, Value index, Value value) {
+    to_array("swan_array_insert", array)->insert(to_size("swan_array_insert", index), value);
+}
+
+void swan_array_remove(Thread *, Value *ret, Value array, Value index) {
+    *ret = to_array("swan_array_remove", array)->remove(to_size("swan_array_remove", index));
+}
+
+void swan_array_reserve(Thread *, Value *, Value array, Value capacity) {
+    to_array("swan_array_reserve", array)->reserve(to_size("swan_array_reserve", capacity));
+}
+
+void swan_array_slice(Thread *, Value *ret, Value array_value, Value start, Value end) {
+    const auto array = to_array("swan_array_slice", array_value);
+    const auto n = array->count();
+    *ret = array->slice(to_bound("swan_array_slice", start, n), to_bound("swan_array_slice", end, n));
+}
+
+void swan_array_fill(Thread *, Value *, Value array, Value value) {
+    to_array("swan_array_fill", array)->fill(value);
+}
+
+void swan_array_copy(Thread *, Value *, Value dst_value, Value dst_start_value, Value src_value, Value src_start_value,
+                     Value count_value) {
+    const auto dst = to_array("swan_array_copy", dst_value);
+    const auto src = to_array("swan_array_copy", src_value);
+    const auto dst_start = to_size("swan_array_copy", dst_start_value);
+    const auto src_start = to_size("swan_array_copy", src_start_value);
+    const auto count = to_size("swan_array_copy", count_value);
+    // The packed copy writes the elements directly
+    dst->check_mutable();
+    if (dst_start > dst->count() || count > dst->count() - dst_start)
+        throw IndexError("array", dst_start + count);
+    if (src_start > src->count() || count > src->count() - src_start)
+        throw IndexError("array", src_start + count);
+
+    if (visit_packed(dst, src, [&](auto dst_data, auto src_data) { kernels::copy(dst_data + dst_start, src_data + src_start, count); }))
+        return;
+
+    // Copy backwards when the destination overlaps the end of the source
+    if (dst == src && dst_start > src_start)
+        for (size_t i = count; i-- > 0;) dst->set(dst_start + i, src->get(src_start + i));
+    else
+        for (size_t i = 0; i < count; i++) dst->set(dst_start + i, src->get(src_start + i));
+}
+
+void swan_array_sum(Thread *, Value *ret, Value array_value) {
+    const auto array = to_array("swan_array_sum", array_value);
+    const auto n = array->count();
+    if (visit_packed(array, [&](auto data) { *ret = kernel_result(kernels::sum(data, n)); }))
+        return;
+
+    if (n == 0) {
+        *ret = Value(int64_t{0});
+        return;
+    }
+    auto result = array->get(size_t{0});
+    for (size_t i = 1; i < n; i++) result = result + array->get(i);
+    *ret = result;
+}
+
+void swan_array_min(Thread *, Value *ret, Value array) {
+    *ret = extreme("swan_array_min", array, true);
+}
+
+void swan_array_max(Thread *, Value *ret, Value array) {
+    *ret = extreme("swan_array_max", array, false);
+}
+
+void swan_array_dot(Thread *, Value *ret, Value lhs_value, Value rhs_value) {
+    const auto lhs = to_array("swan_array_dot", lhs_value);
+    const auto rhs = to_array("swan_array_dot", rhs_value);
+    const auto n = lhs->count();
+    if (n != rhs->count())
+        throw ArgumentError("swan_array_dot", std::format("arrays differ in length: {} and {}", n, rhs->count()));
+    if (visit_packed(lhs, rhs, [&](auto lhs_data, auto rhs_data) { *ret = kernel_result(kernels::dot(lhs_data, rhs_data, n)); }))
+        return;
+
+    if (n == 0) {
+        *ret = Value(int64_t{0});
+        return;
+    }
+    auto result = lhs->get(size_t{0}) * rhs->get(size_t{0});
+    for (size_t i = 1; i < n; i++) result = result + lhs->get(i) * rhs->get(i);
+    *ret = result;
+}
+
+void swan_array_equals(Thread *, Value *ret, Value lhs_value, Value rhs_value) {
+    const auto lhs = to_array("swan_array_equals", lhs_value);
+    const auto rhs = to_array("swan_array_equals", rhs_value);
+    const auto n = lhs->count();
+    *ret = Value(n == rhs->count() && mismatch(lhs, rhs, n) == n);
+}
+
+void swan_array_mismatch(Thread *, Value *ret, Value lhs_value, Value rhs_value) {
+    const auto lhs = to_array("swan_array_mismatch", lhs_value);
+    const auto rhs = to_array("swan_array_mismatch", rhs_value);
+    const auto n = std::min(lhs->count(), rhs->count());
+    const auto index = mismatch(lhs, rhs, n);
+    *ret = Value(index == n ? int64_t{-1} : static_cast<int64_t>(index));
+}
+
+void swan_array_parallel_map(Thread *thread, Value *ret, Value array_value, Value method_value) {
+    const auto array = to_array("swan_array_parallel_map", array_value);
+    const auto method = to_method("swan_array_parallel_map", method_value, 1);
+    const auto n = array->count();
+    // The results are stored boxed since the workers store them concurrently, they are packed once all are known
+    const auto results = halloc_mgr<ObjArray>(thread->get_vm()->get_memory_manager(), n, ObjArray::ElementKind::VALUE);
+    *ret = fork_join(
+            thread, n, chunk_size(thread->get_vm()->get_scheduler(), n),
+            [=](Thread *worker, size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) results->set(i, invoke(worker, method, {array->get(i)}));
+            },
+            [=](Thread *worker) {
+                const auto packed = halloc_mgr<ObjArray>(worker->get_vm()->get_memory_manager(), size_t{0});
+                packed->reserve(n);
+                for (size_t i = 0; i < n; i++) packed->push(results->get(i));
+                return Value(packed);
+            },
+            {array, method, results});
+}
+
+void swan_array_parallel_for_each(Thread *thread, Value *ret, Value array_value, Value method_value) {
+    const auto array = to_array("swan_array_parallel_for_each", array_value);
+    const auto method = to_method("swan_array_parallel_for_each", method_value, 1);
+    const auto n = array->count();
+    *ret = fork_join(
+            thread, n, chunk_size(thread->get_vm()->get_scheduler(), n),
+            [=](Thread *worker, size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) invoke(worker, method, {array->get(i)});
+            },
+            [](Thread *) { return Value(); }, {array, method});
+}
+
+void swan_array_parallel_reduce(Thread *thread, Value *ret, Value array_value, Value method_value, Value initial) {
+    const auto array = to_array("swan_array_parallel_reduce", array_value);
+    const auto method = to_method("swan_array_parallel_reduce", method_value, 2);
+    const auto n = array->count();
+    const auto size = chunk_size(thread->get_vm()->get_scheduler(), n);
+    const auto partials = halloc_mgr<ObjArray>(thread->get_vm()->get_memory_manager(), (n + size - 1) / size, ObjArray::ElementKind::VALUE);
+    *ret = fork_join(
+            thread, n, size,
+            [=](Thread *worker, size_t chunk, size_t begin, size_t end) {
+                auto acc = array->get(begin);
+                for (size_t i = begin + 1; i < end; i++) acc = invoke(worker, method, {acc, array->get(i)});
+                partials->set(chunk, acc);
+            },
+            [=](Thread *worker) {
+                auto acc = initial;
+                for (size_t i = 0; i < partials->count(); i++) acc = invoke(worker, method, {acc, partials->get(i)});
+                return acc;
+            },
+            {array, method, partials, initial});
+}
+
+void swan_string_slice(Thread *, Value *ret, Value str_value, Value start, Value end) {
+    if (!str_value.is_obj() || !is<ObjString>(str_value.as_obj()))
+        throw ArgumentError("swan_string_slice", "expected a string");
+    const auto str = cast<ObjString>(str_value.as_obj());
+    const auto n = str->size();
+    *ret = str->slice(to_bound("swan_string_slice", start, n), to_bound("swan_string_slice", end, n));
+}
+
+void swan_map_new(Thread *thread, Value *ret) {
+    *ret = halloc_mgr<ObjMap>(thread->get_vm()->get_memory_manager());
+}
+
+void swan_map_get(Thread *, Value *ret, Value map, Value key, Value fallback) {
+    *ret = to_map("swan_map_get", map)->get(key, fallback);
+}
+
+void swan_map_contains(Thread *, Value *ret, Value map, Value key) {
+    *ret = Value(to_map("swan_map_contains", map)->contains(key));
+}
+
+void swan_map_remove(Thread *, Value *ret, Value map, Value key) {
+    *ret = Value(to_map("swan_map_remove", map)->remove(key));
+}
+
+void swan_map_keys(Thread *thread, Value *ret, Value map_value) {
+    const auto map = to_map("swan_map_keys", map_value);
+    const auto keys = halloc_mgr<ObjArray>(thread->get_vm()->get_memory_manager(), size_t{0});
+    keys->reserve(map->count());
+    map->for_each([keys](Value key, Value) { keys->push(key); });
+    *ret = keys;
+}
+
+void swan_set_new(Thread *thread, Value *ret) {
+    *ret = halloc_mgr<ObjSet>(thread->get_vm()->get_memory_manager());
+}
+
+void swan_set_add(Thread *, Value *ret, Value set, Value value) {
+    *ret = Value(to_set("swan_set_add", set)->add(value));
+}
+
+void swan_set_contains(Thread *, Value *ret, Value set, Value value) {
+    *ret = Value(to_set("swan_set_contains", set)->contains(value));
+}
+
+void swan_set_remove(Thread *, Value *ret, Value set, Value value) {
+    *ret = Value(to_set("swan_set_remove", set)->remove(value));
+}
+
+void swan_io_read(Thread *thread, Value *ret, Value fd, Value count) {
+    *ret = thread->get_vm()->get_io_loop()->read(to_fd("swan_io_read", fd), to_size("swan_io_read", count));
+}
+
+void swan_io_write(Thread *thread, Value *ret, Value fd, Value data) {
+    *ret = thread->get_vm()->get_io_loop()->write(to_fd("swan_io_write", fd), to_bytes("swan_io_write", data));
+}
+
+void swan_io_accept(Thread *thread, Value *ret, Value fd) {
+    *ret = thread->get_vm()->get_io_loop()->accept(to_fd("swan_io_accept", fd));
+}
+
+void swan_io_connect(Thread *thread, Value *ret, Value host, Value port) {
+    *ret = thread->get_vm()->get_io_loop()->connect(to_str("swan_io_connect", host), to_port("swan_io_connect", port));
+}
+
+void swan_io_pipe(Thread *thread, Value *ret) {
+    const auto [read_fd, write_fd] = IoLoop::pipe();
+    const auto fds = halloc_mgr<ObjArray>(thread->get_vm()->get_memory_manager(), size_t{2}, ObjArray::ElementKind::INT);
+    fds->set(size_t{0}, Value(read_fd));
+    fds->set(size_t{1}, Value(write_fd));
+    *ret = fds;
+}
+
+void swan_io_open(Thread *, Value *ret, Value path, Value mode) {
+    *ret = Value(IoLoop::open(to_str("swan_io_open", path), to_str("swan_io_open", mode)));
+}
+
+void swan_io_listen(Thread *, Value *ret, Value host, Value port) {
+    *ret = Value(IoLoop::listen(to_str("swan_io_listen", host), to_port("swan_io_listen", port)));
+}
+
+void swan_io_local_port(Thread *, Value *ret, Value fd) {
+    *ret = Value(static_cast<int64_t>(IoLoop::local_port(to_fd("swan_io_local_port", fd))));
+}
+
+void swan_io_close(Thread *, Value *, Value fd) {
+    IoLoop::close(to_fd("swan_io_close", fd));
+}
+
+void swan_channel_new(Thread *thread, Value *ret, Value capacity_value) {
+    const auto capacity = to_size("swan_channel_new", capacity_value);
+    if (capacity == 0)
+        throw ArgumentError("swan_channel_new", "expected a positive capacity");
+    const auto vm = thread->get_vm();
+    *ret = halloc_mgr<ObjChannel>(vm->get_memory_manager(), vm, capacity);
+}
+
+void swan_channel_send(Thread *thread, Value *ret, Value channel, Value value) {
+    if (value.is_null())
+        throw ArgumentError("swan_channel_send", "cannot send null");
+    const auto task = thread->get_vm()->get_scheduler()->make_pending();
+    to_channel("swan_channel_send", channel)->send(task, value);
+    *ret = task;
+}
+
+void swan_channel_receive(Thread *thread, Value *ret, Value channel) {
+    const auto task = thread->get_vm()->get_scheduler()->make_pending();
+    to_channel("swan_channel_receive", channel)->receive(task);
+    *ret = task;
+}
+
+void swan_channel_try_send(Thread *, Value *ret, Value channel, Value value) {
+    if (value.is_null())
+        throw ArgumentError("swan_channel_try_send", "cannot send null");
+    *ret = Value(to_channel("swan_channel_try_send", channel)->try_send(value) == ObjChannel::Result::OK);
+}
+
+void swan_channel_try_receive(Thread *, Value *ret, Value channel) {
+    Value value;
+    *ret = to_channel("swan_channel_try_receive", channel)->try_receive(value) == ObjChannel::Result::OK ? value : Value();
+}
+
+void swan_channel_select(Thread *thread, Value *ret, Value channels_value) {
+    const auto channels = to_array("swan_channel_select", channels_value);
+    const auto n = channels->count();
+    if (n == 0)
+        throw ArgumentError("swan_channel_select", "expected at least one channel");
+    for (size_t i = 0; i < n; i++) to_channel("swan_channel_select", channels->get(i));
+
+    const auto task = thread->get_vm()->get_scheduler()->make_pending();
+    const auto state = std::make_shared<std::atomic<ObjChannel::SelectState>>(ObjChannel::SelectState::WAITING);
+    for (size_t i = 0; i < n; i++)
+        if (cast<ObjChannel>(channels->get(i).as_obj())->select(task, state, i))
+            break;
+    *ret = task;
+}
+
+void swan_channel_close(Thread *, Value *, Value channel) {
+    to_channel("swan_channel_close", channel)->close();
+}
+
+void swan_channel_is_closed(Thread *, Value *ret, Value channel) {
+    *ret = Value(to_channel("swan_channel_is_closed", channel)->is_closed());
+}
+
+void swan_object_freeze(Thread *, Value *ret, Value value) {
+    Obj::freeze(value);
+    *ret = value;
+}
+
+void swan_object_is_frozen(Thread *, Value *ret, Value value) {
+    *ret = Value(!value.is_obj() || value.as_obj()->is_frozen());
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "ee/value.hpp"
+
+namespace spade
+{
+    class Thread;
+}    // namespace spade
+
+/*
+ * Native functions of the built-in objects exported by swan.
+ * They follow the calling convention of foreign functions (see ObjForeign::foreign_call),
+ * so they can be bound as foreign functions from the swan library itself.
+ * The array functions use the bulk kernels when the arrays are packed and fall back to
+ * the element wise operations of the values otherwise.
+ * The asynchronous io functions return a task which finishes when the operation completes,
+ * so their results are obtained with the join instruction without blocking the worker threads.
+ */
+extern "C" {
+/**
+ * Creates an array of packed ints, each element is 0
+ * @param length the length of the array
+ */
+SWAN_EXPORT void swan_array_new_int(spade::Thread *thread, spade::Value *ret, spade::Value length);
+
+/**
+ * Creates an array of packed floats, each element is 0.0
+ * @param length the length of the array
+ */
+SWAN_EXPORT void swan_array_new_float(spade::Thread *thread, spade::Value *ret, spade::Value length);
+
+/**
+ * Creates an array of packed bytes which holds uints less than 256, each element is 0
+ * @param length the length of the array
+ */
+SWAN_EXPORT void swan_array_new_byte(spade::Thread *thread, spade::Value *ret, spade::Value length);
+
+/**
+ * Inserts @p value into @p array at @p index, shifting the elements from @p index to the right
+ */
+SWAN_EXPORT void swan_array_insert(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value index, spade::Value value);
+
+/**
+ * Removes the element of @p array at @p index, shifting the elements after @p index to the left
+ * @return the removed element
+ */
+SWAN_EXPORT void swan_array_remove(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value index);
+
+/**
+ * Ensures that @p array can hold @p capacity elements without growing
+ */
+SWAN_EXPORT void swan_array_reserve(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value capacity);
+
+/**
+ * Makes a view of the elements of @p array from @p start up to @p end, which shares the elements with @p array.
+ * Negative bounds count from the end of @p array
+ */
+SWAN_EXPORT void swan_array_slice(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value start, spade::Value end);
+
+/**
+ * Sets every element of @p array to @p value
+ */
+SWAN_EXPORT void swan_array_fill(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value value);
+
+/**
+ * Copies @p count elements of @p src starting at @p src_start to @p dst starting at @p dst_start.
+ * The arrays may be the same and the ranges may overlap
+ */
+SWAN_EXPORT void swan_array_copy(spade::Thread *thread, spade::Value *ret, spade::Value dst, spade::Value dst_start, spade::Value src,
+                                 spade::Value src_start, spade::Value count);
+
+/**
+ * @return the sum of the elements of @p array, 0 if it is empty
+ */
+SWAN_EXPORT void swan_array_sum(spade::Thread *thread, spade::Value *ret, spade::Value array);
+
+/**
+ * @return the least element of @p array, which must not be empty
+ */
+SWAN_EXPORT void swan_array_min(spade::Thread *thread, spade::Value *ret, spade::Value array);
+
+/**
+ * @return the greatest element of @p array, which must not be empty
+ */
+SWAN_EXPORT void swan_array_max(spade::Thread *thread, spade::Value *ret, spade::Value array);
+
+/**
+ * @return the sum of the products of the elements of @p lhs and @p rhs, which must be of the same length
+ */
+SWAN_EXPORT void swan_array_dot(spade::Thread *thread, spade::Value *ret, spade::Value lhs, spade::Value rhs);
+
+/**
+ * @return true if @p lhs and @p rhs have the same length and equal elements
+ */
+SWAN_EXPORT void swan_array_equals(spade::Thread *thread, spade::Value *ret, spade::Value lhs, spade::Value rhs);
+
+/**
+ * @return the index of the first element where @p lhs and @p rhs differ,
+ *         -1 if they are equal up to the length of the shorter one
+ */
+SWAN_EXPORT void swan_array_mismatch(spade::Thread *thread, spade::Value *ret, spade::Value lhs, spade::Value rhs);
+
+/**
+ * Calls @p method with each element of @p array in parallel on the worker threads.
+ * The array is split into chunks which are run as separate tasks, @p array must not be modified meanwhile
+ * @return a task finishing with the array of the results in the order of the elements,
+ *         or with the value thrown for the first element in order which has thrown
+ */
+SWAN_EXPORT void swan_array_parallel_map(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value method);
+
+/**
+ * Calls @p method with each element of @p array in parallel on the worker threads like swan_array_parallel_map
+ * @return a task finishing with null once every element is processed
+ */
+SWAN_EXPORT void swan_array_parallel_for_each(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value method);
+
+/**
+ * Folds the elements of @p array with @p method, which must be associative, in parallel on the worker threads.
+ * Each chunk is folded from its first element and the results of the chunks are folded in order starting from @p initial
+ * @return a task finishing with the folded value, which is @p initial if @p array is empty
+ */
+SWAN_EXPORT void swan_array_parallel_reduce(spade::Thread *thread, spade::Value *ret, spade::Value array, spade::Value method,
+                                            spade::Value initial);
+
+/**
+ * Makes a string of the bytes of @p str from @p start up to @p end without copying them if the string is long.
+ * Negative bounds count from the end of @p str
+ */
+SWAN_EXPORT void swan_string_slice(spade::Thread *thread, spade::Value *ret, spade::Value str, spade::Value start, spade::Value end);
+
+/**
+ * Creates an empty map
+ */
+SWAN_EXPORT void swan_map_new(spade::Thread *thread, spade::Value *ret);
+
+/**
+ * @return the value mapped to @p key in @p map, @p fallback if there is none
+ */
+SWAN_EXPORT void swan_map_get(spade::Thread *thread, spade::Value *ret, spade::Value map, spade::Value key, spade::Value fallback);
+
+/**
+ * @return true if @p map contains @p key
+ */
+SWAN_EXPORT void swan_map_contains(spade::Thread *thread, spade::Value *ret, spade::Value map, spade::Value key);
+
+/**
+ * Removes @p key and its value from @p map
+ * @return true if @p map contained @p key
+ */
+SWAN_EXPORT void swan_map_remove(spade::Thread *thread, spade::Value *ret, spade::Value map, spade::Value key);
+
+/**
+ * @return an array of the keys of @p map in no particular order
+ */
+SWAN_EXPORT void swan_map_keys(spade::Thread *thread, spade::Value *ret, spade::Value map);
+
+/**
+ * Creates an empty set
+ */
+SWAN_EXPORT void swan_set_new(spade::Thread *thread, spade::Value *ret);
+
+/**
+ * Adds @p value to @p set
+ * @return true if @p set did not contain @p value
+ */
+SWAN_EXPORT void swan_set_add(spade::Thread *thread, spade::Value *ret, spade::Value set, spade::Value value);
+
+/**
+ * @return true if @p set contains @p value
+ */
+SWAN_EXPORT void swan_set_contains(spade::Thread *thread, spade::Value *ret, spade::Value set, spade::Value value);
+
+/**
+ * Removes @p value from @p set
+ * @return true if @p set contained @p value
+ */
+SWAN_EXPORT void swan_set_remove(spade::Thread *thread, spade::Value *ret, spade::Value set, spade::Value value);
+
+/**
+ * Reads at most @p count bytes from the file descriptor @p fd asynchronously
+ * @return a task finishing with the array of bytes read, which is empty at the end of the file
+ */
+SWAN_EXPORT void swan_io_read(spade::Thread *thread, spade::Value *ret, spade::Value fd, spade::Value count);
+
+/**
+ * Writes @p data, which is a string or an array of bytes, to the file descriptor @p fd asynchronously
+ * @return a task finishing with the number of bytes written
+ */
+SWAN_EXPORT void swan_io_write(spade::Thread *thread, spade::Value *ret, spade::Value fd, spade::Value data);
+
+/**
+ * Accepts a connection on the listening socket @p fd asynchronously
+ * @return a task finishing with the file descriptor of the connection
+ */
+SWAN_EXPORT void swan_io_accept(spade::Thread *thread, spade::Value *ret, spade::Value fd);
+
+/**
+ * Connects to the numeric ipv4 address @p host on @p port over tcp asynchronously
+ * @return a task finishing with the file descriptor of the connection
+ */
+SWAN_EXPORT void swan_io_connect(spade::Thread *thread, spade::Value *ret, spade::Value host, spade::Value port);
+
+/**
+ * Creates a pipe
+ * @return an array of the file descriptors of the reading end and the writing end
+ */
+SWAN_EXPORT void swan_io_pipe(spade::Thread *thread, spade::Value *ret);
+
+/**
+ * Opens the file at @p path with @p mode, which is a mode of fopen
+ * @return the file descriptor
+ */
+SWAN_EXPORT void swan_io_open(spade::Thread *thread, spade::Value *ret, spade::Value path, spade::Value mode);
+
+/**
+ * Creates a tcp socket listening on the numeric ipv4 address @p host at @p port, any free port if it is zero
+ * @return the file descriptor of the socket
+ */
+SWAN_EXPORT void swan_io_listen(spade::Thread *thread, spade::Value *ret, spade::Value host, spade::Value port);
+
+/**
+ * @return the local port of the bound socket @p fd
+ */
+SWAN_EXPORT void swan_io_local_port(spade::Thread *thread, spade::Value *ret, spade::Value fd);
+
+/**
+ * Closes the file descriptor @p fd
+ */
+SWAN_EXPORT void swan_io_close(spade::Thread *thread, spade::Value *ret, spade::Value fd);
+
+/**
+ * Creates an open channel which holds at most @p capacity values
+ * @param capacity the capacity, which must be positive
+ */
+SWAN_EXPORT void swan_channel_new(spade::Thread *thread, spade::Value *ret, spade::Value capacity);
+
+/**
+ * Sends @p value, which must not be null, to @p channel
+ * @return a task finishing with null once the value is sent, or with a thrown message if the channel is closed first
+ */
+SWAN_EXPORT void swan_channel_send(spade::Thread *thread, spade::Value *ret, spade::Value channel, spade::Value value);
+
+/**
+ * Receives a value from @p channel
+ * @return a task finishing with the value, or with null if the channel is closed and empty
+ */
+SWAN_EXPORT void swan_channel_receive(spade::Thread *thread, spade::Value *ret, spade::Value channel);
+
+/**
+ * Sends @p value, which must not be null, to @p channel without waiting
+ * @return false if the channel is full or closed
+ */
+SWAN_EXPORT void swan_channel_try_send(spade::Thread *thread, spade::Value *ret, spade::Value channel, spade::Value value);
+
+/**
+ * Receives a value from @p channel without waiting
+ * @return the value, null if the channel is empty or closed
+ */
+SWAN_EXPORT void swan_channel_try_receive(spade::Thread *thread, spade::Value *ret, spade::Value channel);
+
+/**
+ * Waits until one of the channels of the array @p channels has a value or is closed and receives the value
+ * @return a task finishing with an array of the index of the channel and the received value,
+ *         which is null if the channel is closed
+ */
+SWAN_EXPORT void swan_channel_select(spade::Thread *thread, spade::Value *ret, spade::Value channels);
+
+/**
+ * Closes @p channel. The values sent already can still be received, the senders waiting for room fail
+ */
+SWAN_EXPORT void swan_channel_close(spade::Thread *thread, spade::Value *ret, spade::Value channel);
+
+/**
+ * @return true if @p channel is closed
+ */
+SWAN_EXPORT void swan_channel_is_closed(spade::Thread *thread, spade::Value *ret, spade::Value channel);
+
+/**
+ * Freezes @p value and the data reachable from it, so it can be read by every thread without locking
+ * and cannot be modified anymore
+ * @return @p value
+ */
+SWAN_EXPORT void swan_object_freeze(spade::Thread *thread, spade::Value *ret, spade::Value value);
+
+/**
+ * @return true if @p value is frozen, which every value that is not an object is
+ */
+SWAN_EXPORT void swan_object_is_frozen(spade::Thread *thread, spade::Value *ret, spade::Value value);
+}
@@ -1,8 +1,16 @@
 #include "obj.hpp"
+#include "channel.hpp"
+#include "kernels.hpp"
+#include "task.hpp"
 #include "thread.hpp"
+#include "vm.hpp"
+#include "callable/foreign.hpp"
+#include "callable/generator.hpp"
+#include "callable/method.hpp"
 #include "memory/memory.hpp"
 #include "spimp/utils.hpp"
 #include "utils/errors.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -11,33 +19,378 @@
 
 namespace spade
 {
-    Obj::Obj(ObjTag tag) : tag(tag), monitor(), type(null), member_slots() {}
+    string tag_to_string(ObjTag tag) {
+        switch (tag) {
+        case OBJ_STRING:
+            return "string";
+        case OBJ_ARRAY:
+            return "array";
+        case OBJ_OBJECT:
+            return "object";
+        case OBJ_CAPTURE:
+            return "capture";
+        case OBJ_MODULE:
+            return "module";
+        case OBJ_METHOD:
+            return "method";
+        case OBJ_FOREIGN:
+            return "foreign";
+        case OBJ_TYPE:
+            return "type";
+        case OBJ_MAP:
+            return "map";
+        case OBJ_SET:
+            return "set";
+        case OBJ_GENERATOR:
+            return "generator";
+        case OBJ_TASK:
+            return "task";
+        case OBJ_CHANNEL:
+            return "channel";
+        }
+        return "<unknown>";
+    }
+
+    static_assert(alignof(Type) >= 8, "the lower 3 bits of the type pointer hold the object flags");
+
+    /**
+     * @return the owner id of the objects allocated by the current thread, which is never SHARED_OWNER
+     */
+    static uint32_t current_owner() {
+        thread_local const uint32_t id = static_cast<uint32_t>(ThinLock::current_id());
+        return id;
+    }
+
+    Obj::Obj(ObjTag tag) : header(make_header(tag, null)), monitor(), member_slots(), owner(current_owner()) {}
 
-    Obj::Obj(Type *type) : tag(OBJ_OBJECT), monitor(), type(type), member_slots() {
+    Obj::Obj(Type *type) : header(make_header(OBJ_OBJECT, type)), monitor(), member_slots(), owner(current_owner()) {
         set_type(type);
     }
 
+    bool Obj::is_confined() const {
+        // Only the owner can see its own id here, every other thread sees an id which is not its own or SHARED_OWNER
+        return owner.load(std::memory_order_relaxed) == current_owner();
+    }
+
+    std::shared_lock<SpinRwLock> Obj::read_lock(SpinRwLock &mtx) const {
+        // Frozen and confined objects are never written concurrently
+        if (is_frozen() || is_confined())
+            return std::shared_lock(mtx, std::defer_lock);
+        return std::shared_lock(mtx);
+    }
+
+    std::unique_lock<SpinRwLock> Obj::write_lock(SpinRwLock &mtx) const {
+        if (is_confined())
+            return std::unique_lock(mtx, std::defer_lock);
+        return std::unique_lock(mtx);
+    }
+
+    /**
+     * @return true if @p obj holds data which can be frozen
+     */
+    static bool is_freezable(const Obj *obj) {
+        switch (obj->get_tag()) {
+        case OBJ_STRING:
+        case OBJ_ARRAY:
+        case OBJ_OBJECT:
+        case OBJ_MAP:
+        case OBJ_SET:
+            return true;
+        case OBJ_TYPE:
+            // The static fields of a type live in its member slots, so such a type stays writable
+            return std::ranges::none_of(obj->get_member_slots(), [](const auto &entry) {
+                const auto value = entry.second.get_value();
+                return entry.second.get_flags().is_static() && !(value.is_obj() && value.as_obj()->get_tag() == OBJ_METHOD);
+            });
+        default:
+            return false;
+        }
+    }
+
+    void Obj::freeze() {
+        vector<Obj *> pending{this};
+        while (!pending.empty()) {
+            const auto obj = pending.back();
+            pending.pop_back();
+            if (obj->is_frozen())
+                continue;
+            if (!is_freezable(obj)) {
+                obj->publish();
+                continue;
+            }
+            // Mark the object before visiting its references, so that cycles end here
+            obj->owner.store(SHARED_OWNER, std::memory_order_release);
+            obj->set_flag(OBJ_FLAG_FROZEN);
+            obj->for_each_reference([&pending](Obj *ref) {
+                if (!ref->is_frozen())
+                    pending.push_back(ref);
+            });
+        }
+    }
+
+    void Obj::check_mutable() const {
+        if (is_frozen())
+            throw FrozenObjectError(to_string());
+    }
+
+    void Obj::publish() {
+        if (is_shared())
+            return;
+        // Walk the reachable objects iteratively, since an unpublished object graph can be arbitrarily deep
+        vector<Obj *> pending{this};
+        while (!pending.empty()) {
+            const auto obj = pending.back();
+            pending.pop_back();
+            if (obj->owner.exchange(SHARED_OWNER, std::memory_order_acq_rel) == SHARED_OWNER)
+                continue;
+            obj->for_each_reference([&pending](Obj *ref) {
+                if (!ref->is_shared())
+                    pending.push_back(ref);
+            });
+        }
+    }
+
+    void Obj::destroy(Obj *obj) {
+        switch (obj->get_tag()) {
+        case OBJ_STRING:
+            std::destroy_at(static_cast<ObjString *>(obj));
+            break;
+        case OBJ_ARRAY:
+            std::destroy_at(static_cast<ObjArray *>(obj));
+            break;
+        case OBJ_OBJECT:
+            std::destroy_at(obj);
+            break;
+        case OBJ_CAPTURE:
+            std::destroy_at(static_cast<ObjCapture *>(obj));
+            break;
+        case OBJ_MODULE:
+            std::destroy_at(static_cast<ObjModule *>(obj));
+            break;
+        case OBJ_METHOD:
+            std::destroy_at(static_cast<ObjMethod *>(obj));
+            break;
+        case OBJ_FOREIGN:
+            std::destroy_at(static_cast<ObjForeign *>(obj));
+            break;
+        case OBJ_TYPE:
+            std::destroy_at(static_cast<Type *>(obj));
+            break;
+        case OBJ_MAP:
+            std::destroy_at(static_cast<ObjMap *>(obj));
+            break;
+        case OBJ_SET:
+            std::destroy_at(static_cast<ObjSet *>(obj));
+            break;
+        case OBJ_GENERATOR:
+            std::destroy_at(static_cast<ObjGenerator *>(obj));
+            break;
+        case OBJ_TASK:
+            std::destroy_at(static_cast<ObjTask *>(obj));
+            break;
+        case OBJ_CHANNEL:
+            std::destroy_at(static_cast<ObjChannel *>(obj));
+            break;
+        }
+    }
+
+    size_t Obj::size_of(const Obj *obj) {
+        // Each member slot costs a hash node holding the interned name and the slot
+        size_t size = obj->get_member_slots().size() * (sizeof(MemberTable::value_type) + 2 * sizeof(void *));
+        switch (obj->get_tag()) {
+        case OBJ_STRING: {
+            // The contents of a rope are accounted to its parts until it is flattened
+            const auto str = cast<const ObjString>(obj);
+            size += sizeof(ObjString) + (str->is_rope() ? 0 : str->size());
+            break;
+        }
+        case OBJ_ARRAY:
+            size += sizeof(ObjArray) + cast<const ObjArray>(obj)->get_storage_size();
+            break;
+        case OBJ_OBJECT:
+            size += sizeof(Obj);
+            break;
+        case OBJ_CAPTURE:
+            size += sizeof(ObjCapture);
+            break;
+        case OBJ_MODULE:
+            size += sizeof(ObjModule) + cast<const ObjModule>(obj)->get_constant_pool().size() * sizeof(Value);
+            break;
+        case OBJ_METHOD: {
+            const auto method = cast<const ObjMethod>(obj);
+            size += sizeof(ObjMethod) + method->get_code_count() + method->get_captures().size() * sizeof(ObjMethod::CaptureInfo);
+            break;
+        }
+        case OBJ_FOREIGN:
+            size += sizeof(ObjForeign);
+            break;
+        case OBJ_TYPE:
+            size += sizeof(Type);
+            break;
+        case OBJ_MAP:
+            size += sizeof(ObjMap) + cast<const ObjMap>(obj)->get_storage_size();
+            break;
+        case OBJ_SET:
+            size += sizeof(ObjSet) + cast<const ObjSet>(obj)->get_storage_size();
+            break;
+        case OBJ_GENERATOR: {
+            // The frame of a running generator is accounted to the call stack
+            const auto &frame = cast<const ObjGenerator>(obj)->get_frame();
+            size += sizeof(ObjGenerator);
+            if (frame.stack)
+                size += (frame.get_args_count() + frame.get_locals_count() + frame.get_max_stack_count()) * sizeof(Value);
+            break;
+        }
+        case OBJ_TASK:
+            // The frames of a task are accounted like the call stacks of the threads
+            size += sizeof(ObjTask);
+            break;
+        case OBJ_CHANNEL:
+            size += sizeof(ObjChannel) + cast<const ObjChannel>(obj)->get_capacity() * sizeof(Value);
+            break;
+        }
+        return size;
+    }
+
     void Obj::set_type(Type *new_type) {
-        if (type) {
+        if (get_type()) {
             member_slots = new_type->get_member_slots();
         } else
             member_slots.clear();
-        type = new_type;
+        // Pointers are expected to fit in the 48 bits of the header
+        assert((reinterpret_cast<uint64_t>(new_type) & ~TYPE_MASK) == 0);
+        update_header(TYPE_MASK, reinterpret_cast<uint64_t>(new_type));
+    }
+
+    void Obj::for_each_reference(const std::function<void(Obj *)> &func) const {
+        const auto visit = [&func](Value value) {
+            if (value.is_obj())
+                func(value.as_obj());
+        };
+
+        if (const auto type = get_type())
+            func(type);
+        {
+            std::shared_lock member_slots_lk(member_slots_mtx);
+            for (const auto &[_, slot]: member_slots) visit(slot.get_value());
+        }
+
+        switch (get_tag()) {
+        case OBJ_STRING:
+            cast<const ObjString>(this)->for_each_part(func);
+            break;
+        case OBJ_ARRAY:
+            if (const auto array = cast<const ObjArray>(this); array->get_parent())
+                func(array->get_parent());
+            else if (!array->is_packed())
+                array->for_each(visit);
+            break;
+        case OBJ_MAP:
+            cast<const ObjMap>(this)->for_each([&visit](Value key, Value value) {
+                visit(key);
+                visit(value);
+            });
+            break;
+        case OBJ_SET:
+            cast<const ObjSet>(this)->for_each(visit);
+            break;
+        case OBJ_MODULE: {
+            const auto module = cast<const ObjModule>(this);
+            // The match tables of the methods refer to the constants only, so they are covered here
+            for (const auto value: module->get_constant_pool()) visit(value);
+            if (const auto init = module->get_init())
+                func(init);
+            break;
+        }
+        case OBJ_CAPTURE:
+            visit(cast<const ObjCapture>(this)->get());
+            break;
+        case OBJ_METHOD: {
+            const auto method = cast<const ObjMethod>(this);
+            for (const auto &info: method->get_captures()) func(info.capture);
+            const auto &exceptions = method->get_exceptions();
+            for (uint8_t i = 0; i < exceptions.count(); i++)
+                if (const auto type = exceptions.get(i).get_type())
+                    func(type);
+            break;
+        }
+        case OBJ_GENERATOR:
+            cast<const ObjGenerator>(this)->get_frame().for_each_reference(func);
+            break;
+        case OBJ_TASK:
+            cast<const ObjTask>(this)->for_each_task_reference(func);
+            break;
+        case OBJ_CHANNEL:
+            cast<const ObjChannel>(this)->for_each_channel_reference(func);
+            break;
+        default:
+            break;
+        }
     }
 
     Obj *Obj::copy() const {
-        const auto obj = halloc_mgr<Obj>(info.manager, type);
-        for (const auto &[name, slot]: member_slots) {
-            obj->set_member(name, slot.get_value().copy());
-            obj->set_flags(name, slot.get_flags());
+        switch (get_tag()) {
+        case OBJ_ARRAY:
+            return static_cast<const ObjArray *>(this)->copy();
+        case OBJ_MAP:
+            return static_cast<const ObjMap *>(this)->copy();
+        case OBJ_SET:
+            return static_cast<const ObjSet *>(this)->copy();
+        case OBJ_OBJECT: {
+            const auto obj = halloc_mgr<Obj>(get_manager(), get_type());
+            for (const auto &[name, slot]: member_slots) {
+                obj->set_member(name, slot.get_value().copy());
+                obj->set_flags(name, slot.get_flags());
+            }
+            return obj;
+        }
+        default:
+            // immutable state
+            return (Obj *) this;
         }
-        return obj;
     }
 
     Ordering Obj::compare(const Obj *other) const {
-        if (this == other)
-            return Ordering::EQUAL;
-        return Ordering::UNDEFINED;
+        switch (get_tag()) {
+        case OBJ_STRING:
+            return static_cast<const ObjString *>(this)->compare(other);
+        case OBJ_ARRAY:
+            return static_cast<const ObjArray *>(this)->compare(other);
+        default:
+            if (this == other)
+                return Ordering::EQUAL;
+            return Ordering::UNDEFINED;
+        }
+    }
+
+    size_t Obj::hash() const {
+        switch (get_tag()) {
+        case OBJ_STRING:
+            return static_cast<const ObjString *>(this)->hash();
+        case OBJ_ARRAY:
+            return static_cast<const ObjArray *>(this)->hash();
+        default:
+            return std::hash<const Obj *>()(this);
+        }
+    }
+
+    bool Obj::truth() const {
+        switch (get_tag()) {
+        case OBJ_STRING:
+            return static_cast<const ObjString *>(this)->truth();
+        case OBJ_ARRAY:
+            return static_cast<const ObjArray *>(this)->truth();
+        case OBJ_CAPTURE:
+            return static_cast<const ObjCapture *>(this)->truth();
+        case OBJ_MAP:
+            return static_cast<const ObjMap *>(this)->truth();
+        case OBJ_SET:
+            return static_cast<const ObjSet *>(this)->truth();
+        case OBJ_GENERATOR:
+            return static_cast<const ObjGenerator *>(this)->truth();
+        default:
+            return true;
+        }
     }
 
     Value Obj::operator<(const Obj *other) const {
@@ -83,19 +436,60 @@ namespace spade
     }
 
     string Obj::to_string() const {
-        return std::format("<object of type {}>", type->get_sign().to_string());
+        switch (get_tag()) {
+        case OBJ_STRING:
+            return static_cast<const ObjString *>(this)->to_string();
+        case OBJ_ARRAY:
+            return static_cast<const ObjArray *>(this)->to_string();
+        case OBJ_CAPTURE:
+            return static_cast<const ObjCapture *>(this)->to_string();
+        case OBJ_MODULE:
+            return static_cast<const ObjModule *>(this)->to_string();
+        case OBJ_METHOD:
+            return static_cast<const ObjMethod *>(this)->to_string();
+        case OBJ_TYPE:
+            return static_cast<const Type *>(this)->to_string();
+        case OBJ_MAP:
+            return static_cast<const ObjMap *>(this)->to_string();
+        case OBJ_SET:
+            return static_cast<const ObjSet *>(this)->to_string();
+        case OBJ_GENERATOR:
+            return static_cast<const ObjGenerator *>(this)->to_string();
+        case OBJ_TASK:
+            return static_cast<const ObjTask *>(this)->to_string();
+        case OBJ_CHANNEL:
+            return static_cast<const ObjChannel *>(this)->to_string();
+        default:
+            return std::format("<object of type {}>", get_type()->get_sign().to_string());
+        }
     }
 
-    Value Obj::get_member(const string &name) const {
-        std::shared_lock member_slots_lk(member_slots_mtx);
+    const ObjString *Obj::find_member_name(const string &name) const {
+        return get_manager()->get_vm()->get_intern_table().find(name);
+    }
+
+    const ObjString *Obj::intern_member_name(const string &name) const {
+        const auto manager = get_manager();
+        return manager->get_vm()->get_intern_table().intern(manager, name);
+    }
+
+    Value Obj::get_member(const ObjString *name) const {
+        std::shared_lock member_slots_lk(member_slots_mtx, std::defer_lock);
+        // Frozen and confined objects are never written concurrently
+        if (!is_frozen() && !is_confined())
+            member_slots_lk.lock();
         if (const auto it = member_slots.find(name); it != member_slots.end()) {
             return it->second.get_value();
         }
-        throw IllegalAccessError(std::format("cannot find member: {} in {}", name, to_string()));
+        throw IllegalAccessError(std::format("cannot find member: {} in {}", name->value(), to_string()));
     }
 
-    void Obj::set_member(const string &name, Value value) {
-        std::unique_lock member_slots_lk(member_slots_mtx);
+    void Obj::set_member(const ObjString *name, Value value) {
+        check_mutable();
+        publish_stored(value);
+        std::unique_lock member_slots_lk(member_slots_mtx, std::defer_lock);
+        if (!is_confined())
+            member_slots_lk.lock();
         if (const auto it = member_slots.find(name); it != member_slots.end()) {
             it->second.set_value(value);
             return;
@@ -104,40 +498,196 @@ namespace spade
         member_slots.emplace(name, value);
     }
 
-    bool Obj::has_member(const string &name) const {
-        std::shared_lock member_slots_lk(member_slots_mtx);
+    void Obj::update_member(const ObjString *name, const std::function<std::optional<Value>(Value)> &func) {
+        check_mutable();
+        {
+            const auto member_slots_lk = write_lock(member_slots_mtx);
+            if (const auto it = member_slots.find(name); it != member_slots.end()) {
+                if (const auto value = func(it->second.get_value()))
+                    it->second.set_value(*value);
+                return;
+            }
+        }
+        throw IllegalAccessError(std::format("cannot find member: {} in {}", name->value(), to_string()));
+    }
+
+    bool Obj::has_member(const ObjString *name) const {
+        std::shared_lock member_slots_lk(member_slots_mtx, std::defer_lock);
+        // Frozen and confined objects are never written concurrently
+        if (!is_frozen() && !is_confined())
+            member_slots_lk.lock();
         return member_slots.contains(name);
     }
 
-    Flags Obj::get_flags(const string &name) const {
+    Flags Obj::get_flags(const ObjString *name) const {
         if (const auto it = member_slots.find(name); it != member_slots.end()) {
             return it->second.get_flags();
         }
-        throw IllegalAccessError(std::format("cannot find member: {} in {}", name, to_string()));
+        throw IllegalAccessError(std::format("cannot find member: {} in {}", name->value(), to_string()));
     }
 
-    void Obj::set_flags(const string &name, Flags flags) {
+    void Obj::set_flags(const ObjString *name, Flags flags) {
+        check_mutable();
         if (const auto it = member_slots.find(name); it != member_slots.end()) {
             it->second.set_flags(flags);
             return;
         }
+        throw IllegalAccessError(std::format("cannot find member: {} in {}", name->value(), to_string()));
+    }
+
+    Value Obj::get_member(const string &name) const {
+        if (const auto interned = find_member_name(name))
+            return get_member(interned);
         throw IllegalAccessError(std::format("cannot find member: {} in {}", name, to_string()));
     }
 
-    ObjString::ObjString(const string &str) : Obj(OBJ_STRING), str(str) {}
+    void Obj::set_member(const string &name, Value value) {
+        set_member(intern_member_name(name), value);
+    }
+
+    bool Obj::has_member(const string &name) const {
+        const auto interned = find_member_name(name);
+        return interned && has_member(interned);
+    }
+
+    Flags Obj::get_flags(const string &name) const {
+        if (const auto interned = find_member_name(name))
+            return get_flags(interned);
+        throw IllegalAccessError(std::format("cannot find member: {} in {}", name, to_string()));
+    }
+
+    void Obj::set_flags(const string &name, Flags flags) {
+        if (const auto interned = find_member_name(name)) {
+            set_flags(interned, flags);
+            return;
+        }
+        throw IllegalAccessError(std::format("cannot find member: {} in {}", name, to_string()));
+    }
+
+    /**
+     * Records a payload buffer allocated by @p obj after its construction, since spade::halloc only sees
+     * the payload which exists when the object is constructed
+     * @param obj the object owning the buffer
+     * @param size the size of the buffer in bytes
+     */
+    static void record_payload(const Obj *obj, size_t size) {
+        if (const auto manager = obj->get_manager())
+            if (const auto profiler = manager->get_profiler())
+                profiler->record(obj, size);
+    }
 
-    ObjString::ObjString(const uint8_t *bytes, uint16_t len) : Obj(OBJ_STRING), str(bytes, bytes + len) {}
+    /// Length up to which concatenated strings are copied instead of making a rope
+    static constexpr const size_t MAX_FLAT_CONCAT_LENGTH = 64;
+
+    /// Length up to which slices of strings are copied, since std::string stores such short strings inline
+    static constexpr const size_t MAX_COPIED_SLICE_LENGTH = 15;
+
+    ObjString::ObjString(const string &str) : Obj(OBJ_STRING), str(str), length(this->str.size()), flat(true) {}
+
+    ObjString::ObjString(string &&str) : Obj(OBJ_STRING), str(std::move(str)), length(this->str.size()), flat(true) {}
+
+    ObjString::ObjString(const uint8_t *bytes, uint16_t len)
+        : Obj(OBJ_STRING), str(bytes, bytes + len), length(len), flat(true) {}
+
+    ObjString::ObjString(const ObjString *left, const ObjString *right)
+        : Obj(OBJ_STRING), left(left), right(right), length(left->length + right->length), flat(false) {}
+
+    ObjString::ObjString(const ObjString *parent, size_t offset, size_t length)
+        : Obj(OBJ_STRING), parent(parent), offset(offset), length(length), flat(false) {}
 
     ObjString *ObjString::concat(const ObjString *other) {
-        return halloc_mgr<ObjString>(info.manager, str + other->str);
+        // Short strings are cheaper to copy than to keep as ropes
+        if (length + other->length <= MAX_FLAT_CONCAT_LENGTH)
+            return halloc_mgr<ObjString>(get_manager(), string(view()).append(other->view()));
+        return halloc_mgr<ObjString>(get_manager(), this, other);
+    }
+
+    ObjString *ObjString::concat(MemoryManager *manager, const Value *strings, size_t count) {
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++) total += cast<ObjString>(strings[i].as_obj())->length;
+        string result;
+        result.reserve(total);
+        for (size_t i = 0; i < count; i++) result += cast<ObjString>(strings[i].as_obj())->view();
+        return halloc_mgr<ObjString>(manager, std::move(result));
+    }
+
+    ObjString *ObjString::slice(size_t start, size_t end) {
+        if (end > length)
+            throw IndexError("string", end);
+        if (start > end)
+            throw IndexError("string", start);
+        const auto count = end - start;
+        if (count == length)
+            return this;
+        if (count <= MAX_COPIED_SLICE_LENGTH)
+            return halloc_mgr<ObjString>(get_manager(), string(view().substr(start, count)));
+        // Slice the flat parent, so that a slice never refers to another slice or a rope
+        if (parent)
+            return halloc_mgr<ObjString>(get_manager(), parent, offset + start, count);
+        value();
+        return halloc_mgr<ObjString>(get_manager(), this, start, count);
+    }
+
+    void ObjString::for_each_part(const std::function<void(Obj *)> &func) const {
+        if (parent) {
+            func((Obj *) parent);
+            return;
+        }
+        if (const auto part = left.load(std::memory_order_acquire))
+            func((Obj *) part);
+        if (const auto part = right.load(std::memory_order_acquire))
+            func((Obj *) part);
+    }
+
+    void ObjString::flatten() const {
+        std::lock_guard lk(flatten_lock);
+        if (flat.load(std::memory_order_acquire))
+            return;
+        if (parent) {
+            str = string(view());
+            flat.store(true, std::memory_order_release);
+            return;
+        }
+
+        string result;
+        result.reserve(length);
+        // Walk the rope without recursion, since a string built in a loop makes a rope as deep as the loop
+        vector<const ObjString *> parts{right.load(std::memory_order_relaxed), left.load(std::memory_order_relaxed)};
+        while (!parts.empty()) {
+            const auto part = parts.back();
+            parts.pop_back();
+            if (part->parent) {
+                result += part->view();
+                continue;
+            }
+            if (part->flat.load(std::memory_order_acquire)) {
+                result += part->str;
+                continue;
+            }
+            // Another thread may flatten the part meanwhile, which publishes its contents before clearing its parts
+            const auto part_left = part->left.load(std::memory_order_acquire);
+            const auto part_right = part->right.load(std::memory_order_acquire);
+            if (part_left && part_right) {
+                parts.push_back(part_right);
+                parts.push_back(part_left);
+            } else
+                result += part->str;
+        }
+        str = std::move(result);
+        record_payload(this, length);
+        flat.store(true, std::memory_order_release);
+        left.store(null, std::memory_order_release);
+        right.store(null, std::memory_order_release);
     }
 
     Ordering ObjString::compare(const Obj *other) const {
         if (other->get_tag() == OBJ_STRING) {
-            const auto other_str = cast<const ObjString>(other);
-            if (str < other_str->str)
+            if (this == other)
+                return Ordering::EQUAL;
+            const auto result = view().compare(cast<const ObjString>(other)->view());
+            if (result < 0)
                 return Ordering::LESS;
-            else if (str > other_str->str)
+            else if (result > 0)
                 return Ordering::GREATER;
             else
                 return Ordering::EQUAL;
@@ -145,74 +695,588 @@ namespace spade
         return Ordering::UNDEFINED;
     }
 
-    ObjArray::ObjArray(size_t length) : Obj(OBJ_ARRAY), array(null), length(length) {
-        if (length > 0) {
-            array = std::make_unique<Value[]>(length);
+    size_t ObjString::hash() const {
+        auto hash = hash_code.load(std::memory_order_relaxed);
+        if (hash == 0) {
+            // A zero hash is stored as one, so that it is not computed again
+            hash = std::max<size_t>(std::hash<std::string_view>()(view()), 1);
+            hash_code.store(hash, std::memory_order_relaxed);
+        }
+        return hash;
+    }
+
+    /// Capacity of the storage when an empty array first grows
+    static constexpr const size_t MIN_ARRAY_CAPACITY = 8;
+
+    ObjArray::ObjArray(size_t length) : Obj(OBJ_ARRAY), storage(null), length(length), capacity(length) {}
+
+    ObjArray::ObjArray(size_t length, ElementKind kind) : Obj(OBJ_ARRAY), storage(null), length(length), capacity(length) {
+        allocate(kind);
+        switch (kind) {
+        case ElementKind::EMPTY:
+        case ElementKind::VALUE:
+            return;
+        case ElementKind::INT:
+            kernels::fill(data<int64_t>(), length, 0);
+            break;
+        case ElementKind::FLOAT:
+            kernels::fill(data<double>(), length, 0.0);
+            break;
+        case ElementKind::BYTE:
+            kernels::fill(data<uint8_t>(), length, 0);
+            break;
+        }
+        filled = length;
+    }
+
+    ObjArray::ObjArray(ObjArray *parent, size_t offset, size_t length)
+        : Obj(OBJ_ARRAY), storage(null), length(length), capacity(0), parent(parent), offset(offset) {}
+
+    ObjArray::ElementsLock::ElementsLock(const ObjArray *array) : lk(array->read_lock(array->elements_mtx)) {
+        // A view never views another view, so the locks are always taken from the view to its parent
+        if (array->parent)
+            parent_lk = array->parent->read_lock(array->parent->elements_mtx);
+    }
+
+    size_t ObjArray::element_size(ElementKind kind) {
+        switch (kind) {
+        case ElementKind::EMPTY:
+            return 0;
+        case ElementKind::INT:
+            return sizeof(int64_t);
+        case ElementKind::FLOAT:
+            return sizeof(double);
+        case ElementKind::BYTE:
+            return sizeof(uint8_t);
+        case ElementKind::VALUE:
+            return sizeof(Value);
+        }
+        throw Unreachable();
+    }
+
+    void ObjArray::allocate(ElementKind kind) {
+        this->kind = kind;
+        if (kind == ElementKind::EMPTY || capacity == 0)
+            return;
+        storage = std::make_unique_for_overwrite<std::byte[]>(capacity * element_size(kind));
+        record_payload(this, capacity * element_size(kind));
+        if (kind == ElementKind::VALUE) {
+            std::uninitialized_fill_n(data<Value>(), length, Value());
+            filled = length;
+        }
+    }
+
+    bool ObjArray::fits(ElementKind kind, Value value) {
+        switch (kind) {
+        case ElementKind::INT:
+            return value.is_int();
+        case ElementKind::FLOAT:
+            return value.is_float();
+        case ElementKind::BYTE:
+            return value.is_uint() && value.as_uint() <= UINT8_MAX;
+        default:
+            return false;
+        }
+    }
+
+    Value ObjArray::load(size_t i) const {
+        // The parent may have shrunk since the view was made, so its bounds are checked
+        if (parent)
+            return parent->get(offset + i);
+        if (kind == ElementKind::VALUE)
+            return data<Value>()[i];
+        if (i >= filled)
+            return Value();
+        switch (kind) {
+        case ElementKind::INT:
+            return Value(data<int64_t>()[i]);
+        case ElementKind::FLOAT:
+            return Value(data<double>()[i]);
+        case ElementKind::BYTE:
+            return Value(static_cast<uint64_t>(data<uint8_t>()[i]));
+        default:
+            throw Unreachable();
+        }
+    }
+
+    void ObjArray::store(size_t i, Value value) {
+        publish_stored(value);
+        if (parent) {
+            parent->set(offset + i, value);
+            return;
+        }
+        if (kind == ElementKind::EMPTY) {
+            if (value.is_null())
+                return;
+            // Only an array filled from the beginning can be packed
+            if (i == 0 && value.is_int())
+                allocate(ElementKind::INT);
+            else if (i == 0 && value.is_float())
+                allocate(ElementKind::FLOAT);
+            else
+                allocate(ElementKind::VALUE);
+        }
+        if (kind != ElementKind::VALUE) {
+            if (i <= filled && fits(kind, value)) {
+                switch (kind) {
+                case ElementKind::INT:
+                    data<int64_t>()[i] = value.as_int();
+                    break;
+                case ElementKind::FLOAT:
+                    data<double>()[i] = value.as_float();
+                    break;
+                case ElementKind::BYTE:
+                    data<uint8_t>()[i] = static_cast<uint8_t>(value.as_uint());
+                    break;
+                default:
+                    throw Unreachable();
+                }
+                if (i == filled)
+                    filled++;
+                return;
+            }
+            // The elements after the filled ones are already null
+            if (i >= filled && value.is_null())
+                return;
+            transition_to_values();
+        }
+        data<Value>()[i] = value;
+    }
+
+    void ObjArray::transition_to_values() {
+        auto values = std::make_unique_for_overwrite<std::byte[]>(capacity * sizeof(Value));
+        const auto boxed = reinterpret_cast<Value *>(values.get());
+        for (size_t i = 0; i < length; i++) std::construct_at(boxed + i, load(i));
+        storage = std::move(values);
+        kind = ElementKind::VALUE;
+        filled = length;
+    }
+
+    void ObjArray::detach() {
+        if (!parent)
+            return;
+        const auto source = parent;
+        const auto start = offset;
+        const auto source_lk = source->read_lock(source->elements_mtx);
+        parent = null;
+        offset = 0;
+        capacity = length;
+        if (source->is_packed() && source->filled == source->length && start + length <= source->length) {
+            allocate(source->kind);
+            filled = length;
+            if (length > 0)
+                kernels::copy(storage.get(), source->storage.get() + start * element_size(kind), length * element_size(kind));
+            return;
+        }
+        allocate(ElementKind::VALUE);
+        for (size_t i = 0; i < length; i++) data<Value>()[i] = source->get(start + i);
+    }
+
+    ObjArray *ObjArray::slice(size_t start, size_t end) {
+        const auto lk = read_lock(elements_mtx);
+        if (end > length)
+            throw IndexError("array", end);
+        if (start > end)
+            throw IndexError("array", start);
+        // View the parent, so that a view never refers to another view
+        if (parent)
+            return halloc_mgr<ObjArray>(get_manager(), parent, offset + start, end - start);
+        return halloc_mgr<ObjArray>(get_manager(), this, start, end - start);
+    }
+
+    void ObjArray::reallocate(size_t new_capacity) {
+        if (kind != ElementKind::EMPTY) {
+            const auto size = element_size(kind);
+            auto new_storage = std::make_unique_for_overwrite<std::byte[]>(new_capacity * size);
+            if (const auto used = kind == ElementKind::VALUE ? length : filled; used > 0)
+                kernels::copy(new_storage.get(), storage.get(), used * size);
+            storage = std::move(new_storage);
+            record_payload(this, new_capacity * size);
+        }
+        capacity = new_capacity;
+    }
+
+    void ObjArray::push(Value value) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
+        detach();
+        if (length == capacity)
+            reallocate(std::max(capacity * 2, MIN_ARRAY_CAPACITY));
+        length++;
+        store(length - 1, value);
+    }
+
+    Value ObjArray::pop() {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
+        if (length == 0)
+            throw IndexError("array", 0);
+        detach();
+        const auto value = load(length - 1);
+        length--;
+        filled = std::min(filled, length);
+        return value;
+    }
+
+    void ObjArray::insert(size_t i, Value value) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
+        if (i > length)
+            throw IndexError("array", i);
+        detach();
+        if (length == capacity)
+            reallocate(std::max(capacity * 2, MIN_ARRAY_CAPACITY));
+
+        const auto size = element_size(kind);
+        if (kind == ElementKind::VALUE) {
+            kernels::copy(storage.get() + (i + 1) * size, storage.get() + i * size, (length - i) * size);
+            filled = ++length;
+            publish_stored(value);
+            data<Value>()[i] = value;
+            return;
         }
+        // Only the filled elements are stored, the ones after them are null anyway
+        if (i < filled) {
+            kernels::copy(storage.get() + (i + 1) * size, storage.get() + i * size, (filled - i) * size);
+            filled++;
+        }
+        length++;
+        store(i, value);
+    }
+
+    Value ObjArray::remove(size_t i) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
+        if (i >= length)
+            throw IndexError("array", i);
+        detach();
+        const auto value = load(i);
+        const auto size = element_size(kind);
+        if (kind == ElementKind::VALUE) {
+            kernels::copy(storage.get() + i * size, storage.get() + (i + 1) * size, (length - i - 1) * size);
+            filled = --length;
+            return value;
+        }
+        if (i < filled) {
+            kernels::copy(storage.get() + i * size, storage.get() + (i + 1) * size, (filled - i - 1) * size);
+            filled--;
+        }
+        length--;
+        return value;
+    }
+
+    void ObjArray::reserve(size_t capacity) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
+        detach();
+        if (capacity > this->capacity)
+            reallocate(capacity);
     }
 
     void ObjArray::for_each(const std::function<void(Value)> &func) const {
+        const auto lk = read_lock(elements_mtx);
         for (size_t i = 0; i < length; i++) {
-            func(array[i]);
+            func(load(i));
         }
     }
 
     Value ObjArray::get(int64_t i) const {
+        const auto lk = read_lock(elements_mtx);
         if (i < 0)
             i += length;
         if (i < 0 || i >= length)
             throw IndexError("array", i);
-        return array[i];
+        return load(i);
     }
 
     Value ObjArray::get(size_t i) const {
+        const auto lk = read_lock(elements_mtx);
         if (i >= length)
             throw IndexError("array", i);
-        return array[i];
+        return load(i);
     }
 
     void ObjArray::set(int64_t i, Value value) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
         if (i < 0)
             i += length;
         if (i < 0 || i >= length)
             throw IndexError("array", i);
-        array[i] = value;
+        store(i, value);
     }
 
     void ObjArray::set(size_t i, Value value) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
         if (i >= length)
             throw IndexError("array", i);
-        array[i] = value;
+        store(i, value);
+    }
+
+    void ObjArray::update(size_t i, const std::function<std::optional<Value>(Value)> &func) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
+        if (i >= length)
+            throw IndexError("array", i);
+        // The element of a view lives in its parent, which is locked by its own update
+        if (parent) {
+            parent->update(offset + i, func);
+            return;
+        }
+        if (const auto value = func(load(i)))
+            store(i, *value);
+    }
+
+    void ObjArray::fill(Value value) {
+        check_mutable();
+        const auto lk = write_lock(elements_mtx);
+        if (length == 0)
+            return;
+        if (parent) {
+            for (size_t i = 0; i < length; i++) store(i, value);
+            return;
+        }
+        if (kind == ElementKind::EMPTY) {
+            if (value.is_null())
+                return;
+            allocate(value.is_int() ? ElementKind::INT : value.is_float() ? ElementKind::FLOAT : ElementKind::VALUE);
+        }
+        if (fits(kind, value)) {
+            switch (kind) {
+            case ElementKind::INT:
+                kernels::fill(data<int64_t>(), length, value.as_int());
+                break;
+            case ElementKind::FLOAT:
+                kernels::fill(data<double>(), length, value.as_float());
+                break;
+            case ElementKind::BYTE:
+                kernels::fill(data<uint8_t>(), length, static_cast<uint8_t>(value.as_uint()));
+                break;
+            default:
+                throw Unreachable();
+            }
+            filled = length;
+            return;
+        }
+        if (is_packed()) {
+            if (value.is_null() && filled == 0)
+                return;
+            transition_to_values();
+        }
+        publish_stored(value);
+        std::fill_n(data<Value>(), length, value);
     }
 
     string ObjArray::to_string() const {
+        const auto lk = read_lock(elements_mtx);
         string str;
         for (size_t i = 0; i < length; ++i) {
-            str += array[i].to_string() + (i < length - 1 ? ", " : "");
+            str += load(i).to_string() + (i < length - 1 ? ", " : "");
         }
         return "[" + str + "]";
     }
 
     Obj *ObjArray::copy() const {
-        auto new_array = halloc_mgr<ObjArray>(info.manager, length);
+        const auto lk = read_lock(elements_mtx);
+        auto new_array = halloc_mgr<ObjArray>(get_manager(), length);
+        if (!parent && is_packed()) {
+            // The packed elements are never objects, so they are copied as they are
+            new_array->allocate(kind);
+            new_array->filled = filled;
+            if (filled > 0)
+                kernels::copy(new_array->storage.get(), storage.get(), filled * element_size(kind));
+            return new_array;
+        }
         for (size_t i = 0; i < length; i++) {
-            new_array->set(i, get(i).copy());
+            new_array->set(i, load(i).copy());
         }
         return new_array;
     }
 
+    /// @return the index of the first element where @p lhs and @p rhs differ within @p n elements, 0 if they are not packed as @p T
+    template<typename T>
+    static size_t packed_mismatch(const ObjArray *lhs, const ObjArray *rhs, size_t n) {
+        const auto lhs_data = lhs->get_packed<T>();
+        const auto rhs_data = rhs->get_packed<T>();
+        return lhs_data && rhs_data ? kernels::mismatch(lhs_data, rhs_data, n) : 0;
+    }
+
     Ordering ObjArray::compare(const Obj *other) const {
-        if (other->get_tag() == OBJ_ARRAY) {
-            const auto str = to_string();
-            const auto other_str = other->to_string();
-            if (str < other_str)
-                return Ordering::LESS;
-            else if (str > other_str)
-                return Ordering::GREATER;
-            else
-                return Ordering::EQUAL;
+        if (other->get_tag() != OBJ_ARRAY)
+            return Ordering::UNDEFINED;
+        const auto other_array = cast<const ObjArray>(other);
+        const ElementsLock lk(this), other_lk(other_array);
+        const auto n = std::min(length, other_array->length);
+
+        size_t i = 0;
+        // Skip the equal prefix of packed arrays of the same kind with the kernels
+        if (get_element_kind() == other_array->get_element_kind()) {
+            switch (get_element_kind()) {
+            case ElementKind::INT:
+                i = packed_mismatch<int64_t>(this, other_array, n);
+                break;
+            case ElementKind::FLOAT:
+                i = packed_mismatch<double>(this, other_array, n);
+                break;
+            case ElementKind::BYTE:
+                i = packed_mismatch<uint8_t>(this, other_array, n);
+                break;
+            default:
+                break;
+            }
         }
-        return Ordering::UNDEFINED;
+        for (; i < n; i++) {
+            if (const auto ordering = load(i).compare(other_array->load(i)); ordering != Ordering::EQUAL)
+                return ordering;
+        }
+        if (length < other_array->length)
+            return Ordering::LESS;
+        if (length > other_array->length)
+            return Ordering::GREATER;
+        return Ordering::EQUAL;
+    }
+
+    size_t ObjArray::hash() const {
+        const auto lk = read_lock(elements_mtx);
+        size_t seed = 0;
+        for (size_t i = 0; i < length; i++) ValueHash().hash(seed, load(i));
+        return seed;
+    }
+
+    /// Freezes @p key if it is an array, since changing its elements would change its hash
+    static void freeze_key(Value key) {
+        if (key.is_obj() && key.as_obj()->get_tag() == OBJ_ARRAY)
+            key.as_obj()->freeze();
+    }
+
+    ObjMap::ObjMap() : Obj(OBJ_MAP) {}
+
+    Value ObjMap::get(Value key) const {
+        const auto lk = read_lock(table_mtx);
+        if (const auto entry = table.find(key))
+            return entry->second;
+        throw KeyError(key.to_string());
+    }
+
+    Value ObjMap::get(Value key, Value fallback) const {
+        const auto lk = read_lock(table_mtx);
+        if (const auto entry = table.find(key))
+            return entry->second;
+        return fallback;
+    }
+
+    void ObjMap::set(Value key, Value value) {
+        check_mutable();
+        freeze_key(key);
+        publish_stored(key);
+        publish_stored(value);
+        const auto lk = write_lock(table_mtx);
+        table.insert(key).first->second = value;
+    }
+
+    bool ObjMap::contains(Value key) const {
+        const auto lk = read_lock(table_mtx);
+        return table.find(key) != null;
+    }
+
+    bool ObjMap::remove(Value key) {
+        check_mutable();
+        const auto lk = write_lock(table_mtx);
+        return table.erase(key);
+    }
+
+    void ObjMap::clear() {
+        check_mutable();
+        const auto lk = write_lock(table_mtx);
+        table.clear();
+    }
+
+    void ObjMap::reserve(size_t count) {
+        check_mutable();
+        const auto lk = write_lock(table_mtx);
+        table.reserve(count);
+    }
+
+    void ObjMap::for_each(const std::function<void(Value, Value)> &func) const {
+        const auto lk = read_lock(table_mtx);
+        table.for_each([&func](const std::pair<Value, Value> &entry) { func(entry.first, entry.second); });
+    }
+
+    string ObjMap::to_string() const {
+        const auto lk = read_lock(table_mtx);
+        string str;
+        table.for_each([&str](const std::pair<Value, Value> &entry) {
+            if (!str.empty())
+                str += ", ";
+            str += entry.first.to_string() + ": " + entry.second.to_string();
+        });
+        return "{" + str + "}";
+    }
+
+    Obj *ObjMap::copy() const {
+        const auto lk = read_lock(table_mtx);
+        const auto new_map = halloc_mgr<ObjMap>(get_manager());
+        new_map->reserve(table.count());
+        table.for_each([new_map](const std::pair<Value, Value> &entry) { new_map->set(entry.first.copy(), entry.second.copy()); });
+        return new_map;
+    }
+
+    ObjSet::ObjSet() : Obj(OBJ_SET) {}
+
+    bool ObjSet::add(Value value) {
+        check_mutable();
+        freeze_key(value);
+        publish_stored(value);
+        const auto lk = write_lock(table_mtx);
+        return table.insert(value).second;
+    }
+
+    bool ObjSet::contains(Value value) const {
+        const auto lk = read_lock(table_mtx);
+        return table.find(value) != null;
+    }
+
+    bool ObjSet::remove(Value value) {
+        check_mutable();
+        const auto lk = write_lock(table_mtx);
+        return table.erase(value);
+    }
+
+    void ObjSet::clear() {
+        check_mutable();
+        const auto lk = write_lock(table_mtx);
+        table.clear();
+    }
+
+    void ObjSet::reserve(size_t count) {
+        check_mutable();
+        const auto lk = write_lock(table_mtx);
+        table.reserve(count);
+    }
+
+    void ObjSet::for_each(const std::function<void(Value)> &func) const {
+        const auto lk = read_lock(table_mtx);
+        table.for_each(func);
+    }
+
+    string ObjSet::to_string() const {
+        const auto lk = read_lock(table_mtx);
+        string str;
+        table.for_each([&str](Value value) {
+            if (!str.empty())
+                str += ", ";
+            str += value.to_string();
+        });
+        return "{" + str + "}";
+    }
+
+    Obj *ObjSet::copy() const {
+        const auto lk = read_lock(table_mtx);
+        const auto new_set = halloc_mgr<ObjSet>(get_manager());
+        new_set->reserve(table.count());
+        table.for_each([new_set](Value value) { new_set->add(value.copy()); });
+        return new_set;
     }
 
     ObjModule::ObjModule(const Sign &sign) : Obj(OBJ_MODULE), sign(sign) {}
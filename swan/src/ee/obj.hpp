@@ -1,10 +1,13 @@
 #pragma once
 
+#include "ee/hashtable.hpp"
+#include "ee/monitor.hpp"
 #include "ee/value.hpp"
 #include "utils/common.hpp"
 #include "memory/manager.hpp"
 #include "spinfo/sign.hpp"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -198,31 +201,101 @@ namespace spade
         OBJ_FOREIGN,
         // Type
         OBJ_TYPE,
+        // ObjMap
+        OBJ_MAP,
+        // ObjSet
+        OBJ_SET,
+        // ObjGenerator
+        OBJ_GENERATOR,
+        // ObjTask
+        OBJ_TASK,
+        // ObjChannel
+        OBJ_CHANNEL,
     };
 
-    struct MemoryInfo {
-        // bool marked = false;
-        MemoryManager *manager = null;
+    /// The header of an object has 5 bits for the tag
+    static_assert(OBJ_CHANNEL < 32, "too many object tags for the header");
+
+    /**
+     * @param tag the object tag
+     * @return the name of the object tag
+     */
+    SWAN_EXPORT string tag_to_string(ObjTag tag);
+
+    /**
+     * Flags stored in the header of an object
+     */
+    enum ObjFlag : uint8_t {
+        /// The object is marked by the garbage collector
+        OBJ_FLAG_MARKED = 1 << 0,
+        /// The object and the data reachable from it cannot be modified
+        OBJ_FLAG_FROZEN = 1 << 1,
     };
 
     class Type;
+    class ObjString;
+
+    /// Member slots keyed by the interned names of the members, so finding a member hashes a pointer
+    using MemberTable = std::unordered_map<const ObjString *, MemberSlot>;
 
+    /**
+     * The base of all the objects. The object header is 16 bytes and has no vtable,
+     * the behaviour specific to an object kind is dispatched on its tag.
+     *
+     * The layout of the header is:
+     *
+     *     word 0:   [heap id: 11][tag: 5][type pointer: 45][flags: 3]
+     *     word 1:   [lock word: 64]
+     *
+     * The type pointer is aligned to 8 bytes, so its lower 3 bits hold the flags.
+     * The heap id identifies the memory manager which allocated the object.
+     *
+     * An object is confined to the thread which allocated it until it is published, which happens once
+     * when it is about to become reachable from another thread: when it is stored into a global,
+     * into a shared object or sent to another thread. The thread owning a confined object accesses
+     * its members without taking the lock of the member slots.
+     *
+     * A frozen object is published and can never be modified again, so every thread reads its members
+     * without taking the lock. Freezing is deep over the data (strings, arrays, maps, sets, plain objects
+     * and types without static fields), the other objects reachable from a frozen object are only published.
+     */
     class SWAN_EXPORT Obj {
+        static constexpr const uint32_t SHARED_OWNER = 0;
+        static constexpr const uint64_t FLAGS_MASK = 0x7;
+        static constexpr const uint64_t TYPE_MASK = 0x0000'FFFF'FFFF'FFF8;
+        static constexpr const uint64_t TAG_SHIFT = 48;
+        static constexpr const uint64_t TAG_MASK = 0x1F;
+        static constexpr const uint64_t HEAP_ID_SHIFT = 53;
+        static constexpr const uint64_t HEAP_ID_MASK = MemoryManager::MAX_HEAPS - 1;
+        static_assert(HEAP_ID_SHIFT + MemoryManager::HEAP_ID_BITS == 64);
+
       protected:
-        /// Tag of the object
-        ObjTag tag;
+        /// Heap id, tag, type and flags of the object
+        std::atomic<uint64_t> header;
         /// Monitor of the object
-        mutable std::recursive_mutex monitor;
-        /// Memory info of the object
-        MemoryInfo info;
-        /// Type of the object
-        Type *type;
+        ThinLock monitor;
         /// Member slots of the object
-        Table<MemberSlot> member_slots;
-        mutable std::shared_mutex member_slots_mtx;
+        MemberTable member_slots;
+        mutable SpinRwLock member_slots_mtx;
+        /// Lock id of the thread which allocated the object, SHARED_OWNER once the object is published
+        std::atomic<uint32_t> owner;
 
         Obj(ObjTag tag);
 
+        /**
+         * Locks @p mtx for reading, unless no other thread can write this object
+         * @param mtx the lock guarding some state of this object
+         * @return the lock, which does not own @p mtx if locking was skipped
+         */
+        std::shared_lock<SpinRwLock> read_lock(SpinRwLock &mtx) const;
+
+        /**
+         * Locks @p mtx for writing, unless no other thread can access this object
+         * @param mtx the lock guarding some state of this object
+         * @return the lock, which does not own @p mtx if locking was skipped
+         */
+        std::unique_lock<SpinRwLock> write_lock(SpinRwLock &mtx) const;
+
       public:
         Obj(Type *type);
 
@@ -231,38 +304,86 @@ namespace spade
         Obj(Obj &&) = delete;
         Obj &operator=(const Obj &) = delete;
         Obj &operator=(Obj &&) = delete;
+        ~Obj() = default;
+
+        static bool classof(const Obj *) {
+            return true;
+        }
+
+        /**
+         * Destroys @p obj by calling the destructor of its actual kind.
+         * The memory of the object is not freed
+         * @param obj the object to be destroyed
+         */
+        static void destroy(Obj *obj);
 
         /**
-         * Virtual destructor for Obj
+         * Computes the size of @p obj by dispatching on its tag, so the payload
+         * owned by the object (string contents, array storage, code, etc.) is counted
+         * along with the object itself
+         * @param obj the object
+         * @return the approximate number of bytes occupied by the object itself (excluding the referenced objects)
          */
-        virtual ~Obj() = default;
+        static size_t size_of(const Obj *obj);
 
         /**
          * @return the tag of the object
          */
         ObjTag get_tag() const {
-            return tag;
+            return static_cast<ObjTag>(header.load(std::memory_order_relaxed) >> TAG_SHIFT & TAG_MASK);
         }
 
         /**
-         * @return the memory info of the object
+         * @return the id of the heap which the object belongs to
          */
-        const MemoryInfo &get_info() const {
-            return info;
+        uint16_t get_heap_id() const {
+            return static_cast<uint16_t>(header.load(std::memory_order_relaxed) >> HEAP_ID_SHIFT & HEAP_ID_MASK);
         }
 
         /**
-         * @return the memory info of the object
+         * @return the memory manager which allocated the object, null if the object was not allocated by a manager
          */
-        MemoryInfo &get_info() {
-            return info;
+        MemoryManager *get_manager() const {
+            return MemoryManager::get_heap(get_heap_id());
+        }
+
+        /**
+         * Sets the memory manager of the object. This is called by spade::halloc and spade::halloc_mgr
+         * @param manager the memory manager
+         */
+        void set_manager(MemoryManager *manager) {
+            update_header(HEAP_ID_MASK << HEAP_ID_SHIFT, static_cast<uint64_t>(manager ? manager->get_heap_id() : 0) << HEAP_ID_SHIFT);
+        }
+
+        /**
+         * @param flag the flag
+         * @return true if @p flag is set in the header
+         */
+        bool has_flag(ObjFlag flag) const {
+            return header.load(std::memory_order_acquire) & flag;
+        }
+
+        /**
+         * Sets @p flag in the header
+         * @param flag the flag
+         */
+        void set_flag(ObjFlag flag) {
+            header.fetch_or(flag, std::memory_order_acq_rel);
+        }
+
+        /**
+         * Clears @p flag in the header
+         * @param flag the flag
+         */
+        void clear_flag(ObjFlag flag) {
+            header.fetch_and(~static_cast<uint64_t>(flag), std::memory_order_acq_rel);
         }
 
         /**
          * @return the type of the object
          */
         Type *get_type() const {
-            return type;
+            return reinterpret_cast<Type *>(header.load(std::memory_order_relaxed) & TYPE_MASK);
         }
 
         /**
@@ -274,17 +395,101 @@ namespace spade
         /**
          * @return the members of this object
          */
-        const Table<MemberSlot> &get_member_slots() const {
+        const MemberTable &get_member_slots() const {
             return member_slots;
         }
 
+        /**
+         * @return true if the object is confined to the current thread, so its members can be accessed without locking
+         */
+        bool is_confined() const;
+
+        /**
+         * @return true if the object has been published
+         */
+        bool is_shared() const {
+            return owner.load(std::memory_order_acquire) == SHARED_OWNER;
+        }
+
+        /**
+         * @return true if the object is frozen
+         */
+        bool is_frozen() const {
+            return has_flag(OBJ_FLAG_FROZEN);
+        }
+
+        /**
+         * Freezes the object and the data reachable from it, and publishes the other objects reachable from it.
+         * An object which cannot be frozen, such as a module or a task, is only published
+         */
+        void freeze();
+
+        /**
+         * Freezes @p value if it is an object
+         * @param value the value
+         */
+        static void freeze(Value value) {
+            if (value.is_obj())
+                value.as_obj()->freeze();
+        }
+
+        /**
+         * @throws FrozenObjectError if the object is frozen
+         */
+        void check_mutable() const;
+
+        /**
+         * Publishes the object and every object reachable from it, after which their members are accessed
+         * under the lock of the member slots by every thread. This must be called before the object becomes
+         * reachable from another thread, and does nothing if the object is already published
+         */
+        void publish();
+
+        /**
+         * Publishes @p value if it is an object
+         * @param value the value
+         */
+        static void publish(Value value) {
+            if (value.is_obj())
+                value.as_obj()->publish();
+        }
+
+        /**
+         * Publishes @p value if this object is published, since storing into this object makes @p value
+         * reachable from the threads sharing this object
+         * @param value the value to be stored into this object
+         */
+        void publish_stored(Value value) const {
+            if (value.is_obj() && is_shared())
+                value.as_obj()->publish();
+        }
+
+        /**
+         * Calls @p func for every object directly referenced by this object
+         * @param func the function to be called
+         */
+        void for_each_reference(const std::function<void(Obj *)> &func) const;
+
         /**
          * Performs a complete deep copy on the object.
          * @return a copy of the object
          */
-        virtual Obj *copy() const;
+        Obj *copy() const;
+
+        /**
+         * Compares the object structurally with @p other.
+         * Strings are compared by their contents and arrays lexicographically by their elements,
+         * the other objects are only equal to themselves
+         * @param other the other object
+         * @return the ordering of this object relative to @p other
+         */
+        Ordering compare(const Obj *other) const;
+
+        /**
+         * @return the hash of the object, consistent with ValueEqual
+         */
+        size_t hash() const;
 
-        virtual Ordering compare(const Obj *other) const;
         Value operator<(const Obj *other) const;
         Value operator>(const Obj *other) const;
         Value operator<=(const Obj *other) const;
@@ -295,14 +500,12 @@ namespace spade
         /**
          * @return the corresponding truth value of the object
          */
-        virtual bool truth() const {
-            return true;
-        }
+        bool truth() const;
 
         /**
          * @return a string representation of this object for VM context only
          */
-        virtual string to_string() const;
+        string to_string() const;
 
         /**
          * Enters the monitor for this object.
@@ -310,6 +513,7 @@ namespace spade
          * The call is blocked until the monitor is exited.
          * The user may enter the monitor `n` number of times but he should take 
          * responsibility to exit the monitor exactly `n` number of times. 
+         * The monitor is a thin lock which is inflated only under contention.
          */
         void enter_monitor() const {
             monitor.lock();
@@ -317,47 +521,117 @@ namespace spade
 
         /**
          * Exits the monitor for this object.
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
          */
         void exit_monitor() const {
             monitor.unlock();
         }
 
+        /**
+         * Exits the monitor for this object and waits until the current thread is notified or @p timeout elapses,
+         * then enters the monitor again as many times as it was entered before.
+         * The current thread is blocked while it waits, even if it is a worker thread running a task
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
+         * @param timeout the maximum time to wait, the wait does not time out if it is empty
+         * @return true if the current thread was notified, false if the wait timed out
+         */
+        bool wait_monitor(std::optional<std::chrono::nanoseconds> timeout) const {
+            return monitor.wait(timeout);
+        }
+
+        /**
+         * Wakes up the thread which has waited the longest on the monitor for this object
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
+         */
+        void notify_monitor() const {
+            monitor.notify();
+        }
+
+        /**
+         * Wakes up all the threads waiting on the monitor for this object
+         * @throws IllegalMonitorStateError if the current thread does not own the monitor
+         */
+        void notify_all_monitor() const {
+            monitor.notify_all();
+        }
+
         /**
          * @throws IllegalAccessError if the member cannot be found
-         * @param name the name of the member
+         * @param name the interned name of the member
          * @return the member of this object
          */
-        Value get_member(const string &name) const;
+        Value get_member(const ObjString *name) const;
 
         /**
          * Sets the member of this object with @p name and sets it to @p value.
          * If a member with @p name does not exist then creates a new member and sets it to @p value
-         * @param name name of the member
+         * @param name the interned name of the member
          * @param value value to be set to
          */
-        void set_member(const string &name, Value value);
+        void set_member(const ObjString *name, Value value);
+
+        /**
+         * Calls @p func with the value of the member with @p name and sets the member to the value it returns,
+         * if any. The member slots stay locked for the whole update, so the update is atomic with respect to
+         * every other access of the member. @p func must not access the members of this object, and a value
+         * it returns must already be published if this object is shared
+         * @throws IllegalAccessError if there is no such member
+         * @param name the interned name of the member
+         * @param func the function computing the new value
+         */
+        void update_member(const ObjString *name, const std::function<std::optional<Value>(Value)> &func);
 
         /**
          * Returns whether a specific member is present in the object
-         * @param name the name of the member
+         * @param name the interned name of the member
          * @return true if member is present, false otherwise
          */
-        bool has_member(const string &name) const;
+        bool has_member(const ObjString *name) const;
 
         /**
          * @throws IllegalAccessError if the member cannot be found
-         * @param name the name of the member
+         * @param name the interned name of the member
          * @return the access flags of the member of this object
          */
-        Flags get_flags(const string &name) const;
+        Flags get_flags(const ObjString *name) const;
 
         /**
          * Sets the access flags of the member of this object with @p name and sets it to @p value.
          * @throws IllegalAccessError if the member cannot be found
-         * @param name name of the member
+         * @param name the interned name of the member
          * @param flags flags to be set to
          */
+        void set_flags(const ObjString *name, Flags flags);
+
+        // The overloads taking the name as a string look the name up in the intern table of the vm
+
+        Value get_member(const string &name) const;
+        void set_member(const string &name, Value value);
+        bool has_member(const string &name) const;
+        Flags get_flags(const string &name) const;
         void set_flags(const string &name, Flags flags);
+
+      private:
+        /**
+         * @param name the name of a member
+         * @return the interned string of @p name, null if it is not interned so no object has such a member
+         */
+        const ObjString *find_member_name(const string &name) const;
+
+        /**
+         * @param name the name of a member
+         * @return the interned string of @p name, which is interned if it is not already
+         */
+        const ObjString *intern_member_name(const string &name) const;
+
+        static uint64_t make_header(ObjTag tag, Type *type) {
+            return static_cast<uint64_t>(tag) << TAG_SHIFT | (reinterpret_cast<uint64_t>(type) & TYPE_MASK);
+        }
+
+        void update_header(uint64_t mask, uint64_t bits) {
+            auto value = header.load(std::memory_order_relaxed);
+            while (!header.compare_exchange_weak(value, (value & ~mask) | bits, std::memory_order_acq_rel, std::memory_order_relaxed));
+        }
     };
 
     class ObjString;
@@ -367,44 +641,244 @@ namespace spade
     class ObjMethod;
     class ObjCapture;
 
+    /**
+     * Represents a string.
+     * Concatenating long strings makes a rope which refers to both parts instead of copying them,
+     * so that building a string piece by piece takes linear time. A rope is flattened into a single
+     * buffer the first time its contents are needed, which releases the parts.
+     *
+     * Slicing a long string makes a slice which views the bytes of its flat parent instead of copying them.
+     * A slice keeps its parent alive and only copies its bytes when value() needs them as a string.
+     */
     class SWAN_EXPORT ObjString final : public Obj {
+        friend class InternTable;
+
       private:
-        string str;
+        /// Contents of the string, empty until a rope is flattened or a slice is copied
+        mutable string str;
+        /// Parts of a rope which is not flattened yet, null otherwise. They are cleared only after the flat contents are published
+        mutable std::atomic<const ObjString *> left = null;
+        mutable std::atomic<const ObjString *> right = null;
+        /// The flat string viewed by a slice, null otherwise
+        const ObjString *parent = null;
+        /// Offset of a slice in its parent
+        size_t offset = 0;
+        size_t length;
+        mutable std::atomic<bool> flat;
+        /// Serializes the flattening of this string, reading a flat string needs no locking
+        mutable SpinLock flatten_lock;
+        /// Atom id of the string if it is interned, zero otherwise
+        uint32_t atom = 0;
+        /// Hash of the string, zero until it is first computed
+        mutable std::atomic<size_t> hash_code = 0;
 
       public:
         ObjString(const string &str);
+        ObjString(string &&str);
         ObjString(const uint8_t *bytes, uint16_t len);
 
+        /**
+         * Creates a rope of @p left followed by @p right
+         * @param left the first part
+         * @param right the second part
+         */
+        ObjString(const ObjString *left, const ObjString *right);
+
+        /**
+         * Creates a slice of @p length bytes of @p parent starting at @p offset
+         * @param parent the flat string
+         * @param offset the offset of the slice
+         * @param length the length of the slice
+         */
+        ObjString(const ObjString *parent, size_t offset, size_t length);
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_STRING;
+        }
+
         ObjString *concat(const ObjString *other);
 
-        bool truth() const override {
-            return !str.empty();
+        /**
+         * Concatenates the strings in @p strings into a single flat string
+         * @param manager the memory manager of the new string
+         * @param strings the strings
+         * @param count the number of strings
+         * @throws CastError if any of the values is not a string
+         * @return the concatenated string
+         */
+        static ObjString *concat(MemoryManager *manager, const Value *strings, size_t count);
+
+        /**
+         * Makes a string of the bytes of this string from @p start up to @p end.
+         * Short strings are copied, the longer ones are slices of this string
+         * @throws IndexError if the range is out of bounds
+         * @param start the start of the range
+         * @param end the end of the range, exclusive
+         * @return the string
+         */
+        ObjString *slice(size_t start, size_t end);
+
+        /**
+         * @return the length of the string in bytes, which is known without flattening
+         */
+        size_t size() const {
+            return length;
         }
 
-        string to_string() const override {
-            return str;
+        bool is_rope() const {
+            return !flat.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @return the atom id of the string if it is interned, zero otherwise
+         */
+        uint32_t get_atom() const {
+            return atom;
         }
 
-        Obj *copy() const override {
+        bool is_interned() const {
+            return atom != 0;
+        }
+
+        bool is_slice() const {
+            return parent != null;
+        }
+
+        /**
+         * Calls @p func with the strings referred by this string,
+         * which are the parts of a rope which is not flattened yet or the parent of a slice
+         * @param func the function to be called
+         */
+        void for_each_part(const std::function<void(Obj *)> &func) const;
+
+        bool truth() const {
+            return length != 0;
+        }
+
+        string to_string() const {
+            return string(view());
+        }
+
+        Obj *copy() const {
             // immutable state
             return (Obj *) this;
         }
 
-        Ordering compare(const Obj *other) const override;
+        Ordering compare(const Obj *other) const;
+
+        /**
+         * @return the hash of the string, which is computed once and cached
+         */
+        size_t hash() const;
 
-        string value() const {
+        /**
+         * @return the contents of the string, flattening it if it is a rope
+         */
+        const string &value() const {
+            if (is_rope())
+                flatten();
             return str;
         }
+
+        /**
+         * @return the contents of the string, viewed in the parent if the string is a slice
+         */
+        std::string_view view() const {
+            if (parent)
+                return std::string_view(parent->str).substr(offset, length);
+            return value();
+        }
+
+      private:
+        void flatten() const;
     };
 
+    /**
+     * Represents an array.
+     * The elements are stored unboxed as long as they are all of the same packed kind, which avoids
+     * the tag of each value and lets the bulk kernels work on them. An array starts out empty and picks
+     * its kind from the first element stored at index 0. The packed elements are filled in order from the
+     * beginning, the elements after the filled ones are null. Storing an element which does not fit the kind
+     * or leaves a hole transitions the array to boxed values, which it never leaves.
+     *
+     * The array can also be used as a list, the storage grows by doubling its capacity
+     * so that appending an element takes amortized constant time.
+     *
+     * Slicing an array makes a view which shares the elements of its parent, so reading and writing the
+     * elements of the view reads and writes the parent. A view keeps its parent alive. Changing the length
+     * of a view detaches it from the parent by copying the elements it views.
+     *
+     * The elements of a published array are guarded by a reader-writer lock, which is held exclusively while
+     * the storage is grown, boxed or otherwise changed and shared while the elements are read. Frozen and confined
+     * arrays are accessed without locking, like the member slots of an object.
+     */
     class SWAN_EXPORT ObjArray final : public Obj {
+      public:
+        enum class ElementKind : uint8_t {
+            /// No element is stored, all the elements are null
+            EMPTY,
+            /// Packed ints as int64_t
+            INT,
+            /// Packed floats as double
+            FLOAT,
+            /// Packed uints less than 256 as uint8_t, only chosen on creation
+            BYTE,
+            /// Boxed values of any kind
+            VALUE,
+        };
+
       private:
-        std::unique_ptr<Value[]> array;
+        std::unique_ptr<std::byte[]> storage;
         size_t length;
+        /// Number of elements the storage can hold
+        size_t capacity;
+        /// Number of elements stored from the beginning in a packed array
+        size_t filled = 0;
+        ElementKind kind = ElementKind::EMPTY;
+        /// The array viewed by a view, null otherwise
+        ObjArray *parent = null;
+        /// Offset of a view in its parent
+        size_t offset = 0;
+        mutable SpinRwLock elements_mtx;
 
       public:
+        /**
+         * Keeps the storage of an array from being reallocated or boxed while it is held, so that
+         * the elements returned by get_packed stay valid. The parent of a view is locked as well
+         */
+        class SWAN_EXPORT ElementsLock {
+            std::shared_lock<SpinRwLock> lk;
+            std::shared_lock<SpinRwLock> parent_lk;
+
+          public:
+            explicit ElementsLock(const ObjArray *array);
+        };
+
         explicit ObjArray(size_t length);
 
+        /**
+         * Creates an array of @p kind where every element is zero (null if @p kind is ElementKind::VALUE)
+         * @param length the length of the array
+         * @param kind the element kind of the array
+         */
+        ObjArray(size_t length, ElementKind kind);
+
+        /**
+         * Creates a view of @p length elements of @p parent starting at @p offset
+         * @param parent the array which is not a view
+         * @param offset the offset of the view
+         * @param length the length of the view
+         */
+        ObjArray(ObjArray *parent, size_t offset, size_t length);
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_ARRAY;
+        }
+
+        /**
+         * Calls @p func with every element of the array, which @p func must not modify
+         * @param func the function to be called
+         */
         void for_each(const std::function<void(Value)> &func) const;
 
         Value get(int64_t i) const;
@@ -412,19 +886,316 @@ namespace spade
         void set(int64_t i, Value value);
         void set(size_t i, Value value);
 
+        /**
+         * Sets every element of the array to @p value
+         * @param value the value
+         */
+        void fill(Value value);
+
+        /**
+         * Calls @p func with the element at @p i and sets the element to the value it returns, if any.
+         * The elements stay locked for the whole update, so the update is atomic with respect to every
+         * other access of the array. @p func must not access the elements of this array
+         * @throws IndexError if @p i is out of bounds
+         * @param i the index
+         * @param func the function computing the new value
+         */
+        void update(size_t i, const std::function<std::optional<Value>(Value)> &func);
+
+        /**
+         * Appends @p value at the end of the array
+         * @param value the value
+         */
+        void push(Value value);
+
+        /**
+         * Removes the last element of the array
+         * @throws IndexError if the array is empty
+         * @return the removed element
+         */
+        Value pop();
+
+        /**
+         * Inserts @p value at @p i, shifting the elements from @p i to the right
+         * @throws IndexError if @p i is greater than the length of the array
+         * @param i the index, which can be equal to the length to append
+         * @param value the value
+         */
+        void insert(size_t i, Value value);
+
+        /**
+         * Removes the element at @p i, shifting the elements after @p i to the left
+         * @throws IndexError if @p i is out of bounds
+         * @param i the index
+         * @return the removed element
+         */
+        Value remove(size_t i);
+
+        /**
+         * Ensures that the array can hold @p capacity elements without growing
+         * @param capacity the capacity
+         */
+        void reserve(size_t capacity);
+
+        /**
+         * Makes a view of the elements of the array from @p start up to @p end
+         * @throws IndexError if the range is out of bounds
+         * @param start the start of the range
+         * @param end the end of the range, exclusive
+         * @return the view
+         */
+        ObjArray *slice(size_t start, size_t end);
+
+        /**
+         * @return the array viewed by this array, null if this array is not a view
+         */
+        ObjArray *get_parent() const {
+            return parent;
+        }
+
+        /**
+         * @return the offset of this view in the array it views, 0 if this array is not a view
+         */
+        size_t get_offset() const {
+            return offset;
+        }
+
         size_t count() const {
             return length;
         }
 
-        bool truth() const override {
+        size_t get_capacity() const {
+            return capacity;
+        }
+
+        ElementKind get_element_kind() const {
+            return parent ? parent->kind : kind;
+        }
+
+        /**
+         * @return true if the elements are stored unboxed, so the array cannot refer to any object
+         */
+        bool is_packed() const {
+            return get_element_kind() != ElementKind::VALUE;
+        }
+
+        /**
+         * The elements are only valid while an ElementsLock of the array is held
+         * @return the packed elements of the array if every element is stored unboxed as @p T, null otherwise
+         */
+        template<typename T>
+        T *get_packed() const {
+            if (parent) {
+                const auto data = parent->get_packed<T>();
+                return data && offset + length <= parent->length ? data + offset : null;
+            }
+            if (kind != packed_kind<T>() || filled != length)
+                return null;
+            return reinterpret_cast<T *>(storage.get());
+        }
+
+        /**
+         * @return the number of bytes used to store the elements
+         */
+        size_t get_storage_size() const {
+            return storage ? capacity * element_size(kind) : 0;
+        }
+
+        bool truth() const {
             return length != 0;
         }
 
-        string to_string() const override;
-        Obj *copy() const override;
+        string to_string() const;
+        Obj *copy() const;
+
+        /// Does lexicographical comparison of the elements
+        Ordering compare(const Obj *other) const;
+
+        /**
+         * @return the hash of the elements, consistent with ValueEqual
+         */
+        size_t hash() const;
+
+        template<typename T>
+        static constexpr ElementKind packed_kind() {
+            if constexpr (std::is_same_v<T, int64_t>)
+                return ElementKind::INT;
+            else if constexpr (std::is_same_v<T, double>)
+                return ElementKind::FLOAT;
+            else if constexpr (std::is_same_v<T, uint8_t>)
+                return ElementKind::BYTE;
+            else
+                static_assert(!sizeof(T), "not a packed element type");
+        }
+
+      private:
+        static size_t element_size(ElementKind kind);
+
+        template<typename T>
+        T *data() const {
+            return reinterpret_cast<T *>(storage.get());
+        }
+
+        /// Allocates the storage for @p kind, the packed elements are left uninitialized
+        void allocate(ElementKind kind);
 
-        /// Does lexicographical comparison
-        Ordering compare(const Obj *other) const override;
+        /// Moves the elements to a storage which can hold @p new_capacity elements
+        void reallocate(size_t new_capacity);
+
+        Value load(size_t i) const;
+        void store(size_t i, Value value);
+
+        /// @return true if @p value can be stored unboxed in an array of @p kind
+        static bool fits(ElementKind kind, Value value);
+
+        /// Boxes the packed elements into values
+        void transition_to_values();
+
+        /// Copies the elements viewed by a view into its own storage
+        void detach();
+    };
+
+    /**
+     * Represents a map from keys to values.
+     * The keys are hashed and compared by ValueHash and ValueEqual, so strings and arrays are keys by their contents.
+     * The entries are kept in a ValueTable, which makes a lookup cost a few byte compares in the common case.
+     * An array used as a key is frozen, since changing its elements would change its hash and lose its entry.
+     *
+     * The table of a published map is guarded by a reader-writer lock, which is held shared for lookups
+     * and exclusively for the changes. Frozen and confined maps are accessed without locking.
+     */
+    class SWAN_EXPORT ObjMap final : public Obj {
+      private:
+        ValueTable<std::pair<Value, Value>> table;
+        mutable SpinRwLock table_mtx;
+
+      public:
+        ObjMap();
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_MAP;
+        }
+
+        /**
+         * @param key the key
+         * @throws KeyError if the map does not contain @p key
+         * @return the value mapped to @p key
+         */
+        Value get(Value key) const;
+
+        /**
+         * @param key the key
+         * @param fallback the value returned when the map does not contain @p key
+         * @return the value mapped to @p key, @p fallback if there is none
+         */
+        Value get(Value key, Value fallback) const;
+
+        /**
+         * Maps @p key to @p value, replacing the previous value of @p key.
+         * If @p key is an array, it is frozen
+         * @param key the key
+         * @param value the value
+         */
+        void set(Value key, Value value);
+
+        bool contains(Value key) const;
+
+        /**
+         * Removes @p key and its value from the map
+         * @param key the key
+         * @return true if the map contained @p key
+         */
+        bool remove(Value key);
+
+        void clear();
+
+        /**
+         * Ensures that the map can hold @p count entries without growing
+         * @param count the number of entries
+         */
+        void reserve(size_t count);
+
+        void for_each(const std::function<void(Value, Value)> &func) const;
+
+        size_t count() const {
+            return table.count();
+        }
+
+        /**
+         * @return the number of bytes used to store the entries
+         */
+        size_t get_storage_size() const {
+            return table.get_storage_size();
+        }
+
+        bool truth() const {
+            return table.count() != 0;
+        }
+
+        string to_string() const;
+        Obj *copy() const;
+    };
+
+    /**
+     * Represents a set of values.
+     * The values are hashed and compared by ValueHash and ValueEqual like the keys of ObjMap,
+     * and they are frozen and locked like them as well.
+     */
+    class SWAN_EXPORT ObjSet final : public Obj {
+      private:
+        ValueTable<Value> table;
+        mutable SpinRwLock table_mtx;
+
+      public:
+        ObjSet();
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_SET;
+        }
+
+        /**
+         * Adds @p value to the set. If @p value is an array, it is frozen
+         * @param value the value
+         * @return true if the set did not contain @p value
+         */
+        bool add(Value value);
+
+        bool contains(Value value) const;
+
+        /**
+         * Removes @p value from the set
+         * @param value the value
+         * @return true if the set contained @p value
+         */
+        bool remove(Value value);
+
+        void clear();
+
+        /**
+         * Ensures that the set can hold @p count values without growing
+         * @param count the number of values
+         */
+        void reserve(size_t count);
+
+        void for_each(const std::function<void(Value)> &func) const;
+
+        size_t count() const {
+            return table.count();
+        }
+
+        /**
+         * @return the number of bytes used to store the values
+         */
+        size_t get_storage_size() const {
+            return table.get_storage_size();
+        }
+
+        bool truth() const {
+            return table.count() != 0;
+        }
+
+        string to_string() const;
+        Obj *copy() const;
     };
 
     class SWAN_EXPORT ObjModule final : public Obj {
@@ -434,6 +1205,8 @@ namespace spade
         fs::path path;
         /// The constant pool of the module
         vector<Value> constant_pool;
+        /// The interned member names of the constants used by the member opcodes, null for the other constants
+        vector<const ObjString *> member_names;
         /// The module init method
         ObjMethod *init = null;
 
@@ -442,15 +1215,19 @@ namespace spade
 
         ObjModule(const Sign &sign);
 
-        Obj *copy() const override {
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_MODULE;
+        }
+
+        Obj *copy() const {
             return (Obj *) this;
         }
 
-        bool truth() const override {
+        bool truth() const {
             return true;
         }
 
-        string to_string() const override;
+        string to_string() const;
 
         const Sign &get_sign() const {
             return sign;
@@ -476,6 +1253,14 @@ namespace spade
             constant_pool = conpool;
         }
 
+        const vector<const ObjString *> &get_member_names() const {
+            return member_names;
+        }
+
+        void set_member_names(const vector<const ObjString *> &names) {
+            member_names = names;
+        }
+
         ObjMethod *get_init() const {
             return init;
         }
@@ -512,15 +1297,19 @@ namespace spade
 
         Type(Sign sign) : Type(Kind::CLASS, sign, {}) {}
 
-        Obj *copy() const override {
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_TYPE;
+        }
+
+        Obj *copy() const {
             return (Obj *) this;
         }
 
-        bool truth() const override {
+        bool truth() const {
             return true;
         }
 
-        string to_string() const override;
+        string to_string() const;
 
         Kind get_kind() const {
             return kind;
@@ -554,20 +1343,25 @@ namespace spade
       public:
         ObjCapture(Value value);
 
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_CAPTURE;
+        }
+
         Value get() const {
             return value;
         }
 
         void set(Value value) {
+            publish_stored(value);
             this->value = value;
         }
 
-        Obj *copy() const override {
+        Obj *copy() const {
             return (Obj *) this;
         }
 
-        bool truth() const override;
-        string to_string() const override;
+        bool truth() const;
+        string to_string() const;
     };
 }    // namespace spade
 
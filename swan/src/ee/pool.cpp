@@ -0,0 +1,55 @@
+#include "pool.hpp"
+#include <thread>
+
+namespace spade
+{
+    std::future<void> ThreadPool::submit(std::function<void()> job) {
+        std::promise<void> done;
+        auto future = done.get_future();
+        std::lock_guard lk(mtx);
+        jobs.push_back(Job{std::move(job), std::move(done)});
+        if (idle > 0) {
+            // Promise the job to an idle thread, so that the next submit does not count on the same thread
+            idle--;
+            cv.notify_one();
+        } else {
+            count++;
+            std::thread(&ThreadPool::worker_main, this).detach();
+        }
+        return future;
+    }
+
+    size_t ThreadPool::size() {
+        std::lock_guard lk(mtx);
+        return count;
+    }
+
+    ThreadPool &ThreadPool::get() {
+        // Never destroyed, the detached threads may still use it while the process exits
+        static const auto pool = new ThreadPool();
+        return *pool;
+    }
+
+    void ThreadPool::worker_main() {
+        std::unique_lock lk(mtx);
+        while (true) {
+            cv.wait(lk, [this] { return !jobs.empty(); });
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            lk.unlock();
+            std::exception_ptr error;
+            try {
+                job.fun();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lk.lock();
+            idle++;
+            // Report the completion only after becoming idle, so that a submit following it reuses this thread
+            if (error)
+                job.done.set_exception(error);
+            else
+                job.done.set_value();
+        }
+    }
+}    // namespace spade
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "utils/common.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+
+namespace spade
+{
+    /**
+     * The process wide pool of the os threads running the vms.
+     * A vm is started on an idle pooled thread instead of a new one, so the threads are reused by
+     * the starts of all the vms of the process. A new thread is added only when no thread is idle.
+     * The pool lives until the process exits, since a vm can exit the process from one of its threads
+     */
+    class SWAN_EXPORT ThreadPool {
+        std::mutex mtx;
+        std::condition_variable cv;
+        struct Job {
+            std::function<void()> fun;
+            std::promise<void> done;
+        };
+
+        /// The jobs which have not been taken by a thread yet
+        std::deque<Job> jobs;
+        /// Number of threads waiting for a job which no job has been promised to
+        size_t idle = 0;
+        /// Number of threads in the pool
+        size_t count = 0;
+
+        ThreadPool() = default;
+
+      public:
+        ThreadPool(const ThreadPool &other) = delete;
+        ThreadPool(ThreadPool &&other) noexcept = delete;
+        ThreadPool &operator=(const ThreadPool &other) = delete;
+        ThreadPool &operator=(ThreadPool &&other) noexcept = delete;
+        ~ThreadPool() = default;
+
+        /**
+         * Runs @p job on an idle thread of the pool, or on a new thread if no thread is idle
+         * @param job the job
+         * @return the future which becomes ready when @p job returns and holds the exception thrown by it
+         */
+        std::future<void> submit(std::function<void()> job);
+
+        /**
+         * @return the number of threads in the pool
+         */
+        size_t size();
+
+        /**
+         * @return the thread pool of the process
+         */
+        static ThreadPool &get();
+
+      private:
+        void worker_main();
+    };
+}    // namespace spade
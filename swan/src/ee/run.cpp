@@ -1,4 +1,7 @@
 #include "ee/obj.hpp"
+#include "atomic.hpp"
+#include "callable/generator.hpp"
+#include "task.hpp"
 #include "spimp/error.hpp"
 #include "spimp/utils.hpp"
 #include "vm.hpp"
@@ -102,7 +105,7 @@ namespace spade
                     break;
                 case Opcode::MLOAD: {
                     const auto object = state.pop().as_obj();
-                    const auto name = Sign(state.load_const(state.read_short()).to_string()).get_name();
+                    const auto name = state.load_member_name(state.read_short());
                     const auto member = object->get_member(name);
                     state.push(member);
                     break;
@@ -110,13 +113,13 @@ namespace spade
                 case Opcode::MSTORE: {
                     const auto object = state.pop().as_obj();
                     const auto value = state.peek();
-                    const auto name = Sign(state.load_const(state.read_short()).to_string()).get_name();
+                    const auto name = state.load_member_name(state.read_short());
                     object->set_member(name, value);
                     break;
                 }
                 case Opcode::MFLOAD: {
                     const auto object = state.pop().as_obj();
-                    const auto name = Sign(state.load_const(state.read_byte()).to_string()).get_name();
+                    const auto name = state.load_member_name(state.read_byte());
                     const auto member = object->get_member(name);
                     state.push(member);
                     break;
@@ -124,21 +127,21 @@ namespace spade
                 case Opcode::MFSTORE: {
                     const auto object = state.pop().as_obj();
                     const auto value = state.peek();
-                    const auto name = Sign(state.load_const(state.read_byte()).to_string()).get_name();
+                    const auto name = state.load_member_name(state.read_byte());
                     object->set_member(name, value);
                     break;
                 }
                 case Opcode::PMSTORE: {
                     const auto object = state.pop().as_obj();
                     const auto value = state.pop();
-                    const auto name = Sign(state.load_const(state.read_short()).to_string()).get_name();
+                    const auto name = state.load_member_name(state.read_short());
                     object->set_member(name, value);
                     break;
                 }
                 case Opcode::PMFSTORE: {
                     const auto object = state.pop().as_obj();
                     const auto value = state.pop();
-                    const auto name = Sign(state.load_const(state.read_byte()).to_string()).get_name();
+                    const auto name = state.load_member_name(state.read_byte());
                     object->set_member(name, value);
                     break;
                 }
@@ -177,7 +180,12 @@ namespace spade
                 }
                 case Opcode::ILOAD: {
                     const auto index = state.pop();
-                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    const auto object = state.pop().as_obj();
+                    if (is<ObjMap>(object)) {
+                        state.push(cast<ObjMap>(object)->get(index));
+                        break;
+                    }
+                    const auto array = cast<ObjArray>(object);
                     if (index.is_uint())
                         state.push(array->get(index.as_uint()));
                     else if (index.is_int())
@@ -188,8 +196,13 @@ namespace spade
                 }
                 case Opcode::ISTORE: {
                     const auto index = state.pop();
-                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    const auto object = state.pop().as_obj();
                     const auto value = state.peek();
+                    if (is<ObjMap>(object)) {
+                        cast<ObjMap>(object)->set(index, value);
+                        break;
+                    }
+                    const auto array = cast<ObjArray>(object);
                     if (index.is_uint())
                         array->set(index.as_uint(), value);
                     else if (index.is_int())
@@ -200,8 +213,13 @@ namespace spade
                 }
                 case Opcode::PISTORE: {
                     const auto index = state.pop();
-                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    const auto object = state.pop().as_obj();
                     const auto value = state.pop();
+                    if (is<ObjMap>(object)) {
+                        cast<ObjMap>(object)->set(index, value);
+                        break;
+                    }
+                    const auto array = cast<ObjArray>(object);
                     if (index.is_uint())
                         array->set(index.as_uint(), value);
                     else if (index.is_int())
@@ -211,8 +229,29 @@ namespace spade
                     break;
                 }
                 case Opcode::ARRLEN: {
+                    const auto object = state.pop().as_obj();
+                    switch (object->get_tag()) {
+                    case OBJ_MAP:
+                        state.push(Value(cast<ObjMap>(object)->count()));
+                        break;
+                    case OBJ_SET:
+                        state.push(Value(cast<ObjSet>(object)->count()));
+                        break;
+                    default:
+                        state.push(Value(cast<ObjArray>(object)->count()));
+                        break;
+                    }
+                    break;
+                }
+                case Opcode::ARRPUSH: {
+                    const auto value = state.pop();
                     const auto array = cast<ObjArray>(state.pop().as_obj());
-                    state.push(Value(array->count()));
+                    array->push(value);
+                    break;
+                }
+                case Opcode::ARRPOP: {
+                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    state.push(array->pop());
                     break;
                 }
                 case Opcode::INVOKE: {
@@ -458,6 +497,12 @@ namespace spade
                     state.push(a->concat(b));
                     break;
                 }
+                case Opcode::CONCATN: {
+                    const uint8_t count = state.read_byte();
+                    frame->sc -= count;
+                    state.push(ObjString::concat(manager, frame->stack + frame->sc, count));
+                    break;
+                }
                 case Opcode::POW: {
                     const auto b = state.pop();
                     const auto a = state.pop();
@@ -604,18 +649,185 @@ namespace spade
                     break;
                 case Opcode::ENTERMONITOR:
                     state.pop().as_obj()->enter_monitor();
+                    state.monitor_entered();
                     break;
                 case Opcode::EXITMONITOR:
                     state.pop().as_obj()->exit_monitor();
+                    state.monitor_exited();
+                    break;
+                case Opcode::WAITMONITOR: {
+                    const auto timeout = state.pop();
+                    const auto object = state.pop().as_obj();
+                    // A null or negative timeout waits until notified
+                    std::optional<std::chrono::nanoseconds> duration;
+                    if (timeout.is_uint())
+                        duration = std::chrono::milliseconds(timeout.as_uint());
+                    else if (timeout.is_int() && timeout.as_int() >= 0)
+                        duration = std::chrono::milliseconds(timeout.as_int());
+                    else if (!timeout.is_null() && !timeout.is_int())
+                        throw ArgumentError("waitmonitor", std::format("timeout must be an integer or null, got '{}'", timeout.to_string()));
+                    state.push(Value(object->wait_monitor(duration)));
+                    break;
+                }
+                case Opcode::NOTIFYMONITOR:
+                    state.pop().as_obj()->notify_monitor();
+                    break;
+                case Opcode::NOTIFYALLMONITOR:
+                    state.pop().as_obj()->notify_all_monitor();
+                    break;
+                case Opcode::ATMLOAD: {
+                    const auto object = state.pop().as_obj();
+                    const auto name = state.load_member_name(state.read_short());
+                    atomics::on_member(state, AtomicOp::LOAD, object, name);
+                    break;
+                }
+                case Opcode::ATMSTORE: {
+                    const auto object = state.pop().as_obj();
+                    const auto name = state.load_member_name(state.read_short());
+                    atomics::on_member(state, AtomicOp::STORE, object, name);
+                    break;
+                }
+                case Opcode::ATMCAS: {
+                    const auto object = state.pop().as_obj();
+                    const auto name = state.load_member_name(state.read_short());
+                    atomics::on_member(state, AtomicOp::CAS, object, name);
+                    break;
+                }
+                case Opcode::ATMADD: {
+                    const auto object = state.pop().as_obj();
+                    const auto name = state.load_member_name(state.read_short());
+                    atomics::on_member(state, AtomicOp::ADD, object, name);
+                    break;
+                }
+                case Opcode::ATMSUB: {
+                    const auto object = state.pop().as_obj();
+                    const auto name = state.load_member_name(state.read_short());
+                    atomics::on_member(state, AtomicOp::SUB, object, name);
+                    break;
+                }
+                case Opcode::ATILOAD: {
+                    const auto index = state.pop();
+                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    atomics::on_element(state, AtomicOp::LOAD, array, index);
+                    break;
+                }
+                case Opcode::ATISTORE: {
+                    const auto index = state.pop();
+                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    atomics::on_element(state, AtomicOp::STORE, array, index);
+                    break;
+                }
+                case Opcode::ATICAS: {
+                    const auto index = state.pop();
+                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    atomics::on_element(state, AtomicOp::CAS, array, index);
+                    break;
+                }
+                case Opcode::ATIADD: {
+                    const auto index = state.pop();
+                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    atomics::on_element(state, AtomicOp::ADD, array, index);
                     break;
+                }
+                case Opcode::ATISUB: {
+                    const auto index = state.pop();
+                    const auto array = cast<ObjArray>(state.pop().as_obj());
+                    atomics::on_element(state, AtomicOp::SUB, array, index);
+                    break;
+                }
+                case Opcode::ATLLOAD:
+                    atomics::on_local(state, AtomicOp::LOAD, *frame, state.read_short());
+                    break;
+                case Opcode::ATLSTORE:
+                    atomics::on_local(state, AtomicOp::STORE, *frame, state.read_short());
+                    break;
+                case Opcode::ATLCAS:
+                    atomics::on_local(state, AtomicOp::CAS, *frame, state.read_short());
+                    break;
+                case Opcode::ATLADD:
+                    atomics::on_local(state, AtomicOp::ADD, *frame, state.read_short());
+                    break;
+                case Opcode::ATLSUB:
+                    atomics::on_local(state, AtomicOp::SUB, *frame, state.read_short());
+                    break;
+                case Opcode::GENERATOR: {
+                    // Allocate before detaching, so the frame stays reachable if the allocation collects
+                    const auto generator = halloc_mgr<ObjGenerator>(manager);
+                    // The generator continues right after this instruction when it is first resumed
+                    generator->suspend(state);
+                    // Return if encountered end of execution
+                    if (state.get_call_stack_size() == 0)
+                        return generator;
+                    state.push(generator);
+                    break;
+                }
+                case Opcode::YIELD: {
+                    const auto value = state.pop();
+                    const auto generator = frame->get_generator();
+                    if (!generator)
+                        throw IllegalGeneratorStateError("cannot yield outside a generator");
+                    generator->suspend(state);
+                    // The resumer continues after its resume instruction with the yielded value
+                    state.push(value);
+                    break;
+                }
+                case Opcode::RESUME: {
+                    const int16_t offset = static_cast<int16_t>(state.read_short());
+                    const auto value = state.pop();
+                    if (!value.is_obj() || !is<ObjGenerator>(value.as_obj()))
+                        throw IllegalGeneratorStateError(std::format("cannot resume {}", value.to_string()));
+                    const auto generator = cast<ObjGenerator>(value.as_obj());
+                    if (generator->is_finished())
+                        state.adjust(offset);
+                    else
+                        generator->resume(state, frame->pc + offset);
+                    break;
+                }
+                case Opcode::SPAWN: {
+                    // Get the count
+                    const uint8_t count = state.read_byte();
+                    // Pop the arguments
+                    frame->sc -= count;
+                    // Get the method
+                    const auto method_value = state.pop();
+                    if (!method_value.is_obj() || !is<ObjMethod>(method_value.as_obj()))
+                        throw IllegalAccessError(std::format("cannot spawn {}", method_value.to_string()));
+                    const vector<Value> args(&frame->stack[frame->sc + 1], &frame->stack[frame->sc + 1 + count]);
+                    state.push(get_scheduler()->spawn(cast<ObjMethod>(method_value.as_obj()), args));
+                    break;
+                }
+                case Opcode::JOIN: {
+                    const auto value = state.peek();
+                    if (!value.is_obj() || !is<ObjTask>(value.as_obj()))
+                        throw IllegalAccessError(std::format("cannot join {}", value.to_string()));
+                    const auto task = cast<ObjTask>(value.as_obj());
+                    if (!task->is_finished()) {
+                        // A task is suspended until the joined task finishes and runs this instruction again,
+                        // other threads and the tasks holding a monitor block instead
+                        if (const auto current = thread->get_task(); current && !state.holds_monitor()) {
+                            current->await(task);
+                            frame->pc--;
+                            state.end_slice();
+                            break;
+                        }
+                        // A worker runs other tasks while it waits, unless they could enter the monitors held by this thread
+                        if (state.holds_monitor())
+                            task->wait();
+                        else
+                            get_scheduler()->wait(task);
+                    }
+                    state.pop();
+                    state.push(task->get_result());
+                    break;
+                }
                 case Opcode::MTPERF: {
-                    const auto match = frame->get_method()->get_matches()[state.read_short()];
+                    const auto &match = frame->get_method()->get_matches()[state.read_short()];
                     const uint32_t offset = match.perform(state.pop());
                     state.set_pc(offset);
                     break;
                 }
                 case Opcode::MTFPERF: {
-                    const auto match = frame->get_method()->get_matches()[state.read_byte()];
+                    const auto &match = frame->get_method()->get_matches()[state.read_byte()];
                     const uint32_t offset = match.perform(state.pop());
                     state.set_pc(offset);
                     break;
@@ -649,6 +861,12 @@ namespace spade
                     const auto current_frame = state.get_frame();
                     // Pop the return value
                     const auto val = state.pop();
+                    // A generator discards its return value and its resumer takes the exit branch
+                    if (const auto generator = current_frame->get_generator()) {
+                        state.pop_frame();
+                        state.set_pc(generator->finish());
+                        break;
+                    }
                     // Pop the current frame
                     state.pop_frame();
                     // Return if encountered end of execution
@@ -660,6 +878,12 @@ namespace spade
                 }
                 case Opcode::VRET: {
                     const auto current_frame = state.get_frame();
+                    // The resumer of a generator takes the exit branch
+                    if (const auto generator = current_frame->get_generator()) {
+                        state.pop_frame();
+                        state.set_pc(generator->finish());
+                        break;
+                    }
                     // Pop the current frame
                     state.pop_frame();
                     // Return if encountered end of execution
@@ -703,21 +927,27 @@ namespace spade
                 while (state.get_call_stack_size() > 0) {
                     frame = state.get_frame();
                     const auto info = frame->get_method()->get_exceptions().get_target(state.get_pc(), value.as_obj()->get_type());
-                    if (Exception::IS_NO_EXCEPTION(info))
+                    if (Exception::IS_NO_EXCEPTION(info)) {
+                        // A generator which does not handle the exception cannot be resumed anymore
+                        if (const auto generator = frame->get_generator())
+                            generator->finish();
                         state.pop_frame();
-                    else {
+                    } else {
                         state.set_pc(info.get_target());
                         state.push(value);
                         break;
                     }
                 }
-                if (state.get_call_stack_size() == 0) {
-                    // TODO: show stack trace
-                }
+                // The value is thrown out of the execution loop if no frame handles it
+                if (state.get_call_stack_size() == 0)
+                    throw;
             } catch (const FatalError &error) {
                 std::cerr << "fatal error: " << error.what() << std::endl;
                 std::exit(1);
             }
+            // Return to the scheduler when the time slice of the running task is used up
+            if (state.is_slice_over())
+                return Value();
         }
 
 #if 1
@@ -0,0 +1,194 @@
+#include "scheduler.hpp"
+#include "vm.hpp"
+#include "callable/method.hpp"
+#include "memory/memory.hpp"
+#include "utils/errors.hpp"
+#include <spdlog/spdlog.h>
+
+namespace spade
+{
+    /// The scheduler owning the current worker thread, null if the current thread is not a worker
+    static thread_local const Scheduler *current_scheduler = null;
+    /// The index of the current worker thread
+    static thread_local size_t current_index = 0;
+
+    Scheduler::Scheduler(SpadeVM *vm, size_t worker_count) : vm(vm) {
+        if (worker_count == 0)
+            worker_count = std::max(std::thread::hardware_concurrency(), 1u);
+        // The queues must exist before any worker starts stealing from them
+        for (size_t i = 0; i < worker_count; i++) workers.push_back(std::make_unique<Worker>());
+        for (size_t i = 0; i < worker_count; i++)
+            workers[i]->thread = std::make_unique<Thread>(vm, [this, i](Thread *thread) { worker_main(i, thread); });
+        spdlog::info("Scheduler: Started {} worker(s)", worker_count);
+    }
+
+    Scheduler::~Scheduler() {
+        {
+            std::lock_guard idle_lk(idle_mtx);
+            stopping = true;
+        }
+        idle_cv.notify_all();
+        for (const auto &worker: workers) worker->thread->join();
+        spdlog::info("Scheduler: Stopped");
+    }
+
+    ObjTask *Scheduler::spawn(ObjMethod *method, vector<Value> args) {
+        if (args.size() != method->get_args_count())
+            throw ArgumentError(method->get_sign().to_string(),
+                                std::format("expected {} arguments got {}", method->get_args_count(), args.size()));
+        const auto task = halloc_mgr<ObjTask>(vm->get_memory_manager(), method, std::move(args), vm->get_settings().max_call_stack_depth);
+        schedule(task);
+        return task;
+    }
+
+    ObjTask *Scheduler::spawn(ObjTask::Body body, vector<Value> args) {
+        const auto task =
+                halloc_mgr<ObjTask>(vm->get_memory_manager(), std::move(body), std::move(args), vm->get_settings().max_call_stack_depth);
+        schedule(task);
+        return task;
+    }
+
+    ObjTask *Scheduler::make_pending() {
+        const auto task = halloc_mgr<ObjTask>(vm->get_memory_manager());
+        std::lock_guard tasks_lk(tasks_mtx);
+        tasks.insert(task);
+        return task;
+    }
+
+    void Scheduler::wait(ObjTask *task) {
+        // Only the workers of this scheduler can run its tasks
+        if (current_scheduler != this) {
+            task->wait();
+            return;
+        }
+        const auto thread = Thread::current();
+        while (!task->is_finished()) {
+            if (const auto other = take(current_index))
+                run_task(thread, other);
+            else
+                task->wait_for(WAIT_POLL);
+        }
+    }
+
+    void Scheduler::complete(ObjTask *task, Value value, bool thrown) {
+        for (const auto joiner: task->finish(value, thrown)) submit(joiner);
+        std::lock_guard tasks_lk(tasks_mtx);
+        tasks.erase(task);
+    }
+
+    void Scheduler::for_each_root(const std::function<void(Obj *)> &func) const {
+        {
+            std::lock_guard tasks_lk(tasks_mtx);
+            for (const auto task: tasks) func(task);
+        }
+        // The states of the running tasks are swapped into the workers
+        for (const auto &worker: workers) worker->thread->get_state().for_each_reference(func);
+    }
+
+    void Scheduler::schedule(ObjTask *task) {
+        // The task runs on a worker thread, so its method and arguments become reachable from that thread
+        task->publish();
+        {
+            std::lock_guard tasks_lk(tasks_mtx);
+            tasks.insert(task);
+        }
+        submit(task);
+    }
+
+    void Scheduler::submit(ObjTask *task, bool preempted) {
+        task->set_status(ObjTask::Status::READY);
+        // Tasks submitted by a worker stay on that worker to keep their data warm
+        const auto index = current_scheduler == this ? current_index : next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        auto &worker = *workers[index];
+        {
+            std::lock_guard worker_lk(worker.mtx);
+            if (preempted)
+                worker.queue.push_front(task);
+            else
+                worker.queue.push_back(task);
+            queued.fetch_add(1, std::memory_order_release);
+        }
+        // Lock the idle mutex so that the notification is not lost between the check and the wait of an idle worker
+        { std::lock_guard idle_lk(idle_mtx); }
+        idle_cv.notify_one();
+    }
+
+    ObjTask *Scheduler::take(size_t index) {
+        for (size_t i = 0; i < workers.size(); i++) {
+            auto &worker = *workers[(index + i) % workers.size()];
+            std::lock_guard worker_lk(worker.mtx);
+            if (worker.queue.empty())
+                continue;
+            ObjTask *task;
+            // The owner takes the newest task, the thieves take the oldest one
+            if (i == 0) {
+                task = worker.queue.back();
+                worker.queue.pop_back();
+            } else {
+                task = worker.queue.front();
+                worker.queue.pop_front();
+            }
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+        return null;
+    }
+
+    void Scheduler::worker_main(size_t index, Thread *thread) {
+        current_scheduler = this;
+        current_index = index;
+        thread->set_status(Thread::RUNNING);
+        while (true) {
+            if (const auto task = take(index)) {
+                run_task(thread, task);
+                continue;
+            }
+            std::unique_lock idle_lk(idle_mtx);
+            idle_cv.wait(idle_lk, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+            if (stopping)
+                break;
+        }
+        thread->set_status(Thread::TERMINATED);
+    }
+
+    void Scheduler::run_task(Thread *thread, ObjTask *task) {
+        // A task run by wait is nested in the task which waits
+        const auto outer = thread->get_task();
+        task->set_status(ObjTask::Status::RUNNING);
+        // A body cannot be suspended, so the thread does not run the task as far as the joins of its calls are concerned
+        if (!task->has_body())
+            thread->set_task(task);
+        std::swap(thread->get_state(), task->get_state());
+
+        auto &state = thread->get_state();
+        Value result;
+        bool thrown = false;
+        try {
+            if (task->has_body())
+                result = task->run_body(thread);
+            else {
+                task->start();
+                state.start_slice(TIME_SLICE);
+                result = vm->run(thread);
+            }
+        } catch (const ThrowSignal &signal) {
+            result = signal.get_value();
+            thrown = true;
+        }
+        const bool finished = thrown || task->has_body() || state.get_call_stack_size() == 0;
+        state.start_slice(-1);
+
+        std::swap(thread->get_state(), task->get_state());
+        thread->set_task(outer);
+
+        if (finished)
+            complete(task, result, thrown);
+        else if (const auto awaited = task->take_awaited()) {
+            // The task is registered only now, since it must not be resumed before its state is swapped back
+            task->set_status(ObjTask::Status::BLOCKED);
+            if (!awaited->add_joiner(task))
+                submit(task);
+        } else
+            submit(task, true);
+    }
+}    // namespace spade
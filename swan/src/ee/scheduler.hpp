@@ -0,0 +1,150 @@
+#pragma once
+
+#include "task.hpp"
+#include "thread.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace spade
+{
+    class SpadeVM;
+
+    /**
+     * Runs the tasks of a vm on a fixed pool of worker threads.
+     * Each worker has its own run queue. A worker takes the newest task from its own queue and,
+     * when its queue is empty, steals the oldest task from the queues of the other workers.
+     * A running task is suspended when its time slice is used up at a preemption point,
+     * which are the calls and the backward branches, or when it waits for another task.
+     */
+    class SWAN_EXPORT Scheduler {
+        /// Number of preemption points in the time slice of a task
+        static constexpr const int32_t TIME_SLICE = 1024;
+        /// How long a worker waiting in wait sleeps before it looks for tasks to run again
+        static constexpr const std::chrono::milliseconds WAIT_POLL{1};
+
+        struct Worker {
+            std::mutex mtx;
+            /// The run queue, the newest task is at the back
+            std::deque<ObjTask *> queue;
+            std::unique_ptr<Thread> thread;
+        };
+
+        SpadeVM *vm;
+        vector<std::unique_ptr<Worker>> workers;
+        /// The worker which receives the next task submitted from outside the workers
+        std::atomic<size_t> next_worker = 0;
+        /// Number of tasks in the run queues
+        std::atomic<size_t> queued = 0;
+        std::atomic<bool> stopping = false;
+        std::mutex idle_mtx;
+        std::condition_variable idle_cv;
+        /// The tasks which have not finished
+        std::unordered_set<ObjTask *> tasks;
+        mutable std::mutex tasks_mtx;
+
+      public:
+        /**
+         * Creates the scheduler and starts its worker threads
+         * @param vm the vm
+         * @param worker_count the number of worker threads, the hardware concurrency if it is zero
+         */
+        Scheduler(SpadeVM *vm, size_t worker_count);
+
+        Scheduler(const Scheduler &) = delete;
+        Scheduler(Scheduler &&) = delete;
+        Scheduler &operator=(const Scheduler &) = delete;
+        Scheduler &operator=(Scheduler &&) = delete;
+
+        /**
+         * Stops the worker threads. The tasks which have not finished are abandoned
+         */
+        ~Scheduler();
+
+        /**
+         * Creates a task which calls @p method with @p args and schedules it
+         * @throws ArgumentError if the number of @p args does not match @p method
+         * @param method the method
+         * @param args the arguments
+         * @return the task
+         */
+        ObjTask *spawn(ObjMethod *method, vector<Value> args);
+
+        /**
+         * Creates a task which runs @p body and schedules it.
+         * The body cannot be suspended, so it runs until it returns. The joins performed by its calls
+         * wait in wait, which keeps the worker running the other tasks meanwhile
+         * @param body the native code
+         * @param args the arguments of @p body
+         * @return the task
+         */
+        ObjTask *spawn(ObjTask::Body body, vector<Value> args);
+
+        /**
+         * Creates a task which is not run by the scheduler, it waits until it is finished by complete.
+         * The tasks joining it are suspended in the meantime without blocking the worker threads
+         * @return the task
+         */
+        ObjTask *make_pending();
+
+        /**
+         * Blocks the current thread until @p task finishes. A worker thread runs the queued tasks meanwhile
+         * instead of blocking, so that a task which cannot be suspended does not hold its worker back from
+         * the tasks it waits for, such as the chunks of a parallel native called from a chunk
+         * @param task the task
+         */
+        void wait(ObjTask *task);
+
+        /**
+         * Finishes @p task and reschedules the tasks joining it
+         * @param task the task
+         * @param value the return value or the thrown value
+         * @param thrown true if @p value was thrown
+         */
+        void complete(ObjTask *task, Value value, bool thrown = false);
+
+        /**
+         * @return the number of worker threads
+         */
+        size_t get_worker_count() const {
+            return workers.size();
+        }
+
+        /**
+         * Calls @p func for the unfinished tasks and the objects referred to by the worker threads
+         * @param func the function to be called
+         */
+        void for_each_root(const std::function<void(Obj *)> &func) const;
+
+      private:
+        /**
+         * Registers @p task as unfinished and schedules it
+         */
+        void schedule(ObjTask *task);
+
+        /**
+         * Puts @p task in a run queue
+         * @param task the task
+         * @param preempted true if the task is suspended at a preemption point, so it runs after the other tasks of the queue
+         */
+        void submit(ObjTask *task, bool preempted = false);
+
+        /**
+         * @param index the index of the worker
+         * @return a task from the queue of the worker or a task stolen from another worker, null if all queues are empty
+         */
+        ObjTask *take(size_t index);
+
+        void worker_main(size_t index, Thread *thread);
+
+        /**
+         * Runs @p task on @p thread until it finishes or is suspended
+         * @param thread the worker thread
+         * @param task the task
+         */
+        void run_task(Thread *thread, ObjTask *task);
+    };
+}    // namespace spade
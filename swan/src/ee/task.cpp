@@ -0,0 +1,80 @@
+#include "task.hpp"
+#include "callable/method.hpp"
+#include "utils/errors.hpp"
+
+namespace spade
+{
+    ObjTask::ObjTask(ObjMethod *method, vector<Value> args, size_t max_call_stack_depth)
+        : Obj(OBJ_TASK), state(max_call_stack_depth), method(method), args(std::move(args)) {}
+
+    ObjTask::ObjTask(Body body, vector<Value> args, size_t max_call_stack_depth)
+        : Obj(OBJ_TASK), state(max_call_stack_depth), method(null), body(std::move(body)), args(std::move(args)) {}
+
+    ObjTask::ObjTask() : Obj(OBJ_TASK), state(0), method(null), status(Status::BLOCKED) {}
+
+    void ObjTask::start() {
+        if (started || !method)
+            return;
+        started = true;
+        method->call(null, std::move(args));
+        args.clear();
+    }
+
+    vector<ObjTask *> ObjTask::finish(Value value, bool thrown) {
+        // The result is read by the threads joining this task
+        publish(value);
+        vector<ObjTask *> waiting;
+        {
+            std::lock_guard lk(mtx);
+            result = value;
+            failed = thrown;
+            set_status(Status::FINISHED);
+            waiting.swap(joiners);
+        }
+        cv.notify_all();
+        return waiting;
+    }
+
+    bool ObjTask::add_joiner(ObjTask *task) {
+        std::lock_guard lk(mtx);
+        if (is_finished())
+            return false;
+        joiners.push_back(task);
+        return true;
+    }
+
+    void ObjTask::wait() const {
+        std::unique_lock lk(mtx);
+        cv.wait(lk, [this] { return is_finished(); });
+    }
+
+    bool ObjTask::wait_for(std::chrono::milliseconds timeout) const {
+        std::unique_lock lk(mtx);
+        return cv.wait_for(lk, timeout, [this] { return is_finished(); });
+    }
+
+    Value ObjTask::get_result() const {
+        std::lock_guard lk(mtx);
+        if (failed)
+            throw ThrowSignal(result);
+        return result;
+    }
+
+    void ObjTask::for_each_task_reference(const std::function<void(Obj *)> &func) const {
+        if (method)
+            func(method);
+        for (const auto arg: args)
+            if (arg.is_obj())
+                func(arg.as_obj());
+        if (result.is_obj())
+            func(result.as_obj());
+        if (awaited)
+            func(awaited);
+        state.for_each_reference(func);
+    }
+
+    string ObjTask::to_string() const {
+        static constexpr const char *status_names[] = {"ready", "running", "blocked", "finished"};
+        return std::format("<task {}>", status_names[static_cast<int>(get_status())]);
+    }
+}    // namespace spade
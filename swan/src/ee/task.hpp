@@ -0,0 +1,184 @@
+#pragma once
+
+#include "obj.hpp"
+#include "thread.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace spade
+{
+    class ObjMethod;
+
+    /**
+     * Represents a task, which is a lightweight thread of execution scheduled by the Scheduler.
+     * A task owns its ThreadState, which is swapped into a worker thread while the task runs,
+     * so tasks can be suspended at preemption points and continue on any worker thread.
+     * A task can also run native code instead of a method, such a task runs to completion once it is started.
+     */
+    class SWAN_EXPORT ObjTask final : public Obj {
+      public:
+        /// The native code run by a task, which receives the worker thread and the arguments of the task
+        using Body = std::function<Value(Thread *, const vector<Value> &)>;
+
+        enum class Status {
+            /// The task is in a run queue
+            READY,
+            /// The task is running on a worker thread
+            RUNNING,
+            /// The task is waiting for another task or an operation to finish
+            BLOCKED,
+            /// The task has returned or thrown
+            FINISHED,
+        };
+
+      private:
+        /// The state of the task, which is empty while the task is running
+        ThreadState state;
+        /// The method run by the task, null if the task runs a body or is finished from outside the scheduler
+        ObjMethod *method;
+        /// The native code run by the task, empty if the task runs a method
+        Body body;
+        /// The arguments of the method, which are cleared once the task is started, or the arguments of the body
+        vector<Value> args;
+        bool started = false;
+        std::atomic<Status> status = Status::READY;
+        /// The return value of the method, or the thrown value if the task has failed
+        Value result;
+        bool failed = false;
+        /// The task which this task waits for before it is suspended
+        ObjTask *awaited = null;
+        /// The tasks waiting for this task to finish
+        vector<ObjTask *> joiners;
+        mutable std::mutex mtx;
+        mutable std::condition_variable cv;
+
+      public:
+        ObjTask(ObjMethod *method, vector<Value> args, size_t max_call_stack_depth);
+
+        /**
+         * Creates a task which runs native code
+         * @param body the native code
+         * @param args the arguments of @p body, which are kept alive until the task is collected
+         * @param max_call_stack_depth the maximum call stack depth of the methods called by @p body
+         */
+        ObjTask(Body body, vector<Value> args, size_t max_call_stack_depth);
+
+        /**
+         * Creates a task which does not run any code, it is finished from outside the scheduler
+         * such as when an I/O operation completes
+         */
+        ObjTask();
+
+        static bool classof(const Obj *obj) {
+            return obj->get_tag() == OBJ_TASK;
+        }
+
+        ThreadState &get_state() {
+            return state;
+        }
+
+        const ThreadState &get_state() const {
+            return state;
+        }
+
+        Status get_status() const {
+            return status.load(std::memory_order_acquire);
+        }
+
+        void set_status(Status status) {
+            this->status.store(status, std::memory_order_release);
+        }
+
+        bool is_finished() const {
+            return get_status() == Status::FINISHED;
+        }
+
+        /**
+         * @return true if the task runs native code instead of a method
+         */
+        bool has_body() const {
+            return static_cast<bool>(body);
+        }
+
+        /**
+         * Calls the method of the task on the current thread if the task has not started yet
+         */
+        void start();
+
+        /**
+         * Runs the body of the task to completion on @p thread
+         * @param thread the worker thread, into which the state of the task is swapped
+         * @return the value returned by the body
+         */
+        Value run_body(Thread *thread) {
+            return body(thread, args);
+        }
+
+        /**
+         * Marks this task as finished and wakes up the threads waiting for it
+         * @param value the return value or the thrown value
+         * @param thrown true if @p value was thrown
+         * @return the tasks waiting for this task, which must be rescheduled
+         */
+        vector<ObjTask *> finish(Value value, bool thrown);
+
+        /**
+         * Registers @p task to be rescheduled when this task finishes
+         * @param task the waiting task
+         * @return false if this task has already finished, in which case @p task is not registered
+         */
+        bool add_joiner(ObjTask *task);
+
+        /**
+         * Blocks the current thread until this task finishes
+         */
+        void wait() const;
+
+        /**
+         * Blocks the current thread until this task finishes or @p timeout passes
+         * @param timeout the timeout
+         * @return true if the task has finished
+         */
+        bool wait_for(std::chrono::milliseconds timeout) const;
+
+        /**
+         * @throws ThrowSignal if the task has thrown a value
+         * @return the return value of the finished task
+         */
+        Value get_result() const;
+
+        /**
+         * Makes this task wait for @p task once it is suspended
+         * @param task the task to wait for
+         */
+        void await(ObjTask *task) {
+            awaited = task;
+        }
+
+        /**
+         * @return the task which this task waits for, null if there is none. The awaited task is cleared
+         */
+        ObjTask *take_awaited() {
+            return std::exchange(awaited, null);
+        }
+
+        /**
+         * Calls @p func for every object referred to by this task
+         * @param func the function to be called
+         */
+        void for_each_task_reference(const std::function<void(Obj *)> &func) const;
+
+        Obj *copy() const {
+            return (Obj *) this;
+        }
+
+        bool truth() const {
+            return true;
+        }
+
+        string to_string() const;
+    };
+}    // namespace spade
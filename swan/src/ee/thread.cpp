@@ -6,13 +6,15 @@
 #include <condition_variable>
 #include <cstring>
 #include <mutex>
-#include <shared_mutex>
 #include <spdlog/spdlog.h>
 #include <sstream>
 #include <thread>
 
 namespace spade
 {
+    /// The execution context of the calling os thread
+    static thread_local ExecutionContext context;
+
     ThreadState::ThreadState(size_t max_call_stack_depth)
         // : stack_depth(max_call_stack_depth), call_stack(std::make_unique<Frame[]>(stack_depth)), fc(0) {
         : stack_depth(max_call_stack_depth), call_stack() {}
@@ -25,6 +27,8 @@ namespace spade
         if (call_stack.size() >= stack_depth)
             throw StackOverflowError();
         call_stack.push_back(std::move(frame));
+        // Calls are preemption points
+        tick();
     }
 
     bool ThreadState::pop_frame() {
@@ -52,14 +56,7 @@ namespace spade
 
         // Create the thread
         thread = std::thread([&, fun] {
-            {
-                // Put the thread in the table
-                // INFO: Another thread calling Thread::current() which may fail
-                // because the below statement may change and invalidate `threads` during rehashing.
-                // So, a shared_mutex with an exclusive lock is used to prevent that situation
-                std::unique_lock threads_lk(threads_mtx);
-                threads.emplace(std::this_thread::get_id(), this);
-            }
+            install();
             pre_fun();
             {
                 // Acquire a lock on the start mutex
@@ -71,6 +68,7 @@ namespace spade
             cv_start.notify_all();
             // Now we got clearance, we can start now
             fun(this);
+            context = {};
         });
 
         // Acquire a lock on the start mutex
@@ -82,15 +80,25 @@ namespace spade
         // And destroy everything in the ctor
     }
 
+    Thread::Thread(SpadeVM *vm) : thread(), outer(context), vm(vm), state(vm->get_settings().max_call_stack_depth) {
+        install();
+    }
+
     Thread::~Thread() {
-        std::unique_lock threads_lk(threads_mtx);
-        threads.erase(thread.get_id());
+        // An attached thread is destroyed on its own os thread, which gets back the context it had before
+        if (context.thread == this)
+            context = outer;
     }
 
     Thread *Thread::current() {
-        std::shared_lock threads_lk(threads_mtx);
-        if (const auto it = threads.find(std::this_thread::get_id()); it != threads.end())
-            return it->second;
-        return null;
+        return context.thread;
+    }
+
+    const ExecutionContext &Thread::get_context() {
+        return context;
+    }
+
+    void Thread::install() {
+        context = ExecutionContext{this, vm, vm->get_memory_manager()};
     }
 }    // namespace spade
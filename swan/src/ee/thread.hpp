@@ -8,12 +8,30 @@
 namespace spade
 {
     class SpadeVM;
+    class ObjTask;
+    class MemoryManager;
+    class Thread;
+
+    /**
+     * The vm thread running on an os thread, together with its vm and memory manager.
+     * Every os thread has its own context, which is installed when a vm thread starts running on it,
+     * so the current thread, vm and memory manager are found without any lookup or locking
+     */
+    struct SWAN_EXPORT ExecutionContext {
+        Thread *thread = null;
+        SpadeVM *vm = null;
+        MemoryManager *manager = null;
+    };
 
     class SWAN_EXPORT ThreadState {
         /// Maximum call stack depth
         ptrdiff_t stack_depth;
         /// Call stack
         std::vector<Frame> call_stack;
+        /// Number of preemption points left in the time slice, negative if the state is not preemptible
+        int32_t slice = -1;
+        /// Number of monitors entered and not yet exited, the state is not preempted while it holds a monitor
+        uint32_t monitors = 0;
         /// Frame pointer to the next frame of the current active frame
         // size_t fc = 0;
 
@@ -75,6 +93,18 @@ namespace spade
             return get_frame()->get_const_pool()[index].copy();
         }
 
+        /**
+         * Loads the interned member name of the constant at index, which the loader
+         * interns for every constant used by a member opcode
+         * @param index
+         * @return the interned member name
+         */
+        const ObjString *load_member_name(uint16_t index) const {
+            const auto name = get_frame()->get_member_names()[index];
+            assert(name != null && "constant is not a member name");
+            return name;
+        }
+
         // Code operations
         /**
          * Advances ip by 1 byte and returns the byte read
@@ -111,6 +141,63 @@ namespace spade
          */
         void adjust(ptrdiff_t offset) {
             get_frame()->pc += offset;
+            // Backward branches are preemption points
+            if (offset < 0)
+                tick();
+        }
+
+        // Preemption operations
+        /**
+         * Starts a time slice of @p points preemption points
+         * @param points the number of preemption points, negative if the state is not preemptible
+         */
+        void start_slice(int32_t points) {
+            slice = points;
+        }
+
+        /**
+         * Ends the time slice, so that the execution loop returns before the next instruction
+         */
+        void end_slice() {
+            slice = 0;
+        }
+
+        /**
+         * @return true if the time slice is used up and the state can be suspended
+         */
+        bool is_slice_over() const {
+            return slice == 0 && monitors == 0;
+        }
+
+        /**
+         * @return true if the state holds a monitor, in which case it must not move to another thread
+         */
+        bool holds_monitor() const {
+            return monitors != 0;
+        }
+
+        void monitor_entered() {
+            monitors++;
+        }
+
+        void monitor_exited() {
+            monitors--;
+        }
+
+        /**
+         * Passes a preemption point, which are the calls and the backward branches
+         */
+        void tick() {
+            if (slice > 0)
+                slice--;
+        }
+
+        /**
+         * Calls @p func for every object referred to by the call stack
+         * @param func the function to be called
+         */
+        void for_each_reference(const std::function<void(Obj *)> &func) const {
+            for (const auto &frame: call_stack) frame.for_each_reference(func);
         }
 
         /**
@@ -173,9 +260,6 @@ namespace spade
      * Representation of a vm thread
      */
     class SWAN_EXPORT Thread {
-        inline static std::shared_mutex threads_mtx;
-        inline static std::unordered_map<std::thread::id, Thread *> threads;
-
       public:
         enum Status {
             /// The thread has not started yet
@@ -187,8 +271,10 @@ namespace spade
         };
 
       private:
-        /// Underlying thread object
+        /// Underlying thread object, which is not joinable if the thread is attached to an existing os thread
         std::thread thread;
+        /// The context of the os thread before this thread was attached to it
+        ExecutionContext outer;
         // TODO: Fix program representation
         /// Program representation
         Obj *value = null;
@@ -200,11 +286,13 @@ namespace spade
         Status status = NOT_STARTED;
         /// Exit code of the thread
         int exit_code = 0;
+        /// The task whose state is swapped into this thread, null if the thread is not running a task
+        ObjTask *task = null;
 
       public:
         /**
          * Constructs a new Thread object and blocks until the thread is started.
-         * This is because the global threads table should be updated before @p fun is called.
+         * This is because the execution context of the thread should be installed before @p fun is called.
          * @p pre_fun is also called before @p fun is called.
          * This is necessary to ensure that @p fun is able to function normally and does not get
          * involved in a data race
@@ -213,6 +301,14 @@ namespace spade
          * @param pre_fun The function to execute before @p fun is called
          */
         Thread(SpadeVM *vm, const std::function<void(Thread *)> &fun, const std::function<void()> &pre_fun = [] {});
+
+        /**
+         * Constructs a new Thread object attached to the calling os thread, which runs it until the object is destroyed.
+         * This lets a pooled os thread run the vms one after another
+         * @param vm The vm of the thread
+         */
+        explicit Thread(SpadeVM *vm);
+
         ~Thread();
 
         /**
@@ -280,6 +376,21 @@ namespace spade
             exit_code = code;
         }
 
+        /**
+         * @return The task running on this thread, null if the thread is not running a task
+         */
+        ObjTask *get_task() const {
+            return task;
+        }
+
+        /**
+         * Sets the task running on this thread
+         * @param task_ the task
+         */
+        void set_task(ObjTask *task_) {
+            task = task_;
+        }
+
         /**
          * @return true if the thread is running, false otherwise
          */
@@ -289,15 +400,28 @@ namespace spade
 
         /**
          * Blocks the caller thread until this thread completes.
-         * Upon the completion of this thread the function returns to the caller thread
+         * Upon the completion of this thread the function returns to the caller thread.
+         * An attached thread cannot be joined, so the function returns immediately
          */
         void join() {
-            thread.join();
+            if (thread.joinable())
+                thread.join();
         }
 
         /**
          * @return the current thread
          */
         static Thread *current();
+
+        /**
+         * @return the execution context of the calling os thread, whose members are null if it is not running a vm thread
+         */
+        static const ExecutionContext &get_context();
+
+      private:
+        /**
+         * Installs the execution context of this thread on the calling os thread
+         */
+        void install();
     };
 }    // namespace spade
@@ -1,52 +1,81 @@
 #include "value.hpp"
 #include "ee/obj.hpp"
 #include "spimp/error.hpp"
+#include "utils/errors.hpp"
 #include <bit>
 #include <cmath>
 #include <string>
 
 namespace spade
 {
+#ifdef SWAN_NAN_BOXING
+    /**
+     * Checks the product of two 48 bit operands in floating point, since it may not even fit in 64 bits
+     * @throws IntegerOverflowError if the product cannot be computed exactly
+     */
+    template<typename T>
+    static void check_product(T lhs, T rhs) {
+        if (std::abs(static_cast<double>(lhs) * static_cast<double>(rhs)) >= 0x1p62)
+            throw IntegerOverflowError(std::format("integer overflow: {} * {} does not fit in 48 bits", lhs, rhs));
+    }
+#endif
+
+    Value Value::checked_int(int64_t i) {
+#ifdef SWAN_NAN_BOXING
+        if (i < INT_MIN_VALUE || i > INT_MAX_VALUE)
+            throw IntegerOverflowError(std::format("integer overflow: {} does not fit in 48 bits", i));
+#endif
+        return Value(i);
+    }
+
+    Value Value::checked_uint(uint64_t u) {
+#ifdef SWAN_NAN_BOXING
+        if (u > UINT_MAX_VALUE)
+            throw IntegerOverflowError(std::format("integer overflow: {} does not fit in 48 bits", u));
+#endif
+        return Value(u);
+    }
+
     Ordering Value::compare(const Value &other) const {
-        if (tag != other.tag)
+        if (get_tag() != other.get_tag())
             return Ordering::UNDEFINED;
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_NULL:
             return Ordering::EQUAL;
         case VALUE_BOOL:
-            if (as.b == other.as.b)
+            if (as_bool() == other.as_bool())
                 return Ordering::EQUAL;
             return Ordering::UNDEFINED;
         case VALUE_CHAR:
-            if (as.c < other.as.c)
+            if (as_char() < other.as_char())
                 return Ordering::LESS;
-            else if (as.c > other.as.c)
+            else if (as_char() > other.as_char())
                 return Ordering::GREATER;
             else
                 return Ordering::EQUAL;
         case VALUE_INT:
-            if (as.i < other.as.i)
+            if (as_int() < other.as_int())
                 return Ordering::LESS;
-            else if (as.i > other.as.i)
+            else if (as_int() > other.as_int())
                 return Ordering::GREATER;
             else
                 return Ordering::EQUAL;
         case VALUE_UINT:
-            if (as.u < other.as.u)
+            if (as_uint() < other.as_uint())
                 return Ordering::LESS;
-            else if (as.u > other.as.u)
+            else if (as_uint() > other.as_uint())
                 return Ordering::GREATER;
             else
                 return Ordering::EQUAL;
         case VALUE_FLOAT:
-            if (as.f < other.as.f)
+            if (as_float() < other.as_float())
                 return Ordering::LESS;
-            else if (as.f > other.as.f)
+            else if (as_float() > other.as_float())
                 return Ordering::GREATER;
             else
                 return Ordering::EQUAL;
         case VALUE_OBJ:
-            return as.obj->compare(other.as.obj);
+            return as_obj()->compare(other.as_obj());
         default:
             throw Unreachable();
         }
@@ -99,227 +128,233 @@ namespace spade
     }
 
     Value Value::operator-() const {
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(-as.i);
+            return checked_int(-as_int());
         case VALUE_UINT:
-            return Value(-as.u);
+            return checked_uint(-as_uint());
         case VALUE_FLOAT:
-            return Value(-as.i);
+            return Value(-as_float());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::power(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(std::pow(as.i, n.as.i));
+            return Value(std::pow(as_int(), n.as_int()));
         case VALUE_UINT:
-            return Value(std::pow(as.u, n.as.u));
+            return Value(std::pow(as_uint(), n.as_uint()));
         case VALUE_FLOAT:
-            return Value(std::pow(as.f, n.as.f));
+            return Value(std::pow(as_float(), n.as_float()));
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator+(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i + n.as.i);
+            return checked_int(as_int() + n.as_int());
         case VALUE_UINT:
-            return Value(as.u + n.as.u);
+            return checked_uint(as_uint() + n.as_uint());
         case VALUE_FLOAT:
-            return Value(as.f + n.as.f);
+            return Value(as_float() + n.as_float());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator-(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i - n.as.i);
+            return checked_int(as_int() - n.as_int());
         case VALUE_UINT:
-            return Value(as.u - n.as.u);
+            return checked_uint(as_uint() - n.as_uint());
         case VALUE_FLOAT:
-            return Value(as.f - n.as.f);
+            return Value(as_float() - n.as_float());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator*(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i * n.as.i);
+#ifdef SWAN_NAN_BOXING
+            check_product(as_int(), n.as_int());
+#endif
+            return checked_int(as_int() * n.as_int());
         case VALUE_UINT:
-            return Value(as.u * n.as.u);
+#ifdef SWAN_NAN_BOXING
+            check_product(as_uint(), n.as_uint());
+#endif
+            return checked_uint(as_uint() * n.as_uint());
         case VALUE_FLOAT:
-            return Value(as.f * n.as.f);
+            return Value(as_float() * n.as_float());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator/(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i / n.as.i);
+            return checked_int(as_int() / n.as_int());
         case VALUE_UINT:
-            return Value(as.u / n.as.u);
+            return checked_uint(as_uint() / n.as_uint());
         case VALUE_FLOAT:
-            return Value(as.f / n.as.f);
+            return Value(as_float() / n.as_float());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator~() const {
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(~as.i);
+            return Value(~as_int());
         case VALUE_UINT:
-            return Value(~as.u);
+            return Value(~as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator%(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i % n.as.i);
+            return Value(as_int() % n.as_int());
         case VALUE_UINT:
-            return Value(as.u % n.as.u);
+            return Value(as_uint() % n.as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator<<(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i << n.as.i);
+            return Value(as_int() << n.as_int());
         case VALUE_UINT:
-            return Value(as.u << n.as.u);
+            return Value(as_uint() << n.as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator>>(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i >> n.as.i);
+            return Value(as_int() >> n.as_int());
         case VALUE_UINT:
-            return Value(as.u >> n.as.u);
+            return Value(as_uint() >> n.as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator&(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i & n.as.i);
+            return Value(as_int() & n.as_int());
         case VALUE_UINT:
-            return Value(as.u & n.as.u);
+            return Value(as_uint() & n.as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator|(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i | n.as.i);
+            return Value(as_int() | n.as_int());
         case VALUE_UINT:
-            return Value(as.u | n.as.u);
+            return Value(as_uint() | n.as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::operator^(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(as.i ^ n.as.i);
+            return Value(as_int() ^ n.as_int());
         case VALUE_UINT:
-            return Value(as.u ^ n.as.u);
+            return Value(as_uint() ^ n.as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::unsigned_right_shift(const Value &n) const {
-        if (tag != n.tag)
+        if (get_tag() != n.get_tag())
             throw Unreachable();
 
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            return Value(static_cast<int64_t>(static_cast<uint64_t>(as.i) >> n.as.i));
+            return Value(static_cast<int64_t>(static_cast<uint64_t>(as_int()) >> n.as_int()));
         case VALUE_UINT:
-            return Value(as.u >> n.as.u);
+            return Value(as_uint() >> n.as_uint());
         default:
             throw Unreachable();
         }
     }
 
     Value Value::rotate_left(const Value &n) const {
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            switch (n.tag) {
+            switch (n.get_tag()) {
             case VALUE_INT:
-                return Value(static_cast<int64_t>(std::rotl(static_cast<uint64_t>(as.i), n.as.i)));
+                return Value(static_cast<int64_t>(std::rotl(static_cast<uint64_t>(as_int()), n.as_int())));
                 break;
             case VALUE_UINT:
-                return Value(static_cast<int64_t>(std::rotl(static_cast<uint64_t>(as.i), n.as.u)));
+                return Value(static_cast<int64_t>(std::rotl(static_cast<uint64_t>(as_int()), n.as_uint())));
                 break;
             default:
                 throw Unreachable();
             }
         case VALUE_UINT:
-            switch (n.tag) {
+            switch (n.get_tag()) {
             case VALUE_INT:
-                return Value(std::rotl(as.u, n.as.i));
+                return Value(std::rotl(as_uint(), n.as_int()));
                 break;
             case VALUE_UINT:
-                return Value(std::rotl(as.u, n.as.u));
+                return Value(std::rotl(as_uint(), n.as_uint()));
                 break;
             default:
                 throw Unreachable();
@@ -330,25 +365,25 @@ namespace spade
     }
 
     Value Value::rotate_right(const Value &n) const {
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_INT:
-            switch (n.tag) {
+            switch (n.get_tag()) {
             case VALUE_INT:
-                return Value(static_cast<int64_t>(std::rotr(static_cast<uint64_t>(as.i), n.as.i)));
+                return Value(static_cast<int64_t>(std::rotr(static_cast<uint64_t>(as_int()), n.as_int())));
                 break;
             case VALUE_UINT:
-                return Value(static_cast<int64_t>(std::rotr(static_cast<uint64_t>(as.i), n.as.u)));
+                return Value(static_cast<int64_t>(std::rotr(static_cast<uint64_t>(as_int()), n.as_uint())));
                 break;
             default:
                 throw Unreachable();
             }
         case VALUE_UINT:
-            switch (n.tag) {
+            switch (n.get_tag()) {
             case VALUE_INT:
-                return Value(std::rotr(as.u, n.as.i));
+                return Value(std::rotr(as_uint(), n.as_int()));
                 break;
             case VALUE_UINT:
-                return Value(std::rotr(as.u, n.as.u));
+                return Value(std::rotr(as_uint(), n.as_uint()));
                 break;
             default:
                 throw Unreachable();
@@ -359,57 +394,57 @@ namespace spade
     }
 
     Value Value::copy() const {
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_NULL:
             return Value();
         case VALUE_BOOL:
-            return Value(static_cast<bool>(as.b));
+            return Value(as_bool());
         case VALUE_CHAR:
-            return Value(as.c);
+            return Value(as_char());
         case VALUE_INT:
-            return Value(as.i);
+            return Value(as_int());
         case VALUE_FLOAT:
-            return Value(as.f);
+            return Value(as_float());
         case VALUE_OBJ:
-            return Value(as.obj);
+            return Value(as_obj());
         default:
             throw Unreachable();
         }
     }
 
     bool Value::truth() const {
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_NULL:
             return false;
         case VALUE_BOOL:
-            return as.b;
+            return as_bool();
         case VALUE_CHAR:
-            return as.c != '\0';
+            return as_char() != '\0';
         case VALUE_INT:
-            return as.i != 0;
+            return as_int() != 0;
         case VALUE_FLOAT:
-            return as.f != 0.0;
+            return as_float() != 0.0;
         case VALUE_OBJ:
-            return as.obj->truth();
+            return as_obj()->truth();
         default:
             throw Unreachable();
         }
     }
 
     string Value::to_string() const {
-        switch (tag) {
+        switch (get_tag()) {
         case VALUE_NULL:
             return "null";
         case VALUE_BOOL:
-            return as.b ? "true" : "false";
+            return as_bool() ? "true" : "false";
         case VALUE_CHAR:
-            return string(1, as.c);
+            return string(1, as_char());
         case VALUE_INT:
-            return std::to_string(as.i);
+            return std::to_string(as_int());
         case VALUE_FLOAT:
-            return std::to_string(as.f);
+            return std::to_string(as_float());
         case VALUE_OBJ:
-            return as.obj->to_string();
+            return as_obj()->to_string();
         default:
             throw Unreachable();
         }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "utils/common.hpp"
+#include <bit>
 #include <cassert>
+#include <cmath>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
@@ -27,9 +29,67 @@ namespace spade
         VALUE_OBJ,
     };
 
+    /**
+     * Represents a value in the vm. The representation is selected at build time:
+     *
+     *  - By default, a value is 16 bytes, a 64-bit ValueTag followed by an 8 byte payload.
+     *  - If SWAN_NAN_BOXING is defined, a value is 8 bytes. Floats are stored as plain doubles
+     *    (all NaNs are canonicalized) and every other value is stored in the payload bits of a
+     *    negative quiet NaN as [1111111111111: 13][tag: 3][payload: 48].
+     *    In this mode ints and uints are 48 bits wide and object pointers must fit in 48 bits.
+     *    An arithmetic operation whose result does not fit raises IntegerOverflowError, the loader
+     *    rejects the int constants which do not fit, and the bitwise operations wrap around at 48 bits.
+     */
     class SWAN_EXPORT Value final {
         friend class ValueCheck;
 
+#ifdef SWAN_NAN_BOXING
+      public:
+        /// Mask of the payload bits of a boxed value
+        static constexpr const uint64_t PAYLOAD_MASK = 0x0000'FFFF'FFFF'FFFF;
+        /// Smallest int which can be represented
+        static constexpr const int64_t INT_MIN_VALUE = -(int64_t{1} << 47);
+        /// Largest int which can be represented
+        static constexpr const int64_t INT_MAX_VALUE = (int64_t{1} << 47) - 1;
+        /// Largest uint which can be represented
+        static constexpr const uint64_t UINT_MAX_VALUE = PAYLOAD_MASK;
+
+      private:
+        static constexpr const uint64_t BOX_MASK = 0xFFF8'0000'0000'0000;
+        static constexpr const uint64_t TAG_SHIFT = 48;
+        static constexpr const uint64_t CANONICAL_NAN = 0x7FF8'0000'0000'0000;
+
+        uint64_t bits;
+
+        static constexpr uint64_t box(ValueTag tag, uint64_t payload) {
+            return BOX_MASK | static_cast<uint64_t>(tag) << TAG_SHIFT | (payload & PAYLOAD_MASK);
+        }
+
+        static uint64_t unbox_float(double f) {
+            return std::isnan(f) ? CANONICAL_NAN : std::bit_cast<uint64_t>(f);
+        }
+
+        bool has_tag(ValueTag tag) const {
+            return bits >> TAG_SHIFT == box(tag, 0) >> TAG_SHIFT;
+        }
+
+      public:
+        Value(std::nullptr_t) : bits(box(VALUE_NULL, 0)) {}
+
+        explicit Value() : bits(box(VALUE_NULL, 0)) {}
+
+        explicit Value(bool b) : bits(box(VALUE_BOOL, b)) {}
+
+        explicit Value(char c) : bits(box(VALUE_CHAR, static_cast<uint8_t>(c))) {}
+
+        explicit Value(std::signed_integral auto i) : bits(box(VALUE_INT, static_cast<uint64_t>(static_cast<int64_t>(i)))) {}
+
+        explicit Value(std::unsigned_integral auto u) : bits(box(VALUE_UINT, u)) {}
+
+        explicit Value(std::floating_point auto f) : bits(unbox_float(f)) {}
+
+        Value(Obj *obj) : bits(box(VALUE_OBJ, reinterpret_cast<uint64_t>(obj))) {}
+#else
         ValueTag tag;
 
         union As {
@@ -77,6 +137,7 @@ namespace spade
         explicit Value(std::floating_point auto f) : tag(VALUE_FLOAT), as{.f = f} {}
 
         Value(Obj *obj) : tag(VALUE_OBJ), as{.obj = obj} {}
+#endif
 
         Value(const Value &) = default;
         Value(Value &&) = default;
@@ -84,6 +145,22 @@ namespace spade
         Value &operator=(Value &&) = default;
         ~Value() = default;
 
+        /**
+         * Makes the value of the result of an int operation
+         * @throws IntegerOverflowError if @p i does not fit in the ints of this build
+         * @param i the result
+         * @return the int value
+         */
+        static Value checked_int(int64_t i);
+
+        /**
+         * Makes the value of the result of a uint operation
+         * @throws IntegerOverflowError if @p u does not fit in the uints of this build
+         * @param u the result
+         * @return the uint value
+         */
+        static Value checked_uint(uint64_t u);
+
         Ordering compare(const Value &other) const;
         Value operator<(const Value &other) const;
         Value operator>(const Value &other) const;
@@ -132,6 +209,107 @@ namespace spade
          */
         string to_string() const;
 
+#ifdef SWAN_NAN_BOXING
+        ValueTag get_tag() const {
+            if ((bits & BOX_MASK) != BOX_MASK)
+                return VALUE_FLOAT;
+            return static_cast<ValueTag>(bits >> TAG_SHIFT & 0x7);
+        }
+
+        /**
+         * @return the raw bits of the value, used by the jit compiler
+         */
+        uint64_t get_raw() const {
+            return bits;
+        }
+
+        bool is_null() const {
+            return has_tag(VALUE_NULL);
+        }
+
+        bool is_bool() const {
+            return has_tag(VALUE_BOOL);
+        }
+
+        bool is_char() const {
+            return has_tag(VALUE_CHAR);
+        }
+
+        bool is_int() const {
+            return has_tag(VALUE_INT);
+        }
+
+        bool is_uint() const {
+            return has_tag(VALUE_UINT);
+        }
+
+        bool is_float() const {
+            return (bits & BOX_MASK) != BOX_MASK;
+        }
+
+        bool is_obj() const {
+            return has_tag(VALUE_OBJ);
+        }
+
+        bool as_bool() const {
+            assert(is_bool());
+            return (bits & PAYLOAD_MASK) != 0;
+        }
+
+        char as_char() const {
+            assert(is_char());
+            return static_cast<char>(bits & 0xFF);
+        }
+
+        int64_t as_int() const {
+            assert(is_int());
+            // Sign extend the 48 bit payload
+            return static_cast<int64_t>(bits << 16) >> 16;
+        }
+
+        uint64_t as_uint() const {
+            assert(is_uint());
+            return bits & PAYLOAD_MASK;
+        }
+
+        double as_float() const {
+            assert(is_float());
+            return std::bit_cast<double>(bits);
+        }
+
+        Obj *as_obj() const {
+            assert(is_obj());
+            return reinterpret_cast<Obj *>(bits & PAYLOAD_MASK);
+        }
+
+        void set(std::nullptr_t) {
+            bits = box(VALUE_NULL, 0);
+        }
+
+        void set(bool b) {
+            bits = box(VALUE_BOOL, b);
+        }
+
+        void set(char c) {
+            bits = box(VALUE_CHAR, static_cast<uint8_t>(c));
+        }
+
+        void set(int64_t i) {
+            bits = box(VALUE_INT, static_cast<uint64_t>(i));
+        }
+
+        void set(uint64_t u) {
+            bits = box(VALUE_UINT, u);
+        }
+
+        void set(double f) {
+            bits = unbox_float(f);
+        }
+
+        void set(Obj *obj) {
+            bits = box(VALUE_OBJ, reinterpret_cast<uint64_t>(obj));
+        }
+#else
         ValueTag get_tag() const {
             return tag;
         }
@@ -227,9 +405,14 @@ namespace spade
             tag = VALUE_OBJ;
             as.obj = obj;
         }
+#endif
     };
 
     class ValueCheck {
+#ifdef SWAN_NAN_BOXING
+        static_assert(sizeof(Value) == 8, "Size of Value class must be 8 bytes");
+        static_assert(sizeof(Obj *) == 8, "NaN boxing requires 64 bit pointers");
+#else
         static_assert(sizeof(Value) == 16, "Size of Value class must be 16 bytes");
 
         static_assert(offsetof(Value, tag) == 0, "Value::tag should be at offset 0");
@@ -242,6 +425,7 @@ namespace spade
         static_assert(sizeof(Value::tag) == 8, "Value::tag should be 8 bytes");
         static_assert(sizeof(Value::As::f) == 8, "Value::As::f should be 8 bytes");
         static_assert(sizeof(Obj *) == 4 || sizeof(Obj *) == 8, "Value::as::obj should be 4 or 8 bytes");
+#endif
 
       public:
         ValueCheck() = delete;
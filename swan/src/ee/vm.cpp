@@ -1,7 +1,9 @@
 #include "vm.hpp"
 #include "utils/errors.hpp"
 #include "memory/memory.hpp"
+#include "memory/snapshot.hpp"
 #include "loader/loader.hpp"
+#include "pool.hpp"
 #include "spimp/utils.hpp"
 #include <cstdlib>
 #include <functional>
@@ -18,6 +20,7 @@ namespace spade
           threads(),
           manager(manager),
           loader(this),
+          intern_table(),
           on_exit_list(),
           settings(settings),
           metadata(),
@@ -28,20 +31,27 @@ namespace spade
         manager->set_vm(this);
     }
 
+    SpadeVM::~SpadeVM() {
+        if (manager->get_vm() == this)
+            manager->set_vm(null);
+    }
+
     void SpadeVM::on_exit(const std::function<void()> &fun) {
         spdlog::info("SpadeVM: registered exit hook");
         on_exit_list.push_back(fun);
     }
 
     void SpadeVM::start(const string &filename, const vector<string> &args, bool block) {
-        Thread thread(this, std::bind(&SpadeVM::vm_main, this, filename, args, std::placeholders::_1), [&] {
-            spdlog::info("SpadeVM: Thread registered in the vm");
-            // Insert thread into vm threads before the thread starts
+        // The vm runs on a pooled thread, which is reused by the later starts of this and the other vms
+        auto run = ThreadPool::get().submit([this, filename, args] {
+            Thread thread(this);
             threads.insert(&thread);
+            spdlog::info("SpadeVM: Thread registered in the vm");
+            vm_main(filename, args, &thread);
         });
 
         if (block)
-            thread.join();
+            run.get();
     }
 
     ThrowSignal SpadeVM::runtime_error(const string &str) const {
@@ -95,6 +105,8 @@ namespace spade
         const auto &elements = symbol_sign.get_elements();
         size_t i = 0;
         Value value;
+        // Globals are reachable from every thread
+        Obj::publish(val);
 
         if (const auto it = modules.find(elements[i++].to_string()); it != modules.end())
             value = it->second;
@@ -144,6 +156,32 @@ namespace spade
         metadata[sign] = meta;
     }
 
+    Scheduler *SpadeVM::get_scheduler() {
+        std::call_once(scheduler_once, [this] { scheduler = std::make_unique<Scheduler>(this, settings.worker_count); });
+        return scheduler.get();
+    }
+
+    IoLoop *SpadeVM::get_io_loop() {
+        std::call_once(io_loop_once, [this] { io_loop = std::make_unique<IoLoop>(this); });
+        return io_loop.get();
+    }
+
+    void SpadeVM::for_each_root(const std::function<void(Obj *)> &func) const {
+        for (const auto &[_, module]: modules) func(module);
+        intern_table.for_each(func);
+        if (scheduler)
+            scheduler->for_each_root(func);
+        for (const auto thread: threads) {
+            if (const auto value = thread->get_value())
+                func(value);
+            thread->get_state().for_each_reference(func);
+        }
+    }
+
+    void SpadeVM::write_heap_snapshot(const fs::path &path) const {
+        HeapSnapshotWriter(this).write(path);
+    }
+
     // Type *SpadeVM::get_vm_type(ObjTag tag) {
     //     switch (tag) {
     //     case ObjTag::NULL_OBJ:
@@ -168,9 +206,7 @@ namespace spade
     // }
 
     SpadeVM *SpadeVM::current() {
-        if (const auto thread = Thread::current())
-            return thread->get_vm();
-        return null;
+        return Thread::get_context().vm;
     }
 
     void SpadeVM::load_basic() {
@@ -205,6 +241,7 @@ namespace spade
         module->set_member("string", type_string);
         module->set_member("array[T]", type_array);
 
+        module->publish();
         modules["basic"] = module;
 
         spdlog::info("SpadeVM: Loaded basic module");
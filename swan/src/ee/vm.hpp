@@ -1,8 +1,11 @@
 #pragma once
 
 #include "debugger.hpp"
+#include "intern.hpp"
 #include "loader/loader.hpp"
 #include "obj.hpp"
+#include "io.hpp"
+#include "scheduler.hpp"
 #include "thread.hpp"
 #include "utils/errors.hpp"
 #include <set>
@@ -20,6 +23,8 @@ namespace spade
         string INFO_STRING = std::format("{} {} {}", LANG_NAME, VM_NAME, VERSION);
 
         size_t max_call_stack_depth = 1024;
+        /// Number of worker threads running the tasks, the hardware concurrency if it is zero
+        size_t worker_count = 0;
 
         fs::path lib_path;
         vector<fs::path> mod_path;
@@ -34,6 +39,8 @@ namespace spade
         MemoryManager *manager;
         /// The loader
         Loader loader;
+        /// The interned strings
+        InternTable intern_table;
         /// The actions to be performed when the vm terminates
         std::vector<std::function<void()>> on_exit_list;
         /// The vm settings
@@ -47,12 +54,23 @@ namespace spade
         std::unique_ptr<Debugger> debugger;
         /// The output stream
         std::stringstream out;
+        /// The task scheduler, which is started when the first task is spawned
+        std::unique_ptr<Scheduler> scheduler;
+        std::once_flag scheduler_once;
+        /// The asynchronous io loop, which is started with the first io operation. It is destroyed before the scheduler
+        std::unique_ptr<IoLoop> io_loop;
+        std::once_flag io_loop_once;
 
         // State variables
 
       public:
         explicit SpadeVM(MemoryManager *manager, std::unique_ptr<Debugger> debugger = null, const Settings &settings = {});
 
+        /**
+         * Detaches the memory manager from the vm, so that the manager can be reset or reused after the vm is gone
+         */
+        ~SpadeVM();
+
         /**
          * This function registers the action which will be executed
          * when the virtual machine terminates
@@ -61,7 +79,9 @@ namespace spade
         void on_exit(const std::function<void()> &fun);
 
         /**
-         * This function initiates the virtual machine
+         * This function initiates the virtual machine on a thread of the process wide ThreadPool.
+         * The code of the loaded files is shared with the other vms through the CodeCache,
+         * while the heap, the modules and the interned strings belong to this vm
          * @param filename the path to the bytecode file
          * @param args the command line args array
          * @param block blocks the caller if the flag is set
@@ -120,6 +140,21 @@ namespace spade
          */
         // Type *get_vm_type(ObjTag tag);
 
+        /**
+         * Calls @p func for every root object of the vm.
+         * The roots are the modules, the interned strings, the unfinished tasks and the values referenced by the call stacks of the vm threads
+         * @param func the function to be called
+         */
+        void for_each_root(const std::function<void(Obj *)> &func) const;
+
+        /**
+         * Writes a snapshot of the heap reachable from the roots to the file at @p path.
+         * The vm threads must be stopped while the snapshot is being written
+         * @throws FileNotFoundError if the file cannot be opened
+         * @param path the path of the snapshot file
+         */
+        void write_heap_snapshot(const fs::path &path) const;
+
         /**
          * @return the set of vm threads
          */
@@ -148,6 +183,23 @@ namespace spade
             return settings;
         }
 
+        /**
+         * @return the table of the interned strings
+         */
+        InternTable &get_intern_table() {
+            return intern_table;
+        }
+
+        /**
+         * @return the task scheduler, which is started if it is not running yet
+         */
+        Scheduler *get_scheduler();
+
+        /**
+         * @return the asynchronous io loop, which is started if it is not running yet
+         */
+        IoLoop *get_io_loop();
+
         /**
          * @return the memory manager
          */
@@ -76,6 +76,10 @@
 ///     or
 ///         void handle(Obj *self, Value *ret, const Value *arg0, const Value *arg1);
 ///     and so on ...
+///
+/// * Value layout on the JIT stack
+///     By default a value is 16 bytes, the tag at offset 0 and the payload at offset 8.
+///     If SWAN_NAN_BOXING is defined, a value is a single NaN-boxed 8 byte word.
 
 namespace spade
 {
@@ -138,7 +142,8 @@ namespace spade
                 case Opcode::JEQ:
                 case Opcode::JNE:
                 case Opcode::JGE:
-                case Opcode::JGT: {
+                case Opcode::JGT:
+                case Opcode::RESUME: {
                     const auto offset = static_cast<int16_t>(num);
                     param = std::to_string(offset);
                     break;
@@ -224,6 +229,9 @@ namespace spade
     }
 
     class FunctionBodyGen {
+        /// Size of a value on the stack
+        static constexpr const int64_t VALUE_SIZE = sizeof(Value);
+
         const ObjMethod *method;
         asmjit::x86::Assembler &a;
         bool has_self;
@@ -241,11 +249,10 @@ namespace spade
               a(a),
               has_self(has_self),
               exit(exit),
-              vm(method->get_info().manager->get_vm()),
+              vm(method->get_manager()->get_vm()),
               sc(stack_counter),
               conpool(cast<ObjModule>(                                                                    //
-                              method->get_info()                                                          //
-                                      .manager                                                            //
+                              method->get_manager()                                                       //
                                       ->get_vm()                                                          //
                                       ->get_symbol(method->get_sign().get_parent_module().to_string())    //
                                       .as_obj()                                                           //
@@ -283,29 +290,24 @@ namespace spade
                 case Opcode::PLFSTORE: {
                     const auto index = read_byte();
                     spdlog::trace("FunctionBodyGen: plfstore {}", index);
-                    a.mov(rax, qword_ptr(rbp, sc + 8));
-                    a.mov(qword_ptr(rbp, local_positions[index] + 8), rax);
-                    a.mov(rax, qword_ptr(rbp, sc));
-                    a.mov(qword_ptr(rbp, local_positions[index]), rax);
-                    sc += 16;    // Pop one value
+                    copy_value(sc, local_positions[index]);
+                    sc += VALUE_SIZE;    // Pop one value
                     break;
                 }
                 case Opcode::CONCAT: {
                     // FIXME: concat does not work, I don't know why
                     spdlog::trace("FunctionBodyGen: concat");
-                    a.mov(reg_arg0(), qword_ptr(rbp, sc + 24));
-                    a.mov(reg_arg1(), qword_ptr(rbp, sc + 8));
+                    load_obj(reg_arg0(), sc + VALUE_SIZE);
+                    load_obj(reg_arg1(), sc);
                     a.call(imm((void *) jit_concat));
-                    sc += 32;    // Pop two values
-                    sc -= 16;    // Push the concat value
-                    a.mov(qword_ptr(rbp, sc + 8), rax);
-                    a.mov(qword_ptr(rbp, sc), imm(VALUE_OBJ));
+                    sc += 2 * VALUE_SIZE;    // Pop two values
+                    sc -= VALUE_SIZE;        // Push the concat value
+                    store_obj(sc);
                     break;
                 }
                 case Opcode::NISNULL: {
                     spdlog::trace("FunctionBodyGen: println");
-                    ///             mov rax, [rbp-sc]
-                    ///             test rax, rax
+                    ///             cmp [rbp-sc], null
                     ///             jnz br_else
                     ///             push(false)
                     ///             jmp br_end
@@ -314,8 +316,7 @@ namespace spade
                     auto br_else = a.new_label();
                     auto br_end = a.new_label();
 
-                    a.mov(rax, qword_ptr(rbp, sc));
-                    a.test(rax, rax);
+                    test_null(sc);
                     a.jnz(br_else);
                     push(Value(false));
                     a.jmp(br_end);
@@ -323,7 +324,7 @@ namespace spade
                     push(Value(true));
                     a.bind(br_end);
 
-                    sc += 16;    // Pop one value
+                    sc += VALUE_SIZE;    // Pop one value
                     break;
                 }
                 case Opcode::JT: {
@@ -331,7 +332,7 @@ namespace spade
                     const int16_t offset = read_short();
                     a.lea(reg_arg0(), qword_ptr(rbp, sc));
                     a.call(imm((void *) jit_value_truth));
-                    sc += 16;    // Pop one value
+                    sc += VALUE_SIZE;    // Pop one value
                     a.test(rax, rax);
                     // TODO: implement jumps
                     break;
@@ -341,7 +342,7 @@ namespace spade
                     a.mov(reg_arg0(), imm(vm));
                     a.lea(reg_arg1(), qword_ptr(rbp, sc));
                     a.call(imm((void *) jit_println));
-                    sc += 16;    // Pop one values
+                    sc += VALUE_SIZE;    // Pop one values
                     break;
                 }
                 case Opcode::VRET: {
@@ -359,34 +360,94 @@ namespace spade
 
       private:
         void load_local(size_t index) {
+            sc -= VALUE_SIZE;
+            copy_value(local_positions[index], sc);
+        }
+
+        /**
+         * Copies the value at @p from to @p to, both relative to rbp. Clobbers rax
+         */
+        void copy_value(int64_t from, int64_t to) {
             using namespace asmjit;
             using namespace asmjit::x86;
 
-            sc -= 16;
+#ifdef SWAN_NAN_BOXING
+            a.mov(rax, qword_ptr(rbp, from));
+            a.mov(qword_ptr(rbp, to), rax);
+#else
+            a.mov(rax, qword_ptr(rbp, from + 8));
+            a.mov(qword_ptr(rbp, to + 8), rax);
+            a.mov(rax, qword_ptr(rbp, from));
+            a.mov(qword_ptr(rbp, to), rax);
+#endif
+        }
 
-            a.mov(rax, qword_ptr(rbp, local_positions[index] + 8));
-            a.mov(qword_ptr(rbp, sc + 8), rax);
-            a.mov(rax, qword_ptr(rbp, local_positions[index]));
-            a.mov(qword_ptr(rbp, sc), rax);
+        /**
+         * Loads the object pointer of the value at @p at (relative to rbp) to @p reg. Clobbers r11
+         */
+        void load_obj(const asmjit::x86::Gp &reg, int64_t at) {
+            using namespace asmjit;
+            using namespace asmjit::x86;
+
+#ifdef SWAN_NAN_BOXING
+            a.mov(reg, qword_ptr(rbp, at));
+            a.mov(r11, imm(Value::PAYLOAD_MASK));
+            a.and_(reg, r11);
+#else
+            a.mov(reg, qword_ptr(rbp, at + 8));
+#endif
         }
 
-        void push_null() {
+        /**
+         * Stores the object pointer in rax as a value at @p at (relative to rbp). Clobbers rax and r11
+         */
+        void store_obj(int64_t at) {
             using namespace asmjit;
             using namespace asmjit::x86;
 
-            sc -= 16;
+#ifdef SWAN_NAN_BOXING
+            a.mov(r11, imm(Value(static_cast<Obj *>(null)).get_raw()));
+            a.or_(rax, r11);
+            a.mov(qword_ptr(rbp, at), rax);
+#else
+            a.mov(qword_ptr(rbp, at + 8), rax);
+            a.mov(qword_ptr(rbp, at), imm(VALUE_OBJ));
+#endif
+        }
 
-            // Push the value
-            a.mov(qword_ptr(rbp, sc + 8), imm(0));
-            a.mov(qword_ptr(rbp, sc), imm(0));
+        /**
+         * Compares the value at @p at (relative to rbp) with null and sets the zero flag if it is null.
+         * Clobbers rax and r11
+         */
+        void test_null(int64_t at) {
+            using namespace asmjit;
+            using namespace asmjit::x86;
+
+#ifdef SWAN_NAN_BOXING
+            a.mov(rax, qword_ptr(rbp, at));
+            a.mov(r11, imm(Value().get_raw()));
+            a.cmp(rax, r11);
+#else
+            // The tag of null is zero
+            a.mov(rax, qword_ptr(rbp, at));
+            a.test(rax, rax);
+#endif
+        }
+
+        void push_null() {
+            push(Value());
         }
 
         void push(Value value) {
             using namespace asmjit;
             using namespace asmjit::x86;
 
-            sc -= 16;
+            sc -= VALUE_SIZE;
 
+#ifdef SWAN_NAN_BOXING
+            a.mov(rax, imm(value.get_raw()));
+            a.mov(qword_ptr(rbp, sc), rax);
+#else
             // Push the value
             switch (value.get_tag()) {
             case VALUE_NULL:
@@ -416,6 +477,7 @@ namespace spade
             }
             // Push the value tag
             a.mov(qword_ptr(rbp, sc), imm(value.get_tag()));
+#endif
         }
 
         uint8_t read_byte() {
@@ -0,0 +1,136 @@
+#include "code_cache.hpp"
+#include "elpops/reader.hpp"
+#include "spimp/utils.hpp"
+#include "utils/errors.hpp"
+#include "verifier.hpp"
+#include <spdlog/spdlog.h>
+
+namespace spade
+{
+    CodeUnit::CodeUnit(const fs::path &path) : path(path) {
+        ElpReader reader(path);
+        info = reader.read();
+        spdlog::info("CodeCache: Read file '{}'", reader.get_path());
+        Verifier verifier(info, path.generic_string());
+        verifier.verify();
+        spdlog::info("CodeCache: Verified file '{}'", reader.get_path());
+        for (const auto &module: info.modules) make_images(module);
+    }
+
+    const MethodImage &CodeUnit::get_image(const MethodInfo &method) const {
+        if (const auto it = images.find(&method); it != images.end())
+            return it->second;
+        throw Unreachable();
+    }
+
+    void CodeUnit::make_images(const ModuleInfo &module) {
+        // The classes use the constant pool of their module
+        for (const auto &method: module.methods) make_image(method, module.constant_pool);
+        for (const auto &klass: module.classes)
+            for (const auto &method: klass.methods) make_image(method, module.constant_pool);
+        for (const auto &inner: module.modules) make_images(inner);
+    }
+
+    /**
+     * @return the match tables of @p method, null if a case of them is not a scalar constant
+     */
+    static std::shared_ptr<const vector<MatchTable>> make_matches(const MethodInfo &method, const vector<CpInfo> &cps) {
+        vector<MatchTable> matches;
+        for (const auto &match: method.matches) {
+            vector<Case> cases;
+            for (const auto &kase: match.cases) {
+                const auto value = load_scalar_constant(cps[kase.value]);
+                // The match tables of this method are built by each vm from its own constants
+                if (!value)
+                    return null;
+                cases.emplace_back(*value, kase.location);
+            }
+            matches.emplace_back(cases, match.default_location);
+        }
+        return std::make_shared<const vector<MatchTable>>(std::move(matches));
+    }
+
+    void CodeUnit::make_image(const MethodInfo &method, const vector<CpInfo> &cps) {
+        MethodImage image;
+        const auto code = std::make_shared<uint8_t[]>(method.code.size());
+        std::copy(method.code.begin(), method.code.end(), code.get());
+        image.code = code;
+
+        LineNumberTable lines;
+        for (const auto &number: method.line_info.numbers) lines.add_line(number.times, number.lineno);
+        image.lines = std::make_shared<const LineNumberTable>(std::move(lines));
+
+        image.matches = make_matches(method, cps);
+        images.emplace(&method, std::move(image));
+    }
+
+    std::shared_ptr<const CodeUnit> CodeCache::load(const fs::path &path) {
+        std::error_code ec;
+        const auto modified = fs::last_write_time(path, ec);
+        const auto size = ec ? 0 : fs::file_size(path, ec);
+        // The reader reports the files which cannot be read
+        if (ec)
+            return std::make_shared<const CodeUnit>(path);
+
+        const auto key = path.lexically_normal().generic_string();
+        {
+            std::lock_guard lk(mtx);
+            if (const auto it = entries.find(key); it != entries.end() && it->second.modified == modified && it->second.size == size) {
+                spdlog::info("CodeCache: Found file '{}'", key);
+                return it->second.unit;
+            }
+        }
+        // Read the file without holding the lock, so that the other files can be loaded meanwhile
+        const auto unit = std::make_shared<const CodeUnit>(path);
+        std::lock_guard lk(mtx);
+        entries[key] = Entry{modified, size, unit};
+        return unit;
+    }
+
+    void CodeCache::evict(const fs::path &path) {
+        std::lock_guard lk(mtx);
+        entries.erase(path.lexically_normal().generic_string());
+    }
+
+    void CodeCache::clear() {
+        std::lock_guard lk(mtx);
+        entries.clear();
+    }
+
+    size_t CodeCache::size() {
+        std::lock_guard lk(mtx);
+        return entries.size();
+    }
+
+    CodeCache &CodeCache::get() {
+        static CodeCache cache;
+        return cache;
+    }
+
+    std::optional<Value> load_scalar_constant(const CpInfo &cp) {
+        switch (cp.tag) {
+        case 0x00:
+            return Value();
+        case 0x01:
+            return Value(true);
+        case 0x02:
+            return Value(false);
+        case 0x03:
+            return Value(static_cast<char>(std::get<uint32_t>(cp.value)));
+        case 0x04: {
+            const auto i = unsigned_to_signed(std::get<uint64_t>(cp.value));
+#ifdef SWAN_NAN_BOXING
+            // The constant would be silently truncated to the 48 bit ints
+            if (i < Value::INT_MIN_VALUE || i > Value::INT_MAX_VALUE)
+                throw IntegerOverflowError(std::format("int constant {} is out of the range [{}, {}] of this build", i,
+                                                       Value::INT_MIN_VALUE, Value::INT_MAX_VALUE));
+#endif
+            return Value(i);
+        }
+        case 0x05:
+            return Value(raw_to_double(std::get<uint64_t>(cp.value)));
+        default:
+            return std::nullopt;
+        }
+    }
+}    // namespace spade
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "callable/table.hpp"
+#include "elpops/elpdef.hpp"
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace spade
+{
+    /**
+     * The part of the code of a method which does not refer to the heap of any vm.
+     * It is shared by the methods loaded from the same file by all the vms of the process
+     */
+    struct SWAN_EXPORT MethodImage {
+        std::shared_ptr<const uint8_t[]> code;
+        std::shared_ptr<const LineNumberTable> lines;
+        /// The match tables, null if a case of them is a string or an array constant, which is allocated in the heap of a vm
+        std::shared_ptr<const vector<MatchTable>> matches;
+    };
+
+    /**
+     * A read and verified elp file together with the images of its methods
+     */
+    class SWAN_EXPORT CodeUnit {
+        fs::path path;
+        ElpInfo info;
+        std::unordered_map<const MethodInfo *, MethodImage> images;
+
+      public:
+        /**
+         * Reads and verifies the elp file at @p path and makes the images of its methods
+         * @throws FileNotFoundError if the file cannot be opened
+         * @throws CorruptFileError if the file fails the verification
+         * @param path the path of the file
+         */
+        explicit CodeUnit(const fs::path &path);
+
+        CodeUnit(const CodeUnit &other) = delete;
+        CodeUnit(CodeUnit &&other) noexcept = delete;
+        CodeUnit &operator=(const CodeUnit &other) = delete;
+        CodeUnit &operator=(CodeUnit &&other) noexcept = delete;
+        ~CodeUnit() = default;
+
+        /**
+         * @return the path of the file
+         */
+        const fs::path &get_path() const {
+            return path;
+        }
+
+        /**
+         * @return the contents of the file
+         */
+        const ElpInfo &get_info() const {
+            return info;
+        }
+
+        /**
+         * @param method the method info, which must belong to the info of this unit
+         * @return the image of @p method
+         */
+        const MethodImage &get_image(const MethodInfo &method) const;
+
+      private:
+        void make_images(const ModuleInfo &module);
+        void make_image(const MethodInfo &method, const vector<CpInfo> &cps);
+    };
+
+    /**
+     * The process wide cache of the loaded elp files.
+     * The vms loading the same file share its unit instead of reading and verifying it again,
+     * and so the bytecode, the line tables and the match tables of its methods.
+     * A unit is read again once the modification time or the size of its file changes
+     */
+    class SWAN_EXPORT CodeCache {
+        struct Entry {
+            fs::file_time_type modified;
+            uintmax_t size;
+            std::shared_ptr<const CodeUnit> unit;
+        };
+
+        std::unordered_map<string, Entry> entries;
+        std::mutex mtx;
+
+        CodeCache() = default;
+
+      public:
+        CodeCache(const CodeCache &other) = delete;
+        CodeCache(CodeCache &&other) noexcept = delete;
+        CodeCache &operator=(const CodeCache &other) = delete;
+        CodeCache &operator=(CodeCache &&other) noexcept = delete;
+        ~CodeCache() = default;
+
+        /**
+         * Returns the unit of the file at @p path, which is read and cached if it is not cached or is stale
+         * @throws FileNotFoundError if the file cannot be opened
+         * @throws CorruptFileError if the file fails the verification
+         * @param path the path of the file
+         * @return the unit
+         */
+        std::shared_ptr<const CodeUnit> load(const fs::path &path);
+
+        /**
+         * Removes the unit of the file at @p path from the cache. The methods already loaded from it keep their code
+         * @param path the path of the file
+         */
+        void evict(const fs::path &path);
+
+        /**
+         * Removes all the units from the cache
+         */
+        void clear();
+
+        /**
+         * @return the number of the cached units
+         */
+        size_t size();
+
+        /**
+         * @return the code cache of the process
+         */
+        static CodeCache &get();
+    };
+
+    /**
+     * @throws IntegerOverflowError if @p cp is an int constant which does not fit in the ints of this build
+     * @param cp the constant
+     * @return the value of @p cp if it is not allocated in the heap, which is the case of every constant except strings and arrays
+     */
+    SWAN_EXPORT std::optional<Value> load_scalar_constant(const CpInfo &cp);
+}    // namespace spade
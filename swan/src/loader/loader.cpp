@@ -3,10 +3,9 @@
 #include "callable/table.hpp"
 #include "ee/obj.hpp"
 #include "elpops/elpdef.hpp"
-#include "elpops/reader.hpp"
 #include "memory/memory.hpp"
+#include "spinfo/opcode.hpp"
 #include "spimp/utils.hpp"
-#include "verifier.hpp"
 #include <cstddef>
 #include <spdlog/spdlog.h>
 
@@ -15,26 +14,17 @@ namespace spade
     Loader::Loader(SpadeVM *vm) : vm(vm) {}
 
     LoadResult Loader::load(const fs::path &path) {
-        // Read the file
-        ElpReader reader(resolve_path("", path));
-        ElpInfo elp_info = reader.read();
-        spdlog::info("Loader: Read file '{}'", reader.get_path());
-        // Verify the file
-        Verifier verifier(elp_info, path.generic_string());
-        verifier.verify();
-        spdlog::info("Loader: Verified file '{}'", reader.get_path());
+        // Read the file, the units are shared by all the vms loading the same file
+        const auto unit = CodeCache::get().load(resolve_path("", path));
+        spdlog::info("Loader: Read file '{}'", unit->get_path().string());
         // Load the file
         std::vector<fs::path> imports;
-        string entry = load_elp(elp_info, path, imports);
+        string entry = load_elp(*unit, path, imports);
         // Load the imports
         for (size_t i = 0; i < imports.size(); i++) {
-            ElpReader reader(imports[i]);
-            ElpInfo elp_info = reader.read();
-            spdlog::info("Loader: Read import file '{}'", reader.get_path());
-            Verifier verifier(elp_info, path.generic_string());
-            verifier.verify();
-            spdlog::info("Loader: Verified file '{}'", reader.get_path());
-            load_elp(elp_info, path, imports);
+            const auto unit = CodeCache::get().load(imports[i]);
+            spdlog::info("Loader: Read import file '{}'", unit->get_path().string());
+            load_elp(*unit, path, imports);
         }
         // Find the module inits
         vector<ObjMethod *> inits;
@@ -80,14 +70,20 @@ namespace spade
 
     void Loader::start_conpool_scope(const vector<Value> &conpool) {
         conpool_stack.push_back(conpool);
+        member_names_stack.emplace_back(conpool.size(), null);
     }
 
     const vector<Value> &Loader::get_conpool() const {
         return conpool_stack.back();
     }
 
+    const vector<const ObjString *> &Loader::get_member_names() const {
+        return member_names_stack.back();
+    }
+
     void Loader::end_conpool_scope() {
         conpool_stack.pop_back();
+        member_names_stack.pop_back();
     }
 
     fs::path Loader::resolve_path(const fs::path &from_path, const fs::path &path) {
@@ -113,7 +109,9 @@ namespace spade
         return fs::exists(result) ? result : "";
     }
 
-    string Loader::load_elp(const ElpInfo &info, const fs::path &path, std::vector<fs::path> &imports) {
+    string Loader::load_elp(const CodeUnit &unit, const fs::path &path, std::vector<fs::path> &imports) {
+        const auto &info = unit.get_info();
+        this->unit = &unit;
         // TODO: version checking will be enabled later
         string entry = load_utf8(info.entry);
         // Find imports
@@ -124,6 +122,7 @@ namespace spade
         for (const auto &module: info.modules) {
             load_module(module);
         }
+        this->unit = null;
         return entry;
     }
 
@@ -173,6 +172,7 @@ namespace spade
 
         end_scope();
         end_sign_scope();
+        module->set_member_names(get_member_names());
         end_conpool_scope();
 
         if (const auto obj = get_scope()) {
@@ -211,23 +211,29 @@ namespace spade
             Exception exception(ex.start_pc, ex.end_pc, ex.target_pc, null, load_meta(ex.meta));
             exceptions.add_exception(exception);
         }
-        // Set line number info
-        LineNumberTable lines;
-        for (const auto &number: info.line_info.numbers) lines.add_line(number.times, number.lineno);
-        // Set matches
-        vector<MatchTable> matches;
-        for (const auto &info: info.matches) {
-            vector<Case> cases;
-            for (const auto &info: info.cases) {
-                cases.emplace_back(get_conpool()[info.value], info.location);
+        // Share the code and the tables with the other vms.
+        // The match tables referring to heap constants are built from the constants of this vm
+        const auto &image = unit->get_image(info);
+        auto matches = image.matches;
+        if (!matches) {
+            vector<MatchTable> tables;
+            for (const auto &info: info.matches) {
+                vector<Case> cases;
+                for (const auto &info: info.cases) {
+                    cases.emplace_back(get_conpool()[info.value], info.location);
+                }
+                tables.emplace_back(cases, info.default_location);
             }
-            matches.emplace_back(cases, info.default_location);
+            matches = std::make_shared<const vector<MatchTable>>(std::move(tables));
         }
         // Set metadata
         vm->set_metadata(sign.to_string(), load_meta(info.meta));
         // Create method
-        ObjMethod *method = halloc_mgr<ObjMethod>(vm->get_memory_manager(), kind, sign, info.code, info.stack_max, info.args_count, info.locals_count,
-                                                  exceptions, lines, matches);
+        const auto body = std::make_shared<MethodCode>(static_cast<uint32_t>(info.code.size()), image.code, info.stack_max, info.args_count,
+                                                       info.locals_count, exceptions, image.lines, matches);
+        ObjMethod *method = halloc_mgr<ObjMethod>(vm->get_memory_manager(), kind, sign, body);
+        // Intern the member names used by the code, so the member opcodes find the members by the interned string
+        load_member_names(info.code);
         // Set the method in the scope
         assert(get_scope()->get_tag() == OBJ_MODULE || get_scope()->get_tag() == OBJ_TYPE);
         get_scope()->set_member(name, method);
@@ -288,6 +294,8 @@ namespace spade
 
         end_scope();
         end_sign_scope();
+        // A type without static fields is complete once loaded, so its members are read without locking
+        type->freeze();
 
         assert(get_scope()->get_tag() == OBJ_MODULE);
         get_scope()->set_member(name, type);
@@ -296,10 +304,68 @@ namespace spade
         spdlog::info("Loader: Loaded type: {}", type->get_sign().to_string());
     }
 
+    void Loader::load_member_names(const vector<uint8_t> &code) {
+        auto &names = member_names_stack.back();
+        size_t i = 0;
+        const auto read_byte = [&] { return code[i++]; };
+        const auto read_short = [&] {
+            const uint16_t value = code[i] << 8 | code[i + 1];
+            i += 2;
+            return value;
+        };
+        while (i < code.size()) {
+            const auto opcode = static_cast<Opcode>(read_byte());
+            uint16_t index;
+            switch (OpcodeInfo::params_count(opcode)) {
+            case 0:
+                continue;
+            case 1:
+                index = read_byte();
+                break;
+            case 2:
+                index = read_short();
+                break;
+            default:
+                // Only closureload has variable params: the count, then the local index, the kind and the index of each capture
+                for (uint8_t count = read_byte(); count > 0; count--) {
+                    read_short();
+                    if (read_byte() == 0x00)
+                        read_byte();
+                    else
+                        read_short();
+                }
+                continue;
+            }
+            switch (opcode) {
+            case Opcode::MLOAD:
+            case Opcode::MFLOAD:
+            case Opcode::MSTORE:
+            case Opcode::MFSTORE:
+            case Opcode::PMSTORE:
+            case Opcode::PMFSTORE:
+            case Opcode::ATMLOAD:
+            case Opcode::ATMSTORE:
+            case Opcode::ATMCAS:
+            case Opcode::ATMADD:
+            case Opcode::ATMSUB:
+                break;
+            default:
+                continue;
+            }
+            if (names[index] == null) {
+                const auto name = Sign(get_conpool()[index].to_string()).get_name();
+                names[index] = vm->get_intern_table().intern(vm->get_memory_manager(), name);
+            }
+        }
+    }
+
     vector<Value> Loader::load_const_pool(const vector<CpInfo> &cps) {
         vector<Value> pool;
         for (const auto &cp: cps) {
-            pool.push_back(load_cp(cp));
+            // Constants are never modified, loading them copies the mutable ones
+            const auto value = load_cp(cp);
+            Obj::freeze(value);
+            pool.push_back(value);
         }
         spdlog::info("Loader: Loaded constant pool");
         return pool;
@@ -317,20 +383,11 @@ namespace spade
     Value Loader::load_cp(const CpInfo &cp) {
         const auto mgr = vm->get_memory_manager();
         switch (cp.tag) {
-        case 0x00:
-            return Value();
-        case 0x01:
-            return Value(true);
-        case 0x02:
-            return Value(false);
-        case 0x03:
-            return Value(static_cast<char>(std::get<uint32_t>(cp.value)));
-        case 0x04:
-            return Value(unsigned_to_signed(std::get<uint64_t>(cp.value)));
-        case 0x05:
-            return Value(raw_to_double(std::get<uint64_t>(cp.value)));
-        case 0x06:
-            return halloc_mgr<ObjString>(mgr, std::get<_UTF8>(cp.value).bytes.data(), std::get<_UTF8>(cp.value).len);
+        case 0x06: {
+            // String constants are interned, so that equal constants of all the modules share one string
+            const auto &utf8 = std::get<_UTF8>(cp.value);
+            return vm->get_intern_table().intern(mgr, std::string_view(reinterpret_cast<const char *>(utf8.bytes.data()), utf8.len));
+        }
         case 0x07: {
             const auto con = std::get<_Container>(cp.value);
             const auto array = halloc_mgr<ObjArray>(mgr, con.len);
@@ -340,6 +397,8 @@ namespace spade
             return array;
         }
         default:
+            if (const auto value = load_scalar_constant(cp))
+                return *value;
             throw Unreachable();
         }
         return null;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "callable/method.hpp"
+#include "code_cache.hpp"
 #include "elpops/elpdef.hpp"
 
 namespace spade
@@ -18,8 +19,12 @@ namespace spade
         std::vector<Obj *> scope_stack;
         std::vector<Sign> sign_stack;
         std::vector<std::vector<Value>> conpool_stack;
+        /// The interned member names of the constant pools in conpool_stack
+        std::vector<std::vector<const ObjString *>> member_names_stack;
 
         std::vector<Sign> module_init_signs;
+        /// The unit being loaded
+        const CodeUnit *unit = null;
 
       public:
         explicit Loader(SpadeVM *vm);
@@ -37,14 +42,16 @@ namespace spade
 
         void start_conpool_scope(const vector<Value> &conpool);
         const vector<Value> &get_conpool() const;
+        const vector<const ObjString *> &get_member_names() const;
         void end_conpool_scope();
 
         fs::path resolve_path(const fs::path &from_path, const fs::path &path);
 
-        string load_elp(const ElpInfo &info, const fs::path &path, std::vector<fs::path> &imports);
+        string load_elp(const CodeUnit &unit, const fs::path &path, std::vector<fs::path> &imports);
         void load_module(const ModuleInfo &info);
         void load_method(const MethodInfo &info);
         void load_class(const ClassInfo &info);
+        void load_member_names(const vector<uint8_t> &code);
 
         Table<string> load_meta(const MetaInfo &meta);
         vector<Value> load_const_pool(const vector<CpInfo> &cps);
@@ -1,5 +1,6 @@
 #include "ee/vm.hpp"
 #include "jit/jit.hpp"
+#include "memory/arena/arena_manager.hpp"
 #include "memory/basic/basic_manager.hpp"
 #include "spimp/utils.hpp"
 #include <iostream>
@@ -7,16 +8,41 @@
 
 using namespace spade;
 
-int main() {
-    spdlog::set_level(spdlog::level::trace);
-
-    basic::BasicMemoryManager mgr;
-    SpadeVM vm(&mgr);
+static void run(MemoryManager *manager) {
+    SpadeVM vm(manager);
     vm.start("../swan/res/hello.elp", {}, true);
     std::cout << "Output:\n";
     std::cout << vm.get_output();
 
     JitCompiler compiler(&vm);
     compiler.compile_symbol(cast<ObjMethod>(vm.get_symbol("hello.greet()").as_obj()));
+}
+
+int main(int argc, char **argv) {
+    spdlog::set_level(spdlog::level::trace);
+
+    // --arena runs the program on an arena which is released at once after the run,
+    // --arena-debug also checks that no object escapes the release
+    bool arena = false;
+    bool arena_debug = false;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (arg == "--arena")
+            arena = true;
+        else if (arg == "--arena-debug")
+            arena = arena_debug = true;
+    }
+
+    if (arena) {
+        arena::ArenaMemoryManager mgr(null, arena::ArenaMemoryManager::DEFAULT_CHUNK_SIZE, arena_debug);
+        const auto mark = mgr.mark();
+        run(&mgr);
+        // The vm is gone here, so everything the run allocated is released together
+        spdlog::info("Arena: allocated {} bytes, reserved {} bytes", mgr.get_allocated(), mgr.get_reserved());
+        mgr.reset(mark);
+    } else {
+        basic::BasicMemoryManager mgr;
+        run(&mgr);
+    }
     return 0;
 }
@@ -0,0 +1,157 @@
+#include "arena_manager.hpp"
+#include "ee/obj.hpp"
+#include "ee/vm.hpp"
+#include "utils/errors.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <unordered_set>
+
+namespace spade::arena
+{
+    static constexpr size_t align_up(size_t size) {
+        return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    }
+
+    ArenaMemoryManager::ArenaMemoryManager(SpadeVM *vm, size_t chunk_size, bool debug)
+        : MemoryManager(vm), chunk_size(chunk_size), debug(debug), chunks() {}
+
+    ArenaMemoryManager::~ArenaMemoryManager() {
+        release(Mark{});
+        for (const auto &chunk: chunks) std::free(chunk.memory);
+        chunks.clear();
+    }
+
+    void *ArenaMemoryManager::allocate(size_t size) {
+        const size_t block_size = align_up(sizeof(BlockHeader) + size);
+        if (block_size > UINT32_MAX)
+            return null;
+
+        std::lock_guard lk(mtx);
+        // Find a chunk which has enough space, chunks after the current one are empty
+        while (current < chunks.size() && chunks[current].size - chunks[current].used < block_size) current++;
+        if (current >= chunks.size()) {
+            // Big objects get a chunk of their own
+            const size_t size = std::max(chunk_size, block_size);
+            const auto memory = static_cast<uint8_t *>(std::malloc(size));
+            if (memory == null)
+                return null;
+            chunks.push_back(Chunk{.memory = memory, .size = size, .used = 0});
+            current = chunks.size() - 1;
+        }
+
+        auto &chunk = chunks[current];
+        const auto header = new (chunk.memory + chunk.used) BlockHeader{.size = static_cast<uint32_t>(block_size), .live = 0};
+        chunk.used += block_size;
+        allocated += block_size;
+        return header + 1;
+    }
+
+    void ArenaMemoryManager::post_allocation(Obj *obj) {
+        // Mark the block as live, so that the object is destroyed when it is released
+        (reinterpret_cast<BlockHeader *>(obj) - 1)->live = 1;
+    }
+
+    void ArenaMemoryManager::deallocate(void *pointer) {
+        // The object is already destroyed, the memory is reclaimed at the next reset
+        (static_cast<BlockHeader *>(pointer) - 1)->live = 0;
+    }
+
+    void ArenaMemoryManager::collect_garbage() {
+        // Nothing to do here, memory is released only at reset points
+    }
+
+    ArenaMemoryManager::Mark ArenaMemoryManager::mark() {
+        std::lock_guard lk(mtx);
+        if (chunks.empty())
+            return Mark{};
+        return Mark{.chunk = current, .offset = chunks[current].used};
+    }
+
+    void ArenaMemoryManager::reset(Mark mark) {
+        // The escapes are collected before taking the lock, the walk must not block the allocations
+        if (debug)
+            check_escapes(mark);
+
+        std::lock_guard lk(mtx);
+        release(mark);
+
+        for (size_t i = mark.chunk; i < chunks.size(); i++) {
+            auto &chunk = chunks[i];
+            const size_t start = i == mark.chunk ? mark.offset : 0;
+            if (debug)
+                // Poison the released memory so that dangling references are easy to spot
+                std::memset(chunk.memory + start, 0xDD, chunk.used - start);
+            allocated -= chunk.used - start;
+            chunk.used = start;
+        }
+        current = std::min(mark.chunk, chunks.size());
+        spdlog::trace("ArenaMemoryManager: Reset to chunk {} offset {}", mark.chunk, mark.offset);
+    }
+
+    size_t ArenaMemoryManager::get_reserved() const {
+        size_t reserved = 0;
+        for (const auto &chunk: chunks) reserved += chunk.size;
+        return reserved;
+    }
+
+    void ArenaMemoryManager::check_escapes(Mark mark) const {
+        if (vm == null)
+            return;
+
+        // Take the released ranges under the lock and walk the roots without it
+        std::vector<Range> ranges;
+        {
+            std::lock_guard lk(mtx);
+            for (size_t i = mark.chunk; i < chunks.size(); i++) {
+                const auto &chunk = chunks[i];
+                const size_t start = i == mark.chunk ? mark.offset : 0;
+                ranges.emplace_back(chunk.memory + start, chunk.memory + chunk.used);
+            }
+        }
+
+        size_t escaped = 0;
+        std::unordered_set<const Obj *> visited;
+        std::vector<const Obj *> work_list;
+        vm->for_each_root([&](Obj *root) { work_list.push_back(root); });
+        while (!work_list.empty()) {
+            const auto obj = work_list.back();
+            work_list.pop_back();
+            if (obj == null || !visited.insert(obj).second)
+                continue;
+            if (is_released(ranges, obj)) {
+                spdlog::error("ArenaMemoryManager: object escaped reset: {}", obj->to_string());
+                escaped++;
+                // Do not walk the escaped object, its references are released too
+                continue;
+            }
+            obj->for_each_reference([&](Obj *ref) { work_list.push_back(ref); });
+        }
+        if (escaped > 0)
+            throw EscapeError(escaped);
+    }
+
+    void ArenaMemoryManager::release(Mark mark) {
+        for (size_t i = mark.chunk; i < chunks.size(); i++) {
+            const auto &chunk = chunks[i];
+            size_t offset = i == mark.chunk ? mark.offset : 0;
+            while (offset < chunk.used) {
+                const auto header = reinterpret_cast<BlockHeader *>(chunk.memory + offset);
+                if (header->live) {
+                    header->live = 0;
+                    Obj::destroy(reinterpret_cast<Obj *>(header + 1));
+                }
+                offset += header->size;
+            }
+        }
+    }
+
+    bool ArenaMemoryManager::is_released(const std::vector<Range> &ranges, const void *pointer) {
+        const auto address = static_cast<const uint8_t *>(pointer);
+        for (const auto &[start, end]: ranges)
+            if (start <= address && address < end)
+                return true;
+        return false;
+    }
+}    // namespace spade::arena
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "memory/manager.hpp"
+#include "utils/common.hpp"
+#include <mutex>
+#include <vector>
+
+namespace spade::arena
+{
+    /**
+     * A region based memory manager which allocates objects linearly from large chunks.
+     * Individual objects are never freed, instead all the objects allocated after a
+     * certain point are released together either at the reset points or when the manager is destroyed.
+     * This is suitable for short-lived executions (run a script, produce output and exit)
+     * where per object free is pure waste.
+     *
+     * In debug mode, the manager checks whether any object which is going to be released
+     * is still reachable from the vm roots at the time of reset.
+     */
+    class SWAN_EXPORT ArenaMemoryManager final : public MemoryManager {
+      public:
+        /**
+         * Represents a position in the arena
+         */
+        struct Mark {
+            size_t chunk = 0;
+            size_t offset = 0;
+        };
+
+        /// Default size of a chunk in bytes
+        static constexpr const size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+      private:
+        struct alignas(16) BlockHeader {
+            /// Size of the block including the header
+            uint32_t size;
+            /// Whether the block holds a constructed object
+            uint32_t live;
+        };
+
+        /// A range of the released memory, from the first byte to the end
+        using Range = std::pair<const uint8_t *, const uint8_t *>;
+
+        struct Chunk {
+            uint8_t *memory;
+            size_t size;
+            size_t used;
+        };
+
+        /// Size of a new chunk
+        size_t chunk_size;
+        /// Whether the manager is in debug mode
+        bool debug;
+        /// The chunks of the arena
+        std::vector<Chunk> chunks;
+        /// Index of the chunk being allocated from
+        size_t current = 0;
+        /// Total number of bytes allocated since the last reset
+        size_t allocated = 0;
+        mutable std::mutex mtx;
+
+      public:
+        ArenaMemoryManager(SpadeVM *vm = null, size_t chunk_size = DEFAULT_CHUNK_SIZE, bool debug = false);
+
+        ArenaMemoryManager(const ArenaMemoryManager &) = delete;
+        ArenaMemoryManager(ArenaMemoryManager &&) = delete;
+        ArenaMemoryManager &operator=(const ArenaMemoryManager &) = delete;
+        ArenaMemoryManager &operator=(ArenaMemoryManager &&) = delete;
+        ~ArenaMemoryManager();
+
+        void *allocate(size_t size);
+        void post_allocation(Obj *obj);
+        void deallocate(void *pointer);
+        void collect_garbage();
+
+        /**
+         * @return the current position of the arena which can be used with reset
+         */
+        Mark mark();
+
+        /**
+         * Releases all the objects allocated after @p mark.
+         * The chunks are kept and reused by the next allocations.
+         * This must not be called while a vm thread is executing.
+         * @throws EscapeError in debug mode, if any released object is still reachable from the vm roots
+         * @param mark the position to rewind the arena to
+         */
+        void reset(Mark mark);
+
+        /**
+         * Releases all the objects of the arena
+         */
+        void reset() {
+            reset(Mark{});
+        }
+
+        /**
+         * @return whether the manager is in debug mode
+         */
+        bool is_debug() const {
+            return debug;
+        }
+
+        /**
+         * @return the total number of bytes allocated since the last reset
+         */
+        size_t get_allocated() const {
+            return allocated;
+        }
+
+        /**
+         * @return the total number of bytes reserved by the arena
+         */
+        size_t get_reserved() const;
+
+      private:
+        void check_escapes(Mark mark) const;
+        void release(Mark mark);
+        static bool is_released(const std::vector<Range> &ranges, const void *pointer);
+    };
+}    // namespace spade::arena
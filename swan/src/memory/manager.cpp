@@ -1,12 +1,38 @@
 #include "manager.hpp"
 #include "ee/thread.hpp"
 #include "ee/vm.hpp"
+#include "utils/errors.hpp"
+#include <atomic>
+#include <mutex>
 
 namespace spade
 {
+    /// The heap registry, the slot 0 is never used so that a zero heap id means no heap
+    static std::atomic<MemoryManager *> heaps[MemoryManager::MAX_HEAPS];
+    static std::mutex heaps_mtx;
+
+    MemoryManager::MemoryManager(SpadeVM *vm) : vm(vm), heap_id(0) {
+        std::lock_guard lk(heaps_mtx);
+        for (size_t i = 1; i < MAX_HEAPS; i++) {
+            if (heaps[i].load(std::memory_order_relaxed) == null) {
+                heap_id = static_cast<uint16_t>(i);
+                heaps[i].store(this, std::memory_order_release);
+                return;
+            }
+        }
+        throw FatalError(std::format("cannot create more than {} memory managers", MAX_HEAPS - 1));
+    }
+
+    MemoryManager::~MemoryManager() {
+        std::lock_guard lk(heaps_mtx);
+        heaps[heap_id].store(null, std::memory_order_release);
+    }
+
+    MemoryManager *MemoryManager::get_heap(uint16_t heap_id) {
+        return heaps[heap_id].load(std::memory_order_acquire);
+    }
+
     MemoryManager *MemoryManager::current() {
-        if (const auto thread = Thread::current())
-            return thread->get_vm()->get_memory_manager();
-        return null;
+        return Thread::get_context().manager;
     }
 }    // namespace spade
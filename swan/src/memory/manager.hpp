@@ -6,15 +6,30 @@ namespace spade
 {
     class SpadeVM;
     class Obj;
+    class AllocationProfiler;
 
     class MemoryManager {
+      public:
+        /// Number of bits of a heap id in the header of an object
+        static constexpr const size_t HEAP_ID_BITS = 11;
+        /// Number of heap ids, the id zero is never used so MAX_HEAPS - 1 managers can exist at a time
+        static constexpr const size_t MAX_HEAPS = size_t{1} << HEAP_ID_BITS;
+
       protected:
         SpadeVM *vm;
+        /// The allocation profiler, null if profiling is disabled
+        AllocationProfiler *profiler = null;
+        /// Id of the heap managed by this manager, the objects store it instead of a pointer to the manager
+        uint16_t heap_id;
 
-        MemoryManager(SpadeVM *vm) : vm(vm) {}
+        /**
+         * Registers the manager in the heap registry
+         * @throws FatalError if there are already MAX_HEAPS - 1 managers
+         */
+        SWAN_EXPORT MemoryManager(SpadeVM *vm);
 
       public:
-        SWAN_EXPORT virtual ~MemoryManager() = default;
+        SWAN_EXPORT virtual ~MemoryManager();
 
         /**
          * Allocates a block of memory
@@ -53,6 +68,32 @@ namespace spade
             return vm;
         }
 
+        /**
+         * Sets the allocation profiler which records every allocation done by this manager.
+         * The profiler is not owned by the manager
+         * @param profiler_ the profiler, null disables profiling
+         */
+        SWAN_EXPORT void set_profiler(AllocationProfiler *profiler_) {
+            profiler = profiler_;
+        }
+
+        SWAN_EXPORT AllocationProfiler *get_profiler() const {
+            return profiler;
+        }
+
+        /**
+         * @return the id of the heap managed by this manager, which is never zero
+         */
+        SWAN_EXPORT uint16_t get_heap_id() const {
+            return heap_id;
+        }
+
+        /**
+         * @param heap_id the id of the heap
+         * @return the manager of the heap with @p heap_id, null if there is no such heap
+         */
+        SWAN_EXPORT static MemoryManager *get_heap(uint16_t heap_id);
+
         /**
          * @return the current memory manager respective to the current vm
          */
@@ -3,6 +3,7 @@
 #include "ee/obj.hpp"
 #include "utils/errors.hpp"
 #include "manager.hpp"
+#include "profiler.hpp"
 #include <memory>
 
 namespace spade
@@ -12,6 +13,8 @@ namespace spade
      * specified with @p args . If the current manager is null, throws ArgumentError.
      * Sets the manager of the object and calls spade::MemoryManager::post_allocation
      * on the object and returns the final object thus created.
+     * The allocation is recorded by the profiler of the manager if there is any,
+     * along with the payload size of the object as reported by spade::Obj::size_of.
      * @throws ArgumentError if manager is null whatsoever
      * @throws MemoryError if allocation fails
      * @tparam T type of the object
@@ -30,8 +33,10 @@ namespace spade
         if (memory == null)
             throw MemoryError(sizeof(T));
         Obj *obj = new (memory) T(args...);
-        obj->get_info().manager = manager;
+        obj->set_manager(manager);
         manager->post_allocation(obj);
+        if (const auto profiler = manager->get_profiler())
+            profiler->record(obj, Obj::size_of(obj));
         return (T *) obj;
     }
 
@@ -41,6 +46,8 @@ namespace spade
      * memory manager of the thread. Still if the manager is null, throws ArgumentError.
      * Sets the manager of the object and calls spade::MemoryManager::post_allocation
      * on the object and returns the final object thus created.
+     * The allocation is recorded by the profiler of the manager if there is any,
+     * along with the payload size of the object as reported by spade::Obj::size_of.
      * @throws ArgumentError if manager is null whatsoever
      * @throws MemoryError if allocation fails
      * @tparam T type of the object
@@ -61,8 +68,10 @@ namespace spade
         if (memory == null)
             throw MemoryError(sizeof(T));
         Obj *obj = new (memory) T(std::forward<Args>(args)...);
-        obj->get_info().manager = manager;
+        obj->set_manager(manager);
         manager->post_allocation(obj);
+        if (const auto profiler = manager->get_profiler())
+            profiler->record(obj, Obj::size_of(obj));
         return (T *) obj;
     }
 
@@ -71,8 +80,8 @@ namespace spade
      * @param obj the object to be freed
      */
     SWAN_EXPORT inline void hfree(Obj *obj) {
-        auto manager = obj->get_info().manager;
-        std::destroy_at(obj);
+        auto manager = obj->get_manager();
+        Obj::destroy(obj);
         manager->deallocate(obj);
     }
 }    // namespace spade
@@ -0,0 +1,120 @@
+#include "profiler.hpp"
+#include "callable/method.hpp"
+#include "ee/thread.hpp"
+#include "utils/errors.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace spade
+{
+    static uint64_t source_line(const Frame &frame) {
+        // pc points to the next instruction, so the current instruction is before it
+        const uint32_t pc = frame.pc > 0 ? frame.pc - 1 : 0;
+        try {
+            return frame.get_method()->get_lines().get_source_line(pc);
+        } catch (const IllegalAccessError &) {
+            return 0;
+        }
+    }
+
+    AllocationProfiler::AllocationProfiler(size_t sample_interval)
+        : sample_interval(sample_interval), bytes_until_sample(sample_interval) {}
+
+    void AllocationProfiler::record(const Obj *obj, size_t size) {
+        total_bytes += size;
+        total_count++;
+
+        // Estimated number of bytes represented by this allocation
+        size_t weight = size;
+        if (sample_interval > 0) {
+            const auto interval = static_cast<int64_t>(sample_interval);
+            auto current = bytes_until_sample.load(std::memory_order_relaxed);
+            // Number of sample points crossed by this allocation, a large allocation can cross several of them
+            int64_t crossed;
+            do {
+                const auto remaining = current - static_cast<int64_t>(size);
+                crossed = remaining > 0 ? 0 : -remaining / interval + 1;
+            } while (!bytes_until_sample.compare_exchange_weak(current, current - static_cast<int64_t>(size) + crossed * interval,
+                                                               std::memory_order_relaxed));
+            if (crossed == 0)
+                return;
+            // Each sample point stands for the interval before it, so the sampled weights add up to the allocated bytes
+            weight = static_cast<size_t>(crossed) * sample_interval;
+        }
+        const size_t count = std::max<size_t>(weight / std::max<size_t>(size, 1), 1);
+
+        const auto tag = obj->get_tag();
+        const auto type = obj->get_type() ? obj->get_type()->get_sign().to_string() : tag_to_string(tag);
+
+        string method = "<native>";
+        uint32_t pc = 0;
+        uint64_t line = 0;
+        string stack;
+        if (const auto thread = Thread::current(); thread != null) {
+            const auto &state = thread->get_state();
+            if (const auto depth = state.get_call_stack_size(); depth > 0) {
+                const auto call_stack = state.get_call_stack();
+                for (uint16_t i = 0; i < depth; i++) {
+                    const auto &frame = call_stack[i];
+                    stack += std::format("{}:{};", frame.get_method()->get_sign().to_string(), source_line(frame));
+                }
+                const auto &frame = call_stack[depth - 1];
+                method = frame.get_method()->get_sign().to_string();
+                pc = frame.pc;
+                line = source_line(frame);
+            }
+        }
+        stack += std::format("[{}]", type);
+
+        std::lock_guard lk(mtx);
+        auto &entry = entries[std::format("{}|{}|{}|{}", (int) tag, type, method, pc)];
+        if (entry.count == 0) {
+            entry.tag = tag;
+            entry.type = type;
+            entry.method = method;
+            entry.pc = pc;
+            entry.line = line;
+        }
+        entry.bytes += weight;
+        entry.count += count;
+        stacks[stack] += weight;
+    }
+
+    string AllocationProfiler::report(size_t top) const {
+        std::vector<Entry> sorted;
+        {
+            std::lock_guard lk(mtx);
+            sorted.reserve(entries.size());
+            for (const auto &[_, entry]: entries) sorted.push_back(entry);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const Entry &lhs, const Entry &rhs) { return lhs.bytes > rhs.bytes; });
+        if (sorted.size() > top)
+            sorted.resize(top);
+
+        string result = std::format("allocated {} bytes in {} objects", get_total_bytes(), get_total_count());
+        if (sample_interval > 0)
+            result += std::format(" (sampled every {} bytes)", sample_interval);
+        result += std::format("\n{:>12} {:>10}  {:<8} {:<32} {}\n", "bytes", "count", "kind", "type", "site");
+        for (const auto &entry: sorted) {
+            result += std::format("{:>12} {:>10}  {:<8} {:<32} {}:{} (pc={})\n", entry.bytes, entry.count, tag_to_string(entry.tag),
+                                  entry.type, entry.method, entry.line, entry.pc);
+        }
+        return result;
+    }
+
+    string AllocationProfiler::folded_stacks() const {
+        std::lock_guard lk(mtx);
+        string result;
+        for (const auto &[stack, bytes]: stacks) result += std::format("{} {}\n", stack, bytes);
+        return result;
+    }
+
+    void AllocationProfiler::clear() {
+        std::lock_guard lk(mtx);
+        entries.clear();
+        stacks.clear();
+        total_bytes = 0;
+        total_count = 0;
+        bytes_until_sample = sample_interval;
+    }
+}    // namespace spade
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ee/obj.hpp"
+#include "utils/common.hpp"
+#include <atomic>
+#include <mutex>
+
+namespace spade
+{
+    /**
+     * Records the allocations done by a memory manager and attributes them to
+     * the kind of the object, its type and the allocation site (method, pc and source line).
+     * The profiler can sample allocations, in which case only one allocation is recorded per
+     * `sample_interval` bytes and the recorded values are scaled to estimate the total.
+     * An allocation larger than the interval is weighted by every interval it spans.
+     */
+    class SWAN_EXPORT AllocationProfiler {
+        struct Entry {
+            ObjTag tag;
+            string type;
+            string method;
+            uint32_t pc;
+            uint64_t line;
+            size_t bytes = 0;
+            size_t count = 0;
+        };
+
+        /// Number of bytes between two samples (0 records every allocation)
+        size_t sample_interval;
+        /// Number of bytes left until the next sample
+        std::atomic<int64_t> bytes_until_sample;
+        /// Total number of bytes allocated (including the unsampled allocations)
+        std::atomic_size_t total_bytes = 0;
+        /// Total number of allocations (including the unsampled allocations)
+        std::atomic_size_t total_count = 0;
+        /// The recorded allocation sites
+        Table<Entry> entries;
+        /// The recorded folded stacks with the number of bytes allocated
+        Table<size_t> stacks;
+        mutable std::mutex mtx;
+
+      public:
+        /**
+         * @param sample_interval number of bytes between two samples, 0 records every allocation
+         */
+        AllocationProfiler(size_t sample_interval = 0);
+
+        AllocationProfiler(const AllocationProfiler &) = delete;
+        AllocationProfiler(AllocationProfiler &&) = delete;
+        AllocationProfiler &operator=(const AllocationProfiler &) = delete;
+        AllocationProfiler &operator=(AllocationProfiler &&) = delete;
+        ~AllocationProfiler() = default;
+
+        /**
+         * Records the allocation of @p obj. This is called by spade::halloc
+         * and spade::halloc_mgr just after the allocation
+         * @param obj the allocated object
+         * @param size the size of the object in bytes
+         */
+        void record(const Obj *obj, size_t size);
+
+        /**
+         * @param top the number of entries to be reported
+         * @return the report of the top allocation sites sorted by the number of bytes allocated
+         */
+        string report(size_t top = 20) const;
+
+        /**
+         * Returns the recorded stacks in folded format, one stack per line,
+         * the frames are separated by ';' and followed by the number of bytes.
+         * The output can be fed directly to flamegraph tools
+         * @return the folded stacks
+         */
+        string folded_stacks() const;
+
+        /**
+         * Clears all the recorded data
+         */
+        void clear();
+
+        size_t get_sample_interval() const {
+            return sample_interval;
+        }
+
+        size_t get_total_bytes() const {
+            return total_bytes;
+        }
+
+        size_t get_total_count() const {
+            return total_count;
+        }
+    };
+}    // namespace spade
@@ -0,0 +1,59 @@
+#include "snapshot.hpp"
+#include "ee/vm.hpp"
+#include "spimp/error.hpp"
+#include "spimp/utils.hpp"
+#include <fstream>
+#include <unordered_set>
+
+namespace spade
+{
+    void HeapSnapshotWriter::write(std::ostream &out) const {
+        out << MAGIC << ' ' << VERSION << '\n';
+
+        std::unordered_set<const Obj *> visited;
+        vector<const Obj *> roots;
+        vector<const Obj *> work_list;
+        vm->for_each_root([&](Obj *root) {
+            roots.push_back(root);
+            work_list.push_back(root);
+        });
+
+        vector<const Obj *> refs;
+        while (!work_list.empty()) {
+            const auto obj = work_list.back();
+            work_list.pop_back();
+            if (obj == null || !visited.insert(obj).second)
+                continue;
+
+            refs.clear();
+            obj->for_each_reference([&](Obj *ref) {
+                if (ref == null)
+                    return;
+                refs.push_back(ref);
+                work_list.push_back(ref);
+            });
+
+            const auto type = obj->get_type() ? obj->get_type()->get_sign().to_string() : tag_to_string(obj->get_tag());
+            out << std::format("obj {} {} {} {}", static_cast<const void *>(obj), tag_to_string(obj->get_tag()), shallow_size(obj),
+                               refs.size());
+            for (const auto ref: refs) out << ' ' << static_cast<const void *>(ref);
+            out << ' ' << type << '\n';
+        }
+
+        std::unordered_set<const Obj *> written_roots;
+        for (const auto root: roots)
+            if (root != null && written_roots.insert(root).second)
+                out << "root " << static_cast<const void *>(root) << '\n';
+    }
+
+    void HeapSnapshotWriter::write(const fs::path &path) const {
+        std::ofstream out(path);
+        if (!out)
+            throw FileNotFoundError(path.string());
+        write(out);
+    }
+
+    size_t HeapSnapshotWriter::shallow_size(const Obj *obj) {
+        return Obj::size_of(obj);
+    }
+}    // namespace spade
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ee/obj.hpp"
+#include "utils/common.hpp"
+#include <ostream>
+
+namespace spade
+{
+    class SpadeVM;
+
+    /**
+     * Writes a snapshot of all the objects reachable from the roots of a vm.
+     * The snapshot is a text file with one record per line:
+     *
+     *     swan-heap-snapshot <version>
+     *     obj <id> <kind> <size> <ref-count> <ref-id>... <type>
+     *     root <id>
+     *
+     * where id is a unique identifier of the object in the snapshot, kind is the name of the object tag,
+     * type is the signature of the type of the object (or the kind if the object has no type) and
+     * size is the shallow size of the object in bytes. The type is the last field of the line since
+     * a signature can contain spaces.
+     * The snapshot can be analyzed offline by the heapdiff tool.
+     */
+    class SWAN_EXPORT HeapSnapshotWriter {
+        const SpadeVM *vm;
+
+      public:
+        /// The first word of every snapshot file
+        static constexpr const char *MAGIC = "swan-heap-snapshot";
+        /// The version of the snapshot format
+        static constexpr const int VERSION = 2;
+
+        explicit HeapSnapshotWriter(const SpadeVM *vm) : vm(vm) {}
+
+        /**
+         * Writes the snapshot to @p out.
+         * The vm threads must be stopped while the snapshot is being written
+         * @param out the output stream
+         */
+        void write(std::ostream &out) const;
+
+        /**
+         * Writes the snapshot to the file at @p path
+         * @throws FileNotFoundError if the file cannot be opened
+         * @param path the path of the snapshot file
+         */
+        void write(const fs::path &path) const;
+
+        /**
+         * @param obj the object
+         * @return the approximate number of bytes occupied by the object itself (excluding the referenced objects)
+         */
+        static size_t shallow_size(const Obj *obj);
+    };
+}    // namespace spade
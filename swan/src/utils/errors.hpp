@@ -33,6 +33,21 @@ namespace spade
         explicit MemoryError(size_t size) : FatalError(std::format("failed to allocate memory: {} bytes", size)) {}
     };
 
+    class SWAN_EXPORT EscapeError : public FatalError {
+      public:
+        explicit EscapeError(size_t count) : FatalError(std::format("{} object(s) escaped the memory region being released", count)) {}
+    };
+
+    class SWAN_EXPORT IllegalMonitorStateError : public FatalError {
+      public:
+        IllegalMonitorStateError() : FatalError("current thread does not own the monitor") {}
+    };
+
+    class SWAN_EXPORT IllegalGeneratorStateError : public FatalError {
+      public:
+        explicit IllegalGeneratorStateError(const string &message) : FatalError(message) {}
+    };
+
     class SWAN_EXPORT IllegalAccessError : public FatalError {
       public:
         explicit IllegalAccessError(const string &message) : FatalError(message) {}
@@ -46,6 +61,16 @@ namespace spade
             : IllegalAccessError(std::format("index out of bounds: {} ({})", index, index_of)) {}
     };
 
+    class SWAN_EXPORT KeyError : public IllegalAccessError {
+      public:
+        explicit KeyError(const string &key) : IllegalAccessError(std::format("key not found: {}", key)) {}
+    };
+
+    class SWAN_EXPORT FrozenObjectError : public IllegalAccessError {
+      public:
+        explicit FrozenObjectError(const string &object) : IllegalAccessError(std::format("cannot modify frozen object: {}", object)) {}
+    };
+
     class SWAN_EXPORT IllegalTypeParamAccessError : public FatalError {
       public:
         explicit IllegalTypeParamAccessError(const string &sign) : FatalError(std::format("tried to access empty type parameter: '{}'", sign)) {}
@@ -69,6 +94,11 @@ namespace spade
         explicit StackOverflowError() : FatalError("bad state: stack overflow") {}
     };
 
+    class SWAN_EXPORT IntegerOverflowError : public FatalError {
+      public:
+        explicit IntegerOverflowError(const string &message) : FatalError(message) {}
+    };
+
     class SWAN_EXPORT ArgumentError : public FatalError {
       public:
         ArgumentError(const string &sign, const string &msg) : FatalError(std::format("{}: {}", sign, msg)) {}